@@ -0,0 +1,16 @@
+# Benchmark suite: times the engine over a fixed set of seeded patterns, variants and thread counts,
+# reporting the median & 95th percentile, and flagging regressions against a saved baseline
+
+QT = core concurrent
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = conwaylife-benchmark
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../engine.pri)
+
+SOURCES += \
+    main.cpp
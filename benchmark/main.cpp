@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <cmath>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+#include "lifeengine.h"
+#include "lifenuma.h"
+
+// time the engine over every combination of pattern x variant x thread count, each from the same seeded start,
+// so that runs are reproducible and comparable from one build to the next
+// each case is run `warmup` times untimed, then `repetitions` times timed, and the median & 95th percentile reported
+// results can be saved as a baseline, and a later run compared against it to flag regressions
+// for the banded worker pool variants, the percentage of the board's pages on another node than the worker generating them is reported too,
+// comparing the ordinary pool (boards placed by the main thread) against the NUMA-local pool (see `LifeEngine::ThreadsNumaWorkerPool`)
+// the recording variants record the history of every generation to a log in the temporary directory, to compare with the same variants not recording
+
+// a starting pattern: a seeded random soup, a formation tiled across the board, or an empty/full board
+struct Pattern {
+    QString name;
+    double density;
+    const LifeEngine::Formation *formation;
+};
+
+// a runtime engine variant (the board layout is a compile-time choice, see `LifeEngine::boardLayoutName()`)
+struct Variant {
+    QString name;
+    LifeEngine::Backend backend;
+    LifeEngine::ThreadMode threadMode;
+    LifeEngine::PartitionMode partitionMode;
+    bool activeRegions;
+    // the generations each tile is advanced at a time (1 if not temporally blocked)
+    int blockGenerations = 1;
+    // whether every generation is recorded to a history log
+    bool recordHistory = false;
+};
+
+static QString boardVariantName()
+{
+#if BOARD_BIT_PACKED
+    return QString("%1 (%2)").arg(LifeEngine::boardLayoutName(), BitBoard::kernelName(BitBoard::kernel()));
+#else
+    return LifeEngine::boardLayoutName();
+#endif
+}
+
+static QVector<Pattern> allPatterns()
+{
+    // soups at several densities, every built-in formation, and the empty & full boards
+    QVector<Pattern> patterns;
+    for (int percent : { 10, 25, 50 })
+        patterns.append({ QString("soup-%1").arg(percent), percent / 100.0, nullptr });
+    for (const LifeEngine::CategoryFormations &category : LifeEngine::formationCategories())
+        for (const LifeEngine::Formation &formation : category.formations)
+            patterns.append({ formation.name.toLower().replace(' ', '-'), 0, &formation });
+    patterns.append({ "empty", 0, nullptr });
+    patterns.append({ "full", 1, nullptr });
+    return patterns;
+}
+
+static QVector<Variant> allVariants()
+{
+    // the board without threads, each thread mode x partition mode (with or without active regions only), the NUMA-local pool,
+    // temporal blocking without threads & in the worker pool, recording history without threads & in the banded worker pool, and the other backends
+    static const QStringList threadModeNames = { "none", "qtconcurrent", "qthreads", "pool", "numa" };
+    static const QStringList partitionNames = { "interleaved", "banded", "tiled" };
+    QVector<Variant> variants;
+    variants.append({ "serial", LifeEngine::BackendBoard, LifeEngine::ThreadsNone, LifeEngine::PartitionInterleaved, false });
+    variants.append({ "serial-active", LifeEngine::BackendBoard, LifeEngine::ThreadsNone, LifeEngine::PartitionInterleaved, true });
+    for (int mode = LifeEngine::ThreadsQtConcurrent; mode <= LifeEngine::ThreadsWorkerPool; mode++)
+        for (int partition = LifeEngine::PartitionInterleaved; partition <= LifeEngine::PartitionTiled; partition++)
+            for (bool activeRegions : { false, true })
+                variants.append({ QString("%1-%2%3").arg(threadModeNames[mode], partitionNames[partition], activeRegions ? "-active" : ""),
+                                  LifeEngine::BackendBoard, LifeEngine::ThreadMode(mode), LifeEngine::PartitionMode(partition), activeRegions });
+    // (the NUMA-local pool is always banded)
+    for (bool activeRegions : { false, true })
+        variants.append({ QString("%1-%2%3").arg(threadModeNames[LifeEngine::ThreadsNumaWorkerPool], partitionNames[LifeEngine::PartitionBanded], activeRegions ? "-active" : ""),
+                          LifeEngine::BackendBoard, LifeEngine::ThreadsNumaWorkerPool, LifeEngine::PartitionBanded, activeRegions });
+    variants.append({ "serial-temporal", LifeEngine::BackendBoard, LifeEngine::ThreadsNone, LifeEngine::PartitionInterleaved, false,
+                      LifeEngine::defaultTemporalBlockGenerations });
+    variants.append({ "pool-temporal", LifeEngine::BackendBoard, LifeEngine::ThreadsWorkerPool, LifeEngine::PartitionInterleaved, false,
+                      LifeEngine::defaultTemporalBlockGenerations });
+    variants.append({ "serial-record", LifeEngine::BackendBoard, LifeEngine::ThreadsNone, LifeEngine::PartitionInterleaved, false, 1, true });
+    variants.append({ "pool-banded-record", LifeEngine::BackendBoard, LifeEngine::ThreadsWorkerPool, LifeEngine::PartitionBanded, false, 1, true });
+    variants.append({ "hashlife", LifeEngine::BackendHashLife, LifeEngine::ThreadsNone, LifeEngine::PartitionInterleaved, false });
+    variants.append({ "unbounded", LifeEngine::BackendUnbounded, LifeEngine::ThreadsNone, LifeEngine::PartitionInterleaved, false });
+    return variants;
+}
+
+static void setUpPattern(LifeEngine &engine, const Pattern &pattern, quint32 seed)
+{
+    // set the board to `pattern`, always from the same `seed`
+    if (pattern.formation == nullptr)
+    {
+        engine.randomize(seed, pattern.density);
+        return;
+    }
+    // tile the formation across the board, so that there is a comparable amount of work for every formation
+    static constexpr int spacing = 64;
+    engine.newBoard();
+    for (int y = spacing / 2; y < engine.boardSize(); y += spacing)
+        for (int x = spacing / 2; x < engine.boardSize(); x += spacing)
+            engine.placeFormation(*pattern.formation, y, x);
+}
+
+static double percentile(QVector<double> samples, double fraction)
+{
+    // return the nearest-rank percentile of `samples`
+    Q_ASSERT(!samples.isEmpty());
+    std::sort(samples.begin(), samples.end());
+    int rank = qBound(1, int(std::ceil(fraction * samples.count())), samples.count());
+    return samples[rank - 1];
+}
+
+static QList<int> parseIntList(const QString &value, bool &ok)
+{
+    // parse a comma-separated list of positive integers
+    QList<int> list;
+    ok = true;
+    for (const QString &item : value.split(',', Qt::SkipEmptyParts))
+    {
+        int i = item.trimmed().toInt(&ok);
+        if (!ok || i <= 0)
+        {
+            ok = false;
+            return list;
+        }
+        list.append(i);
+    }
+    ok = !list.isEmpty();
+    return list;
+}
+
+template<typename T> static bool selectByName(const QVector<T> &all, const QString &names, QVector<T> &selected)
+{
+    // set `selected` to the items of `all` named in the comma-separated `names` (or all of them for "all")
+    if (names == "all")
+    {
+        selected = all;
+        return true;
+    }
+    for (const QString &name : names.split(',', Qt::SkipEmptyParts))
+    {
+        auto it = std::find_if(all.begin(), all.end(), [&name](const T &item)->bool { return item.name == name.trimmed(); });
+        if (it == all.end())
+            return false;
+        selected.append(*it);
+    }
+    return !selected.isEmpty();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("conwaylife-benchmark");
+
+    const QVector<Pattern> patterns(allPatterns());
+    const QVector<Variant> variants(allVariants());
+    QStringList patternNames, variantNames;
+    for (const Pattern &pattern : patterns)
+        patternNames.append(pattern.name);
+    for (const Variant &variant : variants)
+        variantNames.append(variant.name);
+    QList<int> defaultThreadCounts;
+    for (int threadCount = 1; threadCount < QThread::idealThreadCount(); threadCount *= 2)
+        defaultThreadCounts.append(threadCount);
+    defaultThreadCounts.append(QThread::idealThreadCount());
+    QStringList defaultThreadCountsText;
+    for (int threadCount : defaultThreadCounts)
+        defaultThreadCountsText.append(QString::number(threadCount));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark Conway's Game of Life over fixed seeded patterns, engine variants and thread counts");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size, in cells along each side (default 1000).", "cells", "1000");
+    QCommandLineOption generationsOption("generations", "Generations per repetition (default 100).", "n", "100");
+    QCommandLineOption warmupOption("warmup", "Untimed repetitions before the timed ones (default 1).", "n", "1");
+    QCommandLineOption repetitionsOption("repetitions", "Timed repetitions (default 5).", "n", "5");
+    QCommandLineOption seedOption("seed", "Random seed for the soups (default 1).", "seed", "1");
+    QCommandLineOption threadsOption("threads", "Comma-separated thread counts for the threaded variants.", "list", defaultThreadCountsText.join(','));
+    QCommandLineOption patternsOption("patterns", QString("Comma-separated patterns, or \"all\": %1 (default all).").arg(patternNames.join(", ")), "list", "all");
+    QCommandLineOption variantsOption("variants", QString("Comma-separated variants, or \"all\": %1.").arg(variantNames.join(", ")), "list",
+                                      "serial,serial-temporal,serial-record,qtconcurrent-banded,pool-banded,pool-tiled,pool-banded-active,pool-temporal,"
+                                      "pool-banded-record,numa-banded,hashlife,unbounded");
+    QCommandLineOption ruleOption("rule", "Life-like rule in B/S notation (default B3/S23).", "rule", "B3/S23");
+    QCommandLineOption baselineOption("baseline", "Compare against the results saved in this baseline file.", "file");
+    QCommandLineOption saveBaselineOption("save-baseline", "Save the results to this baseline file.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Percentage slower than the baseline median to flag as a regression (default 10).", "percent", "10");
+    parser.addOptions({ sizeOption, generationsOption, warmupOption, repetitionsOption, seedOption, threadsOption,
+                        patternsOption, variantsOption, ruleOption, baselineOption, saveBaselineOption, toleranceOption });
+    parser.process(a);
+
+    QTextStream out(stdout), err(stderr);
+    bool ok1, ok2, ok3, ok4, ok5, ok6, ok7;
+    int size = parser.value(sizeOption).toInt(&ok1);
+    int generations = parser.value(generationsOption).toInt(&ok2);
+    int warmup = parser.value(warmupOption).toInt(&ok3);
+    int repetitions = parser.value(repetitionsOption).toInt(&ok4);
+    quint32 seed = parser.value(seedOption).toUInt(&ok5);
+    double tolerance = parser.value(toleranceOption).toDouble(&ok6);
+    QList<int> threadCounts = parseIntList(parser.value(threadsOption), ok7);
+    if (!ok1 || !ok2 || !ok3 || !ok4 || !ok5 || !ok6 || !ok7 || size <= 0 || generations <= 0 || warmup < 0 || repetitions <= 0 || tolerance < 0)
+    {
+        err << "Invalid numeric option" << '\n';
+        return 1;
+    }
+    QVector<Pattern> selectedPatterns;
+    QVector<Variant> selectedVariants;
+    if (!selectByName(patterns, parser.value(patternsOption), selectedPatterns)
+            || !selectByName(variants, parser.value(variantsOption), selectedVariants))
+    {
+        err << "Unknown pattern or variant" << '\n';
+        return 1;
+    }
+    LifeRule rule;
+    if (!LifeRule::parse(parser.value(ruleOption), rule))
+    {
+        err << "Invalid rule" << '\n';
+        return 1;
+    }
+
+    // the baseline's results, keyed by case name, each with its median & 95th percentile in ns/generation
+    QJsonObject baseline;
+    if (parser.isSet(baselineOption))
+    {
+        QFile file(parser.value(baselineOption));
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            err << "Cannot open baseline file " << file.fileName() << '\n';
+            return 1;
+        }
+        const QJsonObject document(QJsonDocument::fromJson(file.readAll()).object());
+        // (a baseline from another board, size, rule, generation count or seed times different work, so cannot be compared with)
+        QStringList mismatches;
+        if (document.value("board").toString() != boardVariantName())
+            mismatches.append(QString("board %1").arg(document.value("board").toString()));
+        if (document.value("size").toInt() != size)
+            mismatches.append(QString("size %1").arg(document.value("size").toInt()));
+        if (document.value("rule").toString() != rule.toString())
+            mismatches.append(QString("rule %1").arg(document.value("rule").toString()));
+        if (document.value("generations").toInt() != generations)
+            mismatches.append(QString("%1 generations").arg(document.value("generations").toInt()));
+        if (qint64(document.value("seed").toDouble()) != qint64(seed))
+            mismatches.append(QString("seed %1").arg(qint64(document.value("seed").toDouble())));
+        if (!mismatches.isEmpty())
+        {
+            err << "Baseline file " << file.fileName() << " is for a different run (" << mismatches.join(", ") << ")" << '\n';
+            return 1;
+        }
+        baseline = document.value("results").toObject();
+    }
+
+    out << QString("Board: %1, %2 x %2 cells, rule %3, %4 generations per repetition, %5 warmup + %6 repetitions, seed %7")
+           .arg(boardVariantName()).arg(size).arg(rule.toString()).arg(generations).arg(warmup).arg(repetitions).arg(seed) << '\n';
+    out << QString("Topology: %1").arg(LifeNumaTopology::system().description()) << '\n';
+    out << QString("%1 %2 %3 %4 %5 %6").arg("Case", -48).arg("Median ms", 12).arg("p95 ms", 12).arg("Gens/sec", 12).arg("Remote %", 9).arg("vs baseline", 12) << '\n';
+    out.flush();
+
+    LifeEngine engine;
+    engine.setRule(rule);
+    engine.newBoard(size);
+    const QString historyFileName(QDir::temp().filePath("conwaylife-benchmark.lifehist"));
+    QJsonObject results;
+    int regressions = 0;
+    for (const Pattern &pattern : selectedPatterns)
+        for (const Variant &variant : selectedVariants)
+        {
+            // thread counts only apply to the threaded variants
+            QList<int> variantThreadCounts(variant.threadMode == LifeEngine::ThreadsNone ? QList<int>{ 1 } : threadCounts);
+            for (int threadCount : variantThreadCounts)
+            {
+                QString caseName(QString("%1/%2/t%3").arg(pattern.name, variant.name).arg(threadCount));
+                engine.setBackend(LifeEngine::BackendBoard);
+                engine.setThreadMode(variant.threadMode);
+                engine.setThreadCount(threadCount);
+                engine.setPartitionMode(variant.partitionMode);
+                engine.setActiveRegionsOnly(variant.activeRegions);
+                engine.setTemporalBlockGenerations(variant.blockGenerations);
+
+                QVector<double> samples;
+                for (int repetition = 0; repetition < warmup + repetitions; repetition++)
+                {
+                    engine.setBackend(LifeEngine::BackendBoard);
+                    setUpPattern(engine, pattern, seed);
+                    engine.setBackend(variant.backend);
+                    QString errorMessage;
+                    if (variant.recordHistory
+                            && !engine.startRecordingHistory(historyFileName, LifeHistoryRecorder::defaultKeyframeInterval, errorMessage))
+                    {
+                        err << errorMessage << '\n';
+                        return 1;
+                    }
+                    QElapsedTimer et;
+                    et.start();
+                    engine.runSteps(generations);
+                    qint64 elapsedNsecs = et.nsecsElapsed();
+                    // (only the generations are timed, not writing out the last few frames still queued once they are done)
+                    if (variant.recordHistory && !engine.stopRecordingHistory(errorMessage))
+                    {
+                        err << errorMessage << '\n';
+                        return 1;
+                    }
+                    if (repetition >= warmup)
+                        samples.append(double(elapsedNsecs) / generations);
+                }
+
+                double median = percentile(samples, 0.5), p95 = percentile(samples, 0.95);
+                QJsonObject result;
+                result["median"] = median;
+                result["p95"] = p95;
+                // the share of remote pages, for the banded worker pools (whose workers each keep to their own band)
+                QString remoteText;
+                if (variant.backend == LifeEngine::BackendBoard && variant.partitionMode == LifeEngine::PartitionBanded
+                        && (variant.threadMode == LifeEngine::ThreadsWorkerPool || variant.threadMode == LifeEngine::ThreadsNumaWorkerPool))
+                {
+                    double remotePages = engine.remotePageFraction(threadCount);
+                    if (remotePages >= 0)
+                    {
+                        result["remotePages"] = remotePages;
+                        remoteText = QString::number(remotePages * 100, 'f', 1);
+                    }
+                }
+                results[caseName] = result;
+
+                QString comparison;
+                if (baseline.contains(caseName))
+                {
+                    double baselineMedian = baseline.value(caseName).toObject().value("median").toDouble();
+                    double change = baselineMedian > 0 ? (median - baselineMedian) * 100 / baselineMedian : 0;
+                    comparison = QString("%1%2%").arg(change >= 0 ? "+" : "").arg(change, 0, 'f', 1);
+                    if (change > tolerance)
+                    {
+                        comparison += " REGRESSION";
+                        regressions++;
+                    }
+                }
+                out << QString("%1 %2 %3 %4 %5 %6").arg(caseName, -48)
+                       .arg(median * generations / 1e6, 12, 'f', 3).arg(p95 * generations / 1e6, 12, 'f', 3)
+                       .arg(1e9 / median, 12, 'f', 0).arg(remoteText, 9).arg(comparison) << '\n';
+                out.flush();
+            }
+        }
+
+    QFile::remove(historyFileName);
+
+    if (parser.isSet(saveBaselineOption))
+    {
+        QJsonObject document;
+        document["board"] = boardVariantName();
+        document["size"] = size;
+        document["rule"] = rule.toString();
+        document["generations"] = generations;
+        document["seed"] = qint64(seed);
+        document["results"] = results;
+        QFile file(parser.value(saveBaselineOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            err << "Cannot write baseline file " << file.fileName() << '\n';
+            return 1;
+        }
+        file.write(QJsonDocument(document).toJson(QJsonDocument::Indented));
+    }
+
+    if (regressions > 0)
+    {
+        out << QString("%1 regression(s) of more than %2% against the baseline").arg(regressions).arg(tolerance) << '\n';
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+#include <cstring>
+
+#include "bitboard.h"
+
+
+////////// Generation Kernels //////////
+
+// each word of 64 cells is computed at once, adding up the 8 neighbour bits of every cell in parallel
+// with bitwise full-adder logic, instead of counting the neighbours of each cell in turn
+// the kernel is written once, for a "vector" of 1, 4 or 8 words (scalar/AVX2/AVX-512),
+// using GCC/Clang vector extensions so that it compiles to whichever instruction set its caller targets
+// it is also written twice over, for B3/S23 (Conway's Life) only, and for any Life-like rule given by its count masks
+
+#if defined(Q_PROCESSOR_X86_64) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+#define BITBOARD_SIMD 1
+#define BITBOARD_ALWAYS_INLINE __attribute__((always_inline))
+// the vector helpers are always inlined into a caller with the matching target, so their ABI is irrelevant
+#pragma GCC diagnostic ignored "-Wpsabi"
+typedef BitBoard::Word Word256 __attribute__((vector_size(32)));
+typedef BitBoard::Word Word512 __attribute__((vector_size(64)));
+#else
+#define BITBOARD_SIMD 0
+#define BITBOARD_ALWAYS_INLINE
+#endif
+
+typedef void (*StepFunction)(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                             const LifeRule &rule, LifeGenerationStatistics *statistics);
+
+template <typename V>
+static inline BITBOARD_ALWAYS_INLINE V loadWords(const BitBoard::Word *words)
+{
+    // load a (possibly unaligned) vector of words
+    V v;
+    memcpy(&v, words, sizeof(V));
+    return v;
+}
+
+template <typename V>
+static inline BITBOARD_ALWAYS_INLINE void storeWords(BitBoard::Word *words, const V &v)
+{
+    // store a (possibly unaligned) vector of words
+    memcpy(words, &v, sizeof(V));
+}
+
+template <typename V, bool Conway>
+static inline BITBOARD_ALWAYS_INLINE int stepWords(const BitBoard::Word *above, const BitBoard::Word *row, const BitBoard::Word *below,
+                                                   BitBoard::Word *newRow, int i, int wordEnd,
+                                                   LifeRule::CountMask birth, LifeRule::CountMask survival)
+{
+    // compute words `i`... of `newRow` a vector `V` at a time, for as many whole vectors as fit before `wordEnd`
+    // return the index of the first word not computed
+    constexpr int lanes = sizeof(V) / sizeof(BitBoard::Word);
+    for (; i + lanes <= wordEnd; i += lanes)
+    {
+        const V a = loadWords<V>(above + i), r = loadWords<V>(row + i), b = loadWords<V>(below + i);
+
+        // neighbours to the west/east of each cell are the row shifted by one bit,
+        // carrying in the end bit of the adjacent word
+        const V aboveW = (a << 1) | (loadWords<V>(above + i - 1) >> 63);
+        const V aboveE = (a >> 1) | (loadWords<V>(above + i + 1) << 63);
+        const V rowW = (r << 1) | (loadWords<V>(row + i - 1) >> 63);
+        const V rowE = (r >> 1) | (loadWords<V>(row + i + 1) << 63);
+        const V belowW = (b << 1) | (loadWords<V>(below + i - 1) >> 63);
+        const V belowE = (b >> 1) | (loadWords<V>(below + i + 1) << 63);
+
+        // sum the 3 neighbours in the row above into a 2-bit count (`aboveOnes`, `aboveTwos`)
+        const V aboveOnes = aboveW ^ a ^ aboveE;
+        const V aboveTwos = (aboveW & a) | (aboveE & (aboveW ^ a));
+        // sum the 2 neighbours in this row
+        const V rowOnes = rowW ^ rowE;
+        const V rowTwos = rowW & rowE;
+        // sum the 3 neighbours in the row below
+        const V belowOnes = belowW ^ b ^ belowE;
+        const V belowTwos = (belowW & b) | (belowE & (belowW ^ b));
+
+        // add the three "ones" bits, giving the units bit of the total and a carry into the "twos"
+        const V ones = aboveOnes ^ rowOnes ^ belowOnes;
+        const V onesCarry = (aboveOnes & rowOnes) | (belowOnes & (aboveOnes ^ rowOnes));
+        if (Conway)
+        {
+            // the total is 2 or 3 exactly when precisely one of the four "twos" bits is set
+            const V twosA = aboveTwos ^ rowTwos;
+            const V twosB = belowTwos ^ onesCarry;
+            const V twosExactlyOne = (twosA ^ twosB) & ~((aboveTwos & rowTwos) | (belowTwos & onesCarry));
+
+            // RULES: 3 neighbours => birth/survival, 2 neighbours => survival only
+            storeWords<V>(newRow + i, twosExactlyOne & (ones | r));
+        }
+        else
+        {
+            // add the four "twos" bits, giving the remaining 3 bits (`twos`, `fours`, `eights`) of the total
+            const V twosA = aboveTwos ^ rowTwos, twosACarry = aboveTwos & rowTwos;
+            const V twosB = belowTwos ^ onesCarry, twosBCarry = belowTwos & onesCarry;
+            const V twos = twosA ^ twosB;
+            const V fours = (twosACarry ^ twosBCarry) | (twosA & twosB);
+            const V eights = twosACarry & twosBCarry;
+
+            // RULES: each neighbour count in the birth mask => birth, in the survival mask => survival
+            V next = r & ~r;
+            for (int n = 0; n <= 8; n++)
+            {
+                bool born = (birth >> n) & 1, survives = (survival >> n) & 1;
+                if (!born && !survives)
+                    continue;
+                const V count = ((n & 1) ? ones : ~ones) & ((n & 2) ? twos : ~twos)
+                        & ((n & 4) ? fours : ~fours) & ((n & 8) ? eights : ~eights);
+                next |= born && survives ? count : (count & (survives ? r : ~r));
+            }
+            storeWords<V>(newRow + i, next);
+        }
+    }
+    return i;
+}
+
+static inline BITBOARD_ALWAYS_INLINE void addRowStatistics(const BitBoard::Word *row, const BitBoard::Word *newRow, int y, int wordStart, int wordEnd,
+                                                           int wordCount, BitBoard::Word lastWordMask, LifeGenerationStatistics &statistics)
+{
+    // add the population, births & deaths of words `wordStart` to `wordEnd - 1` of a newly generated row `newRow` (from `row`) to `statistics`
+    // (the bits of `row` beyond the right-hand edge may hold wrapped cells, so are masked off)
+    quint64 population = 0, births = 0, deaths = 0, hash = 0;
+    int first = -1, last = -1;
+    for (int i = wordStart; i < wordEnd; i++)
+    {
+        BitBoard::Word old = row[i] & (i == wordCount - 1 ? lastWordMask : ~BitBoard::Word(0));
+        BitBoard::Word word = newRow[i];
+        population += qPopulationCount(word);
+        births += qPopulationCount(word & ~old);
+        deaths += qPopulationCount(old & ~word);
+        if (word != 0)
+        {
+            hash += LifeGenerationStatistics::positionHash(quint64(y) * wordCount + i, word);
+            if (first < 0)
+                first = i;
+            last = i;
+        }
+    }
+    if (first >= 0)
+        statistics.addRow(y, population, births, deaths,
+                          (first * BitBoard::bitsPerWord) + int(qCountTrailingZeroBits(newRow[first])),
+                          (last * BitBoard::bitsPerWord) + (BitBoard::bitsPerWord - 1) - int(qCountLeadingZeroBits(newRow[last])), hash);
+    else
+        statistics.addRow(y, 0, births, deaths, 0, 0, 0);
+}
+
+template <typename V, bool Conway>
+static inline BITBOARD_ALWAYS_INLINE void stepWith(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                                                   const LifeRule &rule, LifeGenerationStatistics *statistics)
+{
+    // populate words `wordStart` to `wordEnd - 1` of rows `yStart`, `yStart + yStep`... (up to `yEnd - 1`) of `newBoard`,
+    // a vector `V` of words at a time, adding each row's figures to `statistics` (if any) straight after it is generated
+    const int wordCount = board.wordsPerRow();
+    if (wordStart >= wordEnd)
+        return;
+    for (int y = yStart; y < yEnd; y += yStep)
+    {
+        // the spare rows & words mean these are all safe to read at [-1] and [wordCount]
+        const BitBoard::Word *above = board.rowWords(y - 1);
+        const BitBoard::Word *row = board.rowWords(y);
+        const BitBoard::Word *below = board.rowWords(y + 1);
+        BitBoard::Word *newRow = newBoard.rowWords(y);
+        // whole vectors, then any remaining words singly
+        int i = stepWords<V, Conway>(above, row, below, newRow, wordStart, wordEnd, rule.birthMask(), rule.survivalMask());
+        stepWords<BitBoard::Word, Conway>(above, row, below, newRow, i, wordEnd, rule.birthMask(), rule.survivalMask());
+        // keep the cells beyond the right-hand edge of the board empty
+        if (wordEnd == wordCount)
+            newRow[wordCount - 1] &= board.lastRowWordMask();
+        if (statistics != nullptr)
+            addRowStatistics(row, newRow, y, wordStart, wordEnd, wordCount, board.lastRowWordMask(), *statistics);
+    }
+}
+
+static void stepScalar(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                       const LifeRule &rule, LifeGenerationStatistics *statistics)
+{
+    if (rule.isConway())
+        stepWith<BitBoard::Word, true>(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+    else
+        stepWith<BitBoard::Word, false>(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+}
+
+#if BITBOARD_SIMD
+__attribute__((target("avx2,popcnt")))
+static void stepAvx2(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                     const LifeRule &rule, LifeGenerationStatistics *statistics)
+{
+    if (rule.isConway())
+        stepWith<Word256, true>(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+    else
+        stepWith<Word256, false>(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static void stepAvx512(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                       const LifeRule &rule, LifeGenerationStatistics *statistics)
+{
+    if (rule.isConway())
+        stepWith<Word512, true>(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+    else
+        stepWith<Word512, false>(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+}
+
+static const StepFunction stepFunctions[] = { stepScalar, stepAvx2, stepAvx512 };
+#else
+static const StepFunction stepFunctions[] = { stepScalar, stepScalar, stepScalar };
+#endif
+
+static BitBoard::Kernel bestKernel()
+{
+    // return the best generation kernel the CPU supports
+#if BITBOARD_SIMD
+    __builtin_cpu_init();
+#endif
+    if (BitBoard::kernelIsSupported(BitBoard::Avx512Kernel))
+        return BitBoard::Avx512Kernel;
+    if (BitBoard::kernelIsSupported(BitBoard::Avx2Kernel))
+        return BitBoard::Avx2Kernel;
+    return BitBoard::ScalarKernel;
+}
+
+// the kernel in use is selected once at startup, from what the CPU supports
+static BitBoard::Kernel selectedKernel = bestKernel();
+static StepFunction stepFunction = stepFunctions[selectedKernel];
+
+
+////////// BitBoard Class //////////
+
+BitBoard::BitBoard()
+{
+    this->words = nullptr;
+    this->rows = this->columns = 0;
+    this->rowWordCount = this->stride = 0;
+    this->lastWordMask = 0;
+}
+
+BitBoard::~BitBoard()
+{
+    if (words != nullptr)
+        qFreeAligned(words);
+    words = nullptr;
+}
+
+void BitBoard::resize(int rows, int columns, bool clearCells /*= true*/)
+{
+    // (re-)allocate the board for `rows` x `columns` cells
+    // if not `clearCells`, a new allocation is left untouched (so its memory is not yet placed), for `clearRows()` to clear
+    Q_ASSERT(rows >= 0 && columns >= 0);
+    if (words != nullptr && rows == this->rows && columns == this->columns)
+        return;
+    if (words != nullptr)
+        qFreeAligned(words);
+    this->rows = rows;
+    this->columns = columns;
+    this->rowWordCount = (columns + bitsPerWord - 1) / bitsPerWord;
+    // a spare word at either end of each row, with each row a whole number of cache lines, so that each row starts a cache line
+    // (the spare word before a row is the last word of the row before, which is always padding as it holds at least both spare words)
+    this->stride = ((rowWordCount + 2 + wordsPerCacheLine - 1) / wordsPerCacheLine) * wordsPerCacheLine;
+    // mask of the bits in the last word of a row which are actually on the board
+    int lastWordBits = columns % bitsPerWord;
+    this->lastWordMask = lastWordBits == 0 ? ~Word(0) : (Word(1) << lastWordBits) - 1;
+    // a spare row above and below the board, and a cache line before them holding the spare word before the row above
+    words = static_cast<Word *>(qMallocAligned((wordsPerCacheLine + size_t(rows + 2) * stride) * sizeof(Word), cacheLineSize));
+    if (clearCells)
+        clear();
+}
+
+void BitBoard::clear()
+{
+    // clear all cells, including the spare words & rows
+    if (words != nullptr)
+        memset(words, 0, (wordsPerCacheLine + size_t(rows + 2) * stride) * sizeof(Word));
+}
+
+void BitBoard::clearRows(int yStart, int yEnd)
+{
+    // clear the cells of rows `yStart` to `yEnd - 1`, including their spare words,
+    // and the spare row above or below the board if the rows start or end it
+    Q_ASSERT(yStart >= 0 && yStart <= yEnd && yEnd <= rows);
+    if (words == nullptr || yStart == yEnd)
+        return;
+    int first = yStart == 0 ? -1 : yStart, last = yEnd == rows ? rows : yEnd - 1;
+    // (from the spare word before the first row, to the end of the last row, short of the spare word before the row after)
+    memset(rowWords(first) - 1, 0, size_t(last - first + 1) * stride * sizeof(Word));
+}
+
+void BitBoard::fillBorder(bool wrap)
+{
+    // fill the spare words & rows around the board: empty for dead edges, or copies of the opposite edges to wrap around
+    // to wrap, the cell beyond the right-hand edge is the bit just past the last column,
+    // which is in the last word of the row unless the row is a whole number of words
+    if (rows == 0 || columns == 0)
+        return;
+    for (int y = 0; y < rows; y++)
+    {
+        Word *row = rowWords(y);
+        row[-1] = row[rowWordCount] = 0;
+        row[rowWordCount - 1] &= lastWordMask;
+        if (wrap)
+        {
+            row[-1] = Word(cellAt(y, columns - 1)) << (bitsPerWord - 1);
+            row[columns / bitsPerWord] |= Word(cellAt(y, 0)) << (columns % bitsPerWord);
+        }
+    }
+    Word *above = rowWords(-1) - 1, *below = rowWords(rows) - 1;
+    if (wrap)
+    {
+        memcpy(above, rowWords(rows - 1) - 1, (rowWordCount + 2) * sizeof(Word));
+        memcpy(below, rowWords(0) - 1, (rowWordCount + 2) * sizeof(Word));
+    }
+    else
+    {
+        memset(above, 0, (rowWordCount + 2) * sizeof(Word));
+        memset(below, 0, (rowWordCount + 2) * sizeof(Word));
+    }
+}
+
+/*static*/ BitBoard::Kernel BitBoard::kernel()
+{
+    // return the generation kernel in use
+    return selectedKernel;
+}
+
+/*static*/ void BitBoard::setKernel(Kernel kernel)
+{
+    // set the generation kernel to use (falling back to scalar if the CPU does not support it)
+    selectedKernel = kernelIsSupported(kernel) ? kernel : ScalarKernel;
+    stepFunction = stepFunctions[selectedKernel];
+}
+
+/*static*/ bool BitBoard::kernelIsSupported(Kernel kernel)
+{
+    // return whether the CPU supports a generation kernel
+    switch (kernel)
+    {
+    case ScalarKernel:
+        return true;
+#if BITBOARD_SIMD
+    case Avx2Kernel:
+        return __builtin_cpu_supports("avx2");
+    case Avx512Kernel:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+/*static*/ const char *BitBoard::kernelName(Kernel kernel)
+{
+    // return the name of a generation kernel
+    switch (kernel)
+    {
+    case ScalarKernel: return "Scalar";
+    case Avx2Kernel: return "AVX2";
+    case Avx512Kernel: return "AVX-512";
+    }
+    return "";
+}
+
+/*static*/ void BitBoard::stepRows(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                                   const LifeRule &rule, LifeGenerationStatistics *statistics /*= nullptr*/)
+{
+    // populate words `wordStart` to `wordEnd - 1` of rows `yStart`, `yStart + yStep`... (up to `yEnd - 1`) of `newBoard` from `board`
+    // by generating a step under `rule`, adding each row's figures to `statistics` (if any)
+    Q_ASSERT(board.rows == newBoard.rows && board.columns == newBoard.columns);
+    Q_ASSERT(yStep > 0);
+    Q_ASSERT(yStart >= 0 && yEnd <= board.rows);
+    Q_ASSERT(wordStart >= 0 && wordEnd <= board.rowWordCount);
+    stepFunction(board, newBoard, yStart, yEnd, yStep, wordStart, wordEnd, rule, statistics);
+}
+
+/*static*/ void BitBoard::stepBlock(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int wordStart, int wordEnd,
+                                    const LifeRule &rule, LifeGenerationStatistics *statistics /*= nullptr*/)
+{
+    // populate the block of rows `yStart` to `yEnd - 1`, words `wordStart` to `wordEnd - 1`, of `newBoard` from `board`
+    // by generating a step under `rule`, adding each row's figures to `statistics` (if any)
+    stepRows(board, newBoard, yStart, yEnd, 1, wordStart, wordEnd, rule, statistics);
+}
+
+/*static*/ void BitBoard::stepColumn(const Word *words, int stride, int rows, Word *newWords, const LifeRule &rule)
+{
+    // populate `newWords[0]` to `newWords[rows - 1]` by generating a step under `rule` of a single column of words,
+    // held in a grid (rather than a board) `stride` words wide, whose column word for row `y` is `words[((y + 1) * stride) + 1]`
+    // the grid's rows -1 & `rows`, and the words either side of the column, hold the column's neighbours
+    // (always the scalar kernel, as there is only one word per row)
+    Q_ASSERT(stride >= 3);
+    bool conway = rule.isConway();
+    for (int y = 0; y < rows; y++)
+    {
+        const Word *row = words + ((y + 1) * stride) + 1;
+        if (conway)
+            stepWords<Word, true>(row - stride, row, row + stride, newWords + y, 0, 1, rule.birthMask(), rule.survivalMask());
+        else
+            stepWords<Word, false>(row - stride, row, row + stride, newWords + y, 0, 1, rule.birthMask(), rule.survivalMask());
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+
+#include "lifegenerationstatistics.h"
+#include "liferule.h"
+
+// a board which packs 64 cells into each `quint64` word, one bit per cell
+// bit `i` of word `w` in a row holds the cell at column `(w * 64) + i`
+// every row has a spare zero word at either end, and the board has a spare zero row above and below,
+// so that the generation kernel can read all neighbours without any bounds checks
+// the first word of every row starts a cache line (the spare word before it is the last word of the row before's padding,
+// and the first row's is the last of a cache line of its own)
+class BitBoard
+{
+public:
+    typedef quint64 Word;
+    static constexpr int bitsPerWord = 64;
+
+    // implementations of the generation kernel, the best one supported by the CPU is selected at startup
+    enum Kernel { ScalarKernel, Avx2Kernel, Avx512Kernel };
+
+    BitBoard();
+    ~BitBoard();
+    BitBoard(const BitBoard &) = delete;
+    BitBoard &operator=(const BitBoard &) = delete;
+
+    void resize(int rows, int columns, bool clearCells = true);
+    void clear();
+    void clearRows(int yStart, int yEnd);
+    void fillBorder(bool wrap);
+    int rowCount() const { return rows; }
+    int columnCount() const { return columns; }
+    int wordsPerRow() const { return rowWordCount; }
+    Word lastRowWordMask() const { return lastWordMask; }
+
+    Word *rowWords(int y) { return words + wordsPerCacheLine + ((y + 1) * stride); }
+    const Word *rowWords(int y) const { return words + wordsPerCacheLine + ((y + 1) * stride); }
+
+    bool cellAt(int y, int x) const
+    {
+        return (rowWords(y)[x / bitsPerWord] >> (x % bitsPerWord)) & 1;
+    }
+    void setCellAt(int y, int x, bool occupied)
+    {
+        Word &word(rowWords(y)[x / bitsPerWord]);
+        Word bit = Word(1) << (x % bitsPerWord);
+        word = occupied ? (word | bit) : (word & ~bit);
+    }
+
+    static Kernel kernel();
+    static void setKernel(Kernel kernel);
+    static bool kernelIsSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+    static void stepRows(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int yStep, int wordStart, int wordEnd,
+                         const LifeRule &rule, LifeGenerationStatistics *statistics = nullptr);
+    static void stepBlock(const BitBoard &board, BitBoard &newBoard, int yStart, int yEnd, int wordStart, int wordEnd,
+                          const LifeRule &rule, LifeGenerationStatistics *statistics = nullptr);
+    static void stepColumn(const Word *words, int stride, int rows, Word *newWords, const LifeRule &rule);
+
+private:
+    static constexpr int cacheLineSize = 64;
+    static constexpr int wordsPerCacheLine = cacheLineSize / sizeof(Word);
+    Word *words;
+    int rows, columns;
+    int rowWordCount, stride;
+    Word lastWordMask;
+};
+
+#endif // BITBOARD_H
@@ -24,11 +24,15 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(engine.pri)
+
 SOURCES += \
+    lifemetricsdock.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
+    lifemetricsdock.h \
     mainwindow.h
 
 FORMS += \
@@ -0,0 +1,47 @@
+# The Game of Life engine, independent of any GUI
+# included by the GUI (conwaylife.pro), the headless runner (headless/headless.pro) and the benchmark (benchmark/benchmark.pro)
+
+INCLUDEPATH += $$PWD
+
+# the board's storage layout (see lifeengine.h): C arrays unless one of these is given, e.g. `qmake CONFIG+=board_bit_packed`
+CONFIG(board_qvector) {
+    DEFINES += BOARD_C_ARRAYS=0
+}
+CONFIG(board_contiguous) {
+    DEFINES += BOARD_CONTIGUOUS=1
+}
+CONFIG(board_bit_packed) {
+    DEFINES += BOARD_BIT_PACKED=1
+}
+
+SOURCES += \
+    $$PWD/bitboard.cpp \
+    $$PWD/hashlife.cpp \
+    $$PWD/lifecheckpoint.cpp \
+    $$PWD/lifeengine.cpp \
+    $$PWD/lifehistory.cpp \
+    $$PWD/lifemetrics.cpp \
+    $$PWD/lifenuma.cpp \
+    $$PWD/liferandom.cpp \
+    $$PWD/lifepatternfile.cpp \
+    $$PWD/liferule.cpp \
+    $$PWD/lifesimulation.cpp \
+    $$PWD/lifeworkerpool.cpp \
+    $$PWD/sparseuniverse.cpp
+
+HEADERS += \
+    $$PWD/bitboard.h \
+    $$PWD/hashlife.h \
+    $$PWD/lifecheckpoint.h \
+    $$PWD/lifeengine.h \
+    $$PWD/lifegenerationstatistics.h \
+    $$PWD/lifehistory.h \
+    $$PWD/lifemetrics.h \
+    $$PWD/lifenuma.h \
+    $$PWD/liferandom.h \
+    $$PWD/lifepatternfile.h \
+    $$PWD/liferule.h \
+    $$PWD/lifesimulation.h \
+    $$PWD/lifeworkerpool.h \
+    $$PWD/paddedboard.h \
+    $$PWD/sparseuniverse.h
@@ -0,0 +1,582 @@
+#include "hashlife.h"
+
+
+////////// HashLife Class //////////
+
+HashLife::HashLife()
+{
+    this->maxMemory = size_t(512) * 1024 * 1024;
+    this->garbageCollectionCount = 0;
+    buildLookupTable();
+    clear();
+}
+
+void HashLife::buildLookupTable()
+{
+    // build the table of the centre 2x2 cells one generation on under the rule, for every 4x4 block of cells
+    // the 4x4 block is indexed by bit `(y * 4) + x`, the 2x2 result has bits (1,1), (1,2), (2,1), (2,2) in order
+    lookupTable4x4.resize(1 << 16);
+    for (int block = 0; block < (1 << 16); block++)
+    {
+        quint8 result = 0;
+        int bit = 0;
+        for (int y = 1; y <= 2; y++)
+            for (int x = 1; x <= 2; x++, bit++)
+            {
+                int neighbours = 0;
+                for (int dy = -1; dy <= 1; dy++)
+                    for (int dx = -1; dx <= 1; dx++)
+                        if ((dy != 0 || dx != 0) && (block & (1 << (((y + dy) * 4) + x + dx))))
+                            neighbours++;
+                bool occupied = block & (1 << ((y * 4) + x));
+                if (currentRule.nextState(occupied, neighbours))
+                    result |= 1 << bit;
+            }
+        lookupTable4x4[block] = result;
+    }
+}
+
+void HashLife::setRule(const LifeRule &rule)
+{
+    // set the rule, which invalidates every memoised result (but not the universe itself)
+    if (rule == currentRule)
+        return;
+    this->currentRule = rule;
+    buildLookupTable();
+    collectGarbage(false);
+}
+
+void HashLife::clear()
+{
+    // clear the universe, and all memoised results
+    nodes.clear();
+    emptyNodes.clear();
+    // node #0 is an empty cell, node #1 an occupied cell
+    for (int occupied = 0; occupied <= 1; occupied++)
+        nodes.append(Node{ noNode, noNode, noNode, noNode, noNode, noNode, quint64(occupied), 0, -1 });
+    emptyNodes.append(0);
+    buckets.fill(noNode, 1 << 16);
+    root = emptyNode(3);
+    generations = 0;
+}
+
+bool HashLife::cellAt(qint64 y, qint64 x) const
+{
+    // return whether a cell is occupied
+    int level = nodes.at(root).level;
+    qint64 half = qint64(1) << (level - 1);
+    if (y < -half || y >= half || x < -half || x >= half)
+        return false;
+    // descend from the root, with (y, x) relative to the top-left of each node
+    y += half;
+    x += half;
+    NodeIndex node = root;
+    while (level > 0 && nodes.at(node).population != 0)
+    {
+        half = qint64(1) << (level - 1);
+        const Node &n(nodes.at(node));
+        node = y < half ? (x < half ? n.nw : n.ne) : (x < half ? n.sw : n.se);
+        if (y >= half)
+            y -= half;
+        if (x >= half)
+            x -= half;
+        level--;
+    }
+    return nodes.at(node).population != 0;
+}
+
+void HashLife::setCellAt(qint64 y, qint64 x, bool occupied)
+{
+    // set whether a cell is occupied, growing the universe to include it if need be
+    forever
+    {
+        qint64 half = qint64(1) << (nodes.at(root).level - 1);
+        if (y >= -half && y < half && x >= -half && x < half)
+        {
+            root = setCellIn(root, y + half, x + half, occupied);
+            return;
+        }
+        root = expanded(root);
+    }
+}
+
+HashLife::NodeIndex HashLife::setCellIn(NodeIndex node, qint64 y, qint64 x, bool occupied)
+{
+    // return `node` with the cell at (y, x) (relative to its top-left) set
+    int level = nodes.at(node).level;
+    if (level == 0)
+        return occupied ? 1 : 0;
+    qint64 half = qint64(1) << (level - 1);
+    NodeIndex nw = nodes.at(node).nw, ne = nodes.at(node).ne, sw = nodes.at(node).sw, se = nodes.at(node).se;
+    if (y < half)
+    {
+        if (x < half)
+            nw = setCellIn(nw, y, x, occupied);
+        else
+            ne = setCellIn(ne, y, x - half, occupied);
+    }
+    else
+    {
+        if (x < half)
+            sw = setCellIn(sw, y - half, x, occupied);
+        else
+            se = setCellIn(se, y - half, x - half, occupied);
+    }
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::loadCells(qint64 top, qint64 left, int rows, int columns, const std::function<bool(int y, int x)> &cellAt)
+{
+    // replace the universe by a board of `rows` x `columns` cells, whose top-left cell is at (top, left)
+    // `cellAt(y, x)` returns whether the board cell at (y, x) is occupied
+    clear();
+    qint64 extent = qMax(qMax(qAbs(top), qAbs(top + rows)), qMax(qAbs(left), qAbs(left + columns)));
+    int level = 3;
+    while ((qint64(1) << (level - 1)) < extent)
+        level++;
+    qint64 half = qint64(1) << (level - 1);
+    root = buildNode(level, -half, -half, top, left, rows, columns, cellAt);
+}
+
+HashLife::NodeIndex HashLife::buildNode(int level, qint64 top, qint64 left, qint64 boardTop, qint64 boardLeft, int rows, int columns,
+                                        const std::function<bool(int y, int x)> &cellAt)
+{
+    // return a node of `level` whose top-left is at (top, left), built from the board cells it covers
+    qint64 size = qint64(1) << level;
+    if (top >= boardTop + rows || top + size <= boardTop || left >= boardLeft + columns || left + size <= boardLeft)
+        return emptyNode(level);
+    if (level == 0)
+        return cellAt(top - boardTop, left - boardLeft) ? 1 : 0;
+    qint64 half = size / 2;
+    NodeIndex nw = buildNode(level - 1, top, left, boardTop, boardLeft, rows, columns, cellAt);
+    NodeIndex ne = buildNode(level - 1, top, left + half, boardTop, boardLeft, rows, columns, cellAt);
+    NodeIndex sw = buildNode(level - 1, top + half, left, boardTop, boardLeft, rows, columns, cellAt);
+    NodeIndex se = buildNode(level - 1, top + half, left + half, boardTop, boardLeft, rows, columns, cellAt);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::forEachLiveCell(qint64 top, qint64 left, int rows, int columns, const std::function<void(int y, int x)> &callback) const
+{
+    // call `callback(y, x)` for each occupied cell within the board of `rows` x `columns` cells whose top-left cell is at (top, left)
+    // (y, x) are relative to the board's top-left
+    qint64 half = qint64(1) << (nodes.at(root).level - 1);
+    forEachLiveCellIn(root, -half, -half, top, left, rows, columns, callback);
+}
+
+void HashLife::forEachLiveCellIn(NodeIndex node, qint64 top, qint64 left, qint64 boardTop, qint64 boardLeft, int rows, int columns,
+                                 const std::function<void(int y, int x)> &callback) const
+{
+    // call `callback(y, x)` for each occupied cell of `node`, whose top-left is at (top, left), which lies within the board
+    const Node &n(nodes.at(node));
+    if (n.population == 0)
+        return;
+    qint64 size = qint64(1) << n.level;
+    if (top >= boardTop + rows || top + size <= boardTop || left >= boardLeft + columns || left + size <= boardLeft)
+        return;
+    if (n.level == 0)
+    {
+        callback(int(top - boardTop), int(left - boardLeft));
+        return;
+    }
+    qint64 half = size / 2;
+    forEachLiveCellIn(n.nw, top, left, boardTop, boardLeft, rows, columns, callback);
+    forEachLiveCellIn(n.ne, top, left + half, boardTop, boardLeft, rows, columns, callback);
+    forEachLiveCellIn(n.sw, top + half, left, boardTop, boardLeft, rows, columns, callback);
+    forEachLiveCellIn(n.se, top + half, left + half, boardTop, boardLeft, rows, columns, callback);
+}
+
+bool HashLife::readMacrocell(QIODevice &device, QStringList &headerLines, QString &errorMessage)
+{
+    // replace the universe by one read from Macrocell format (Golly's quadtree format, ".mc")
+    // header ("[M2] ...") & comment ("#...") lines are returned in `headerLines`, every other line is a node, numbered from 1:
+    // either an 8x8 leaf, rows of '.' (empty) & '*' (occupied) each ending in '$' (with trailing empty cells & rows left out),
+    // or "level nw ne sw se", a node 2^level cells square whose children are the numbers of earlier nodes, 0 for an empty child
+    // the last node is the root, which is centred on (0, 0)
+    // return false (leaving the universe empty) if the nodes are not valid
+    clear();
+    QVector<NodeIndex> lineNodes;
+    int lineNumber = 0;
+    auto fail = [this, &errorMessage, &lineNumber](const QString &message)->bool {
+        errorMessage = QString("Line %1: %2").arg(lineNumber).arg(message);
+        clear();
+        return false;
+    };
+    while (!device.atEnd())
+    {
+        const QByteArray line(device.readLine().trimmed());
+        lineNumber++;
+        if (line.isEmpty())
+            continue;
+        if (line.startsWith('[') || line.startsWith('#'))
+        {
+            headerLines.append(QString::fromUtf8(line));
+            continue;
+        }
+        if (line.at(0) == '.' || line.at(0) == '*' || line.at(0) == '$')
+        {
+            quint8 rows[8] = {};
+            int y = 0, x = 0;
+            for (char c : line)
+            {
+                if (c == '$')
+                {
+                    y++;
+                    x = 0;
+                    continue;
+                }
+                if ((c != '.' && c != '*') || y >= 8 || x >= 8)
+                    return fail("invalid leaf node");
+                if (c == '*')
+                    rows[y] |= 1 << x;
+                x++;
+            }
+            lineNodes.append(leafNode(rows, 3, 0, 0));
+            continue;
+        }
+        const QList<QByteArray> fields(line.simplified().split(' '));
+        bool ok = fields.count() == 5;
+        int level = ok ? fields.at(0).toInt(&ok) : 0;
+        if (!ok || level < 4 || level > 62)
+            return fail("invalid node");
+        NodeIndex children[4];
+        for (int i = 0; i < 4; i++)
+        {
+            int number = fields.at(i + 1).toInt(&ok);
+            if (!ok || number < 0 || number > lineNodes.count())
+                return fail("invalid child node number");
+            children[i] = number == 0 ? emptyNode(level - 1) : lineNodes.at(number - 1);
+            if (nodes.at(children[i]).level != level - 1)
+                return fail("child node is the wrong size");
+        }
+        lineNodes.append(join(children[0], children[1], children[2], children[3]));
+    }
+    if (lineNodes.isEmpty())
+        return fail("no nodes");
+    root = lineNodes.last();
+    return true;
+}
+
+HashLife::NodeIndex HashLife::leafNode(const quint8 rows[8], int level, int top, int left)
+{
+    // return a node of `level` built from the cells of an 8x8 leaf at (top, left), bit `x` of `rows[y]` being cell (y, x)
+    if (level == 0)
+        return (rows[top] >> left) & 1;
+    int half = 1 << (level - 1);
+    NodeIndex nw = leafNode(rows, level - 1, top, left);
+    NodeIndex ne = leafNode(rows, level - 1, top, left + half);
+    NodeIndex sw = leafNode(rows, level - 1, top + half, left);
+    NodeIndex se = leafNode(rows, level - 1, top + half, left + half);
+    return join(nw, ne, sw, se);
+}
+
+void HashLife::writeMacrocell(QIODevice &device) const
+{
+    // write the universe's nodes in Macrocell format (see `readMacrocell()`), without any header lines
+    // each distinct occupied node of level 3 and up is written once, after its children, so shared subpatterns cost one line
+    QHash<NodeIndex, int> numbers;
+    if (nodes.at(root).population == 0)
+        device.write("4 0 0 0 0\n");
+    else
+        writeMacrocellNode(device, root, numbers);
+}
+
+int HashLife::writeMacrocellNode(QIODevice &device, NodeIndex node, QHash<NodeIndex, int> &numbers) const
+{
+    // write an (occupied) node of level 3 or up, after its children, unless it is already written
+    // return its number (0 for an empty node)
+    const Node &n(nodes.at(node));
+    if (n.population == 0)
+        return 0;
+    auto it = numbers.constFind(node);
+    if (it != numbers.constEnd())
+        return it.value();
+    QByteArray line;
+    if (n.level == 3)
+    {
+        quint8 rows[8] = {};
+        leafRows(node, 0, 0, rows);
+        int lastRow = 7;
+        while (rows[lastRow] == 0)
+            lastRow--;
+        for (int y = 0; y <= lastRow; y++)
+        {
+            for (int x = 0; x < 8 && (rows[y] >> x) != 0; x++)
+                line += (rows[y] >> x) & 1 ? '*' : '.';
+            line += '$';
+        }
+    }
+    else
+    {
+        int nw = writeMacrocellNode(device, n.nw, numbers), ne = writeMacrocellNode(device, n.ne, numbers);
+        int sw = writeMacrocellNode(device, n.sw, numbers), se = writeMacrocellNode(device, n.se, numbers);
+        line = QByteArray::number(n.level) + ' ' + QByteArray::number(nw) + ' ' + QByteArray::number(ne)
+                + ' ' + QByteArray::number(sw) + ' ' + QByteArray::number(se);
+    }
+    line += '\n';
+    device.write(line);
+    int number = numbers.count() + 1;
+    numbers.insert(node, number);
+    return number;
+}
+
+void HashLife::leafRows(NodeIndex node, int top, int left, quint8 rows[8]) const
+{
+    // set the bits in `rows` for the occupied cells of a node (within an 8x8 leaf) whose top-left is at (top, left)
+    const Node &n(nodes.at(node));
+    if (n.population == 0)
+        return;
+    if (n.level == 0)
+    {
+        rows[top] |= 1 << left;
+        return;
+    }
+    int half = 1 << (n.level - 1);
+    leafRows(n.nw, top, left, rows);
+    leafRows(n.ne, top, left + half, rows);
+    leafRows(n.sw, top + half, left, rows);
+    leafRows(n.se, top + half, left + half, rows);
+}
+
+void HashLife::step(int log2Generations)
+{
+    // advance the universe by 2^`log2Generations` generations
+    Q_ASSERT(log2Generations >= 0 && log2Generations < 64);
+    // grow the universe until it is big enough for the step, and the pattern lies within its central quarter,
+    // so that nothing can travel beyond the half of the universe which `successor()` returns
+    while (nodes.at(root).level < log2Generations + 3 || !isPadded(root))
+        root = expanded(root);
+    root = successor(root, log2Generations);
+    generations += quint64(1) << log2Generations;
+    // keep within the memory limit, dropping first the nodes which are neither in the universe nor in the results memoised from it,
+    // and then, if that leaves it over half the limit, all memoised results too (and the nodes only they held)
+    if (memoryUsage() > maxMemory)
+    {
+        collectGarbage(true);
+        if (memoryUsage() > maxMemory / 2)
+            collectGarbage(false);
+    }
+}
+
+quint64 HashLife::population() const
+{
+    // return the number of occupied cells
+    return nodes.at(root).population;
+}
+
+void HashLife::setMemoryLimit(size_t bytes)
+{
+    // set the memory above which garbage is collected after a step
+    maxMemory = bytes;
+}
+
+size_t HashLife::memoryUsage() const
+{
+    // return the memory used by the nodes and their hash table
+    return size_t(nodes.count()) * sizeof(Node) + size_t(buckets.count()) * sizeof(NodeIndex);
+}
+
+/*static*/ quint32 HashLife::hash(NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se)
+{
+    quint64 h = (quint64(nw) * 0x9E3779B97F4A7C15ULL) ^ (quint64(ne) * 0xC2B2AE3D27D4EB4FULL)
+            ^ (quint64(sw) * 0x165667B19E3779F9ULL) ^ (quint64(se) * 0x27D4EB2F165667C5ULL);
+    return quint32(h ^ (h >> 29) ^ (h >> 47));
+}
+
+HashLife::NodeIndex HashLife::join(NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se)
+{
+    // return the canonical node with these four children, creating it if it does not already exist
+    quint32 bucket = hash(nw, ne, sw, se) & quint32(buckets.count() - 1);
+    for (NodeIndex node = buckets.at(bucket); node != noNode; node = nodes.at(node).next)
+    {
+        const Node &n(nodes.at(node));
+        if (n.nw == nw && n.ne == ne && n.sw == sw && n.se == se)
+            return node;
+    }
+    NodeIndex node = NodeIndex(nodes.count());
+    quint64 population = nodes.at(nw).population + nodes.at(ne).population + nodes.at(sw).population + nodes.at(se).population;
+    nodes.append(Node{ nw, ne, sw, se, noNode, buckets.at(bucket), population, qint8(nodes.at(nw).level + 1), -1 });
+    buckets[bucket] = node;
+    if (nodes.count() > buckets.count())
+        rehash(buckets.count() * 2);
+    return node;
+}
+
+HashLife::NodeIndex HashLife::emptyNode(int level)
+{
+    // return the empty node of `level`
+    while (emptyNodes.count() <= level)
+    {
+        NodeIndex empty = emptyNodes.last();
+        emptyNodes.append(join(empty, empty, empty, empty));
+    }
+    return emptyNodes.at(level);
+}
+
+HashLife::NodeIndex HashLife::expanded(NodeIndex node)
+{
+    // return a node of the next level up, with `node` at its centre and empty all around
+    const Node n(nodes.at(node));
+    NodeIndex empty = emptyNode(n.level - 1);
+    return join(join(empty, empty, empty, n.nw), join(empty, empty, n.ne, empty),
+                join(empty, n.sw, empty, empty), join(n.se, empty, empty, empty));
+}
+
+bool HashLife::isPadded(NodeIndex node) const
+{
+    // return whether all of a node's occupied cells lie within its central quarter (its centre's centre)
+    const Node &n(nodes.at(node));
+    if (n.level < 3)
+        return n.population == 0;
+    quint64 centrePopulation = nodes.at(nodes.at(nodes.at(n.nw).se).se).population + nodes.at(nodes.at(nodes.at(n.ne).sw).sw).population
+            + nodes.at(nodes.at(nodes.at(n.sw).ne).ne).population + nodes.at(nodes.at(nodes.at(n.se).nw).nw).population;
+    return centrePopulation == n.population;
+}
+
+HashLife::NodeIndex HashLife::successor4x4(NodeIndex node)
+{
+    // return the centre 2x2 of a 4x4 node one generation on, via the lookup table
+    const Node &n(nodes.at(node));
+    quint32 block = 0;
+    const NodeIndex quadrants[4] = { n.nw, n.ne, n.sw, n.se };
+    for (int q = 0; q < 4; q++)
+    {
+        const Node &quadrant(nodes.at(quadrants[q]));
+        int y = (q / 2) * 2, x = (q % 2) * 2;
+        block |= quint32(quadrant.nw) << ((y * 4) + x);
+        block |= quint32(quadrant.ne) << ((y * 4) + x + 1);
+        block |= quint32(quadrant.sw) << (((y + 1) * 4) + x);
+        block |= quint32(quadrant.se) << (((y + 1) * 4) + x + 1);
+    }
+    quint8 result = lookupTable4x4.at(block);
+    return join(result & 1, (result >> 1) & 1, (result >> 2) & 1, (result >> 3) & 1);
+}
+
+HashLife::NodeIndex HashLife::successor(NodeIndex node, int log2Step)
+{
+    // return the centre (one level down) of a node of level >= 2, 2^`log2Step` generations on
+    // `log2Step` is reduced to at most `level - 2`, the most a node can be advanced
+    // the result is memoised in the node, for the step it was computed for
+    // (nodes may be appended while recursing, so no references into `nodes` are held across calls)
+    const Node n(nodes.at(node));
+    Q_ASSERT(n.level >= 2);
+    log2Step = qMin(log2Step, int(n.level) - 2);
+    if (n.result != noNode && n.resultLog2Step == log2Step)
+        return n.result;
+    NodeIndex result;
+    if (n.population == 0)
+        result = emptyNode(n.level - 1);
+    else if (n.level == 2)
+        result = successor4x4(node);
+    else
+    {
+        const Node a(nodes.at(n.nw)), b(nodes.at(n.ne)), c(nodes.at(n.sw)), d(nodes.at(n.se));
+        // the 9 overlapping sub-nodes (one level down) of the node, each advanced (and so one level further down)
+        NodeIndex c1 = successor(n.nw, log2Step);
+        NodeIndex c2 = successor(join(a.ne, b.nw, a.se, b.sw), log2Step);
+        NodeIndex c3 = successor(n.ne, log2Step);
+        NodeIndex c4 = successor(join(a.sw, a.se, c.nw, c.ne), log2Step);
+        NodeIndex c5 = successor(join(a.se, b.sw, c.ne, d.nw), log2Step);
+        NodeIndex c6 = successor(join(b.sw, b.se, d.nw, d.ne), log2Step);
+        NodeIndex c7 = successor(n.sw, log2Step);
+        NodeIndex c8 = successor(join(c.ne, d.nw, c.se, d.sw), log2Step);
+        NodeIndex c9 = successor(n.se, log2Step);
+        if (log2Step < n.level - 2)
+        {
+            // the sub-nodes have already been advanced the whole step, so just assemble their centres
+            const Node n1(nodes.at(c1)), n2(nodes.at(c2)), n3(nodes.at(c3)), n4(nodes.at(c4)), n5(nodes.at(c5));
+            const Node n6(nodes.at(c6)), n7(nodes.at(c7)), n8(nodes.at(c8)), n9(nodes.at(c9));
+            result = join(join(n1.se, n2.sw, n4.ne, n5.nw), join(n2.se, n3.sw, n5.ne, n6.nw),
+                          join(n4.se, n5.sw, n7.ne, n8.nw), join(n5.se, n6.sw, n8.ne, n9.nw));
+        }
+        else
+        {
+            // the sub-nodes have been advanced half the step, so advance the four quarters they make up by the other half
+            NodeIndex nw = successor(join(c1, c2, c4, c5), log2Step);
+            NodeIndex ne = successor(join(c2, c3, c5, c6), log2Step);
+            NodeIndex sw = successor(join(c4, c5, c7, c8), log2Step);
+            NodeIndex se = successor(join(c5, c6, c8, c9), log2Step);
+            result = join(nw, ne, sw, se);
+        }
+    }
+    nodes[node].result = result;
+    nodes[node].resultLog2Step = qint8(log2Step);
+    return result;
+}
+
+void HashLife::rehash(int bucketCount)
+{
+    // rebuild the hash table with `bucketCount` (a power of 2) buckets
+    Q_ASSERT((bucketCount & (bucketCount - 1)) == 0);
+    buckets.fill(noNode, bucketCount);
+    // the two cells (nodes #0 & #1) are not in the hash table
+    for (int i = 2; i < nodes.count(); i++)
+    {
+        Node &n(nodes[i]);
+        quint32 bucket = hash(n.nw, n.ne, n.sw, n.se) & quint32(bucketCount - 1);
+        n.next = buckets.at(bucket);
+        buckets[bucket] = NodeIndex(i);
+    }
+}
+
+void HashLife::mark(NodeIndex node, QVector<bool> &marked, bool followResults) const
+{
+    // mark a node and all its descendants as reachable, and if `followResults`, its memoised result (and its descendants...) too
+    // (children & results are a level down, so this recurses no deeper than the node's level)
+    if (marked.at(node))
+        return;
+    marked[node] = true;
+    const Node &n(nodes.at(node));
+    if (n.level > 0)
+    {
+        mark(n.nw, marked, followResults);
+        mark(n.ne, marked, followResults);
+        mark(n.sw, marked, followResults);
+        mark(n.se, marked, followResults);
+    }
+    if (followResults && n.result != noNode)
+        mark(n.result, marked, followResults);
+}
+
+void HashLife::collectGarbage(bool keepResults /*= true*/)
+{
+    // remove all nodes not reachable from the universe's root (or the empty nodes)
+    // if `keepResults`, the reachable nodes' memoised results are reachable too, so they are all kept,
+    // else every memoised result is dropped, and with it every node only results held
+    garbageCollectionCount++;
+    QVector<bool> marked(nodes.count(), false);
+    marked[0] = marked[1] = true;
+    mark(root, marked, keepResults);
+    for (NodeIndex empty : emptyNodes)
+        mark(empty, marked, keepResults);
+    // number the surviving nodes in their existing order, so that children still come before parents
+    QVector<NodeIndex> newIndex(nodes.count(), noNode);
+    NodeIndex count = 0;
+    for (int i = 0; i < nodes.count(); i++)
+        if (marked.at(i))
+            newIndex[i] = count++;
+    for (int i = 0; i < nodes.count(); i++)
+    {
+        if (!marked.at(i))
+            continue;
+        Node n(nodes.at(i));
+        if (n.level > 0)
+        {
+            n.nw = newIndex.at(n.nw);
+            n.ne = newIndex.at(n.ne);
+            n.sw = newIndex.at(n.sw);
+            n.se = newIndex.at(n.se);
+        }
+        if (n.result != noNode)
+            n.result = keepResults ? newIndex.at(n.result) : noNode;
+        nodes[newIndex.at(i)] = n;
+    }
+    nodes.resize(int(count));
+    nodes.squeeze();
+    root = newIndex.at(root);
+    for (NodeIndex &empty : emptyNodes)
+        empty = newIndex.at(empty);
+    int bucketCount = 1 << 16;
+    while (bucketCount < nodes.count())
+        bucketCount *= 2;
+    rehash(bucketCount);
+}
@@ -0,0 +1,88 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <functional>
+
+#include <QHash>
+#include <QIODevice>
+#include <QStringList>
+#include <QVector>
+
+#include "liferule.h"
+
+// a HashLife universe: an unbounded board held as a quadtree of canonicalised (hash-consed) nodes,
+// where each node memoises its own future, so that a pattern can be advanced 2^k generations at once
+// node #0 is an empty cell and node #1 an occupied cell, every other node of level `L` is a square of 2^L x 2^L cells
+// the universe is centred on (0, 0): the root node covers cells -2^(L-1) to 2^(L-1) - 1 in each direction
+class HashLife
+{
+public:
+    typedef quint32 NodeIndex;
+
+    HashLife();
+
+    void clear();
+    const LifeRule &rule() const { return currentRule; }
+    void setRule(const LifeRule &rule);
+    bool cellAt(qint64 y, qint64 x) const;
+    void setCellAt(qint64 y, qint64 x, bool occupied);
+    void loadCells(qint64 top, qint64 left, int rows, int columns, const std::function<bool(int y, int x)> &cellAt);
+    void forEachLiveCell(qint64 top, qint64 left, int rows, int columns, const std::function<void(int y, int x)> &callback) const;
+    bool readMacrocell(QIODevice &device, QStringList &headerLines, QString &errorMessage);
+    void writeMacrocell(QIODevice &device) const;
+
+    void step(int log2Generations);
+    quint64 generationCount() const { return generations; }
+    quint64 population() const;
+
+    size_t memoryLimit() const { return maxMemory; }
+    void setMemoryLimit(size_t bytes);
+    size_t memoryUsage() const;
+    int nodeCount() const { return nodes.count(); }
+    int garbageCollections() const { return garbageCollectionCount; }
+    void collectGarbage(bool keepResults = true);
+
+private:
+    static constexpr NodeIndex noNode = 0xffffffff;
+    struct Node {
+        NodeIndex nw, ne, sw, se;
+        // memoised result: the centre of this node, `2^resultLog2Step` generations ahead
+        NodeIndex result;
+        // next node in the same hash table bucket
+        NodeIndex next;
+        quint64 population;
+        qint8 level;
+        qint8 resultLog2Step;
+    };
+
+    QVector<Node> nodes;
+    QVector<NodeIndex> buckets;
+    QVector<NodeIndex> emptyNodes;
+    LifeRule currentRule;
+    QVector<quint8> lookupTable4x4;
+    NodeIndex root;
+    quint64 generations;
+    size_t maxMemory;
+    int garbageCollectionCount;
+
+    void buildLookupTable();
+    NodeIndex join(NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se);
+    NodeIndex emptyNode(int level);
+    NodeIndex expanded(NodeIndex node);
+    bool isPadded(NodeIndex node) const;
+    NodeIndex successor(NodeIndex node, int log2Step);
+    NodeIndex successor4x4(NodeIndex node);
+    NodeIndex setCellIn(NodeIndex node, qint64 y, qint64 x, bool occupied);
+    NodeIndex buildNode(int level, qint64 top, qint64 left, qint64 boardTop, qint64 boardLeft, int rows, int columns,
+                        const std::function<bool(int y, int x)> &cellAt);
+    void forEachLiveCellIn(NodeIndex node, qint64 top, qint64 left, qint64 boardTop, qint64 boardLeft, int rows, int columns,
+                       const std::function<void(int y, int x)> &callback) const;
+    NodeIndex leafNode(const quint8 rows[8], int level, int top, int left);
+    void leafRows(NodeIndex node, int top, int left, quint8 rows[8]) const;
+    int writeMacrocellNode(QIODevice &device, NodeIndex node, QHash<NodeIndex, int> &numbers) const;
+    void rehash(int bucketCount);
+    void mark(NodeIndex node, QVector<bool> &marked, bool followResults) const;
+    static quint32 hash(NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se);
+};
+
+#endif // HASHLIFE_H
@@ -0,0 +1,16 @@
+# Headless batch runner: runs the engine for a number of generations without any GUI,
+# and prints the throughput as JSON, for unattended throughput sweeps
+
+QT = core concurrent
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = conwaylife-headless
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../engine.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,344 @@
+#include <limits>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+#include "lifecheckpoint.h"
+#include "lifeengine.h"
+#include "lifenuma.h"
+#include "lifepatternfile.h"
+
+// run the engine for a number of generations on a randomized board (or a pattern file, checkpoint or recorded generation), without any GUI,
+// and print the throughput (generations/sec, ns/cell) and final population as JSON on stdout
+
+static bool parseEnum(const QString &value, const QStringList &names, int &index)
+{
+    // set `index` to the position of `value` in `names`, returning whether it was found
+    index = names.indexOf(value.toLower());
+    return index >= 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("conwaylife-headless");
+
+    static const QStringList backendNames = { "board", "hashlife", "unbounded" };
+    static const QStringList threadModeNames = { "none", "qtconcurrent", "qthreads", "pool", "numa" };
+    static const QStringList partitionNames = { "interleaved", "banded", "tiled" };
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run Conway's Game of Life without a GUI and print the throughput as JSON");
+    parser.addHelpOption();
+    QCommandLineOption generationsOption("generations", "Number of generations to run (default 1000).", "n", "1000");
+    QCommandLineOption seedOption("seed", "Random seed for the initial board (default 1).", "seed", "1");
+    QCommandLineOption sizeOption("size", QString("Board size, in cells along each side (default %1).").arg(LifeEngine::defaultBoardSize),
+                                  "cells", QString::number(LifeEngine::defaultBoardSize));
+    QCommandLineOption threadsOption("threads", "Number of threads (default the ideal thread count).", "n", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption threadModeOption("thread-mode", "How threads are used: none, qtconcurrent, qthreads, pool "
+                                                        "or numa (the worker pool, each worker owning its band of the board on its own NUMA node) (default pool).",
+                                        "mode", "pool");
+    QCommandLineOption partitionOption("partition", "How the board is partitioned between threads: interleaved, banded or tiled (default banded).", "mode", "banded");
+    QCommandLineOption backendOption("backend", "Backend: board, hashlife or unbounded (default board).", "backend", "board");
+    QCommandLineOption log2StepOption("log2-step", "HashLife backend steps 2^k generations at a time (default 0).", "k", "0");
+    QCommandLineOption ruleOption("rule", "Life-like rule in B/S notation (default B3/S23).", "rule", "B3/S23");
+    QCommandLineOption patternOption("pattern", "Pattern file (.rle, .cells or .mc) to start from, centred on the board, instead of a random board.", "file");
+    QCommandLineOption saveOption("save", "Pattern file (.rle, .cells or .mc) to save the final cells to.", "file");
+    QCommandLineOption restoreOption("restore", "Checkpoint file to resume from, instead of a random board.", "file");
+    QCommandLineOption checkpointOption("checkpoint", "Checkpoint file to save the state to at the end (and every --checkpoint-every generations).", "file");
+    QCommandLineOption checkpointEveryOption("checkpoint-every", "Generations between checkpoints, written in the background while the run continues (default 0, only at the end).", "n", "0");
+    QCommandLineOption checkpointCompressOption("checkpoint-compress", "Compress the checkpoint's tiles.");
+    QCommandLineOption recordOption("record", "History log file to record every generation to.", "file");
+    QCommandLineOption recordKeyframesOption("record-keyframes", QString("Generations between keyframes in the history log (default %1).").arg(LifeHistoryRecorder::defaultKeyframeInterval),
+                                             "n", QString::number(LifeHistoryRecorder::defaultKeyframeInterval));
+    QCommandLineOption historyOption("history", "History log file to start from a recorded generation of, instead of a random board.", "file");
+    QCommandLineOption historyGenerationOption("history-generation", "Recorded generation to start from (default the last one recorded).", "n");
+    QCommandLineOption wrapOption("wrap", "Wrap around the board's edges.");
+    QCommandLineOption activeRegionsOption("active-regions", "Only generate the board's active regions.");
+    QCommandLineOption temporalBlockOption("temporal-block", QString("Advance the board k generations at a time, tile by tile in cache (temporal blocking), "
+                                                                     "up to %1, without threads or in the worker pool, and not with --active-regions, "
+                                                                     "--statistics or --record (default 1, none).").arg(LifeEngine::maxTemporalBlockGenerations),
+                                           "k", "1");
+    QCommandLineOption statisticsOption("statistics", "Gather each generation's population, births, deaths & bounds as it is generated (board backend), "
+                                                      "generating only the occupied region, and report the last generation's.");
+    QCommandLineOption untilStabilisedOption("until-stabilised", QString("Stop once the board has stabilised, into still lifes & oscillators of period up to %1 "
+                                                                         "(checked every 100 generations), and report when (board backend, implies --statistics).")
+                                             .arg(LifeEngine::maxStabilisationPeriod));
+    parser.addOptions({ generationsOption, seedOption, sizeOption, threadsOption, threadModeOption, partitionOption,
+                        backendOption, log2StepOption, ruleOption, patternOption, saveOption,
+                        restoreOption, checkpointOption, checkpointEveryOption, checkpointCompressOption,
+                        recordOption, recordKeyframesOption, historyOption, historyGenerationOption, wrapOption, activeRegionsOption,
+                        temporalBlockOption, statisticsOption, untilStabilisedOption });
+    parser.process(a);
+
+    QTextStream err(stderr);
+    bool ok1, ok2, ok3, ok4, ok5, ok6, ok7, ok8;
+    qint64 generations = parser.value(generationsOption).toLongLong(&ok1);
+    quint32 seed = parser.value(seedOption).toUInt(&ok2);
+    int size = parser.value(sizeOption).toInt(&ok3);
+    int threadCount = parser.value(threadsOption).toInt(&ok4);
+    int log2Step = parser.value(log2StepOption).toInt(&ok5);
+    qint64 checkpointEvery = parser.value(checkpointEveryOption).toLongLong(&ok6);
+    int recordKeyframes = parser.value(recordKeyframesOption).toInt(&ok7);
+    int temporalBlock = parser.value(temporalBlockOption).toInt(&ok8);
+    if (!ok1 || !ok2 || !ok3 || !ok4 || !ok5 || !ok6 || !ok7 || !ok8 || generations < 0 || size <= 0 || threadCount <= 0 || log2Step < 0 || log2Step > 48
+            || checkpointEvery < 0 || recordKeyframes <= 0 || temporalBlock < 1 || temporalBlock > LifeEngine::maxTemporalBlockGenerations)
+    {
+        err << "Invalid numeric option" << '\n';
+        return 1;
+    }
+    int backend, threadMode, partition;
+    if (!parseEnum(parser.value(backendOption), backendNames, backend)
+            || !parseEnum(parser.value(threadModeOption), threadModeNames, threadMode)
+            || !parseEnum(parser.value(partitionOption), partitionNames, partition))
+    {
+        err << "Invalid backend, thread mode or partition" << '\n';
+        return 1;
+    }
+    LifeRule rule;
+    if (!LifeRule::parse(parser.value(ruleOption), rule))
+    {
+        err << "Invalid rule" << '\n';
+        return 1;
+    }
+
+    LifeEngine engine;
+    engine.setThreadMode(LifeEngine::ThreadMode(threadMode));
+    engine.setThreadCount(threadCount);
+    engine.setPartitionMode(LifeEngine::PartitionMode(partition));
+    engine.setRule(rule);
+    engine.setEdgesWrap(parser.isSet(wrapOption));
+    engine.setActiveRegionsOnly(parser.isSet(activeRegionsOption));
+    engine.setTemporalBlockGenerations(temporalBlock);
+    bool untilStabilised = parser.isSet(untilStabilisedOption);
+    engine.setTrackStatistics(parser.isSet(statisticsOption) || untilStabilised);
+    engine.setHashLifeLog2Step(log2Step);
+    engine.newBoard(size);
+    if (parser.isSet(restoreOption))
+    {
+        // (the checkpoint's board size, rule, edges and seed apply, unless a rule is given or wrapping asked for)
+        quint64 restoredSeed;
+        QString errorMessage;
+        if (!LifeCheckpoint::restore(parser.value(restoreOption), engine, restoredSeed, errorMessage))
+        {
+            err << errorMessage << '\n';
+            return 1;
+        }
+        size = engine.boardSize();
+        seed = quint32(restoredSeed);
+        if (parser.isSet(ruleOption))
+            engine.setRule(rule);
+        if (parser.isSet(wrapOption))
+            engine.setEdgesWrap(true);
+    }
+    else if (parser.isSet(historyOption))
+    {
+        LifeHistoryReader history;
+        QString errorMessage;
+        if (!history.open(parser.value(historyOption), errorMessage))
+        {
+            err << errorMessage << '\n';
+            return 1;
+        }
+        int frame = history.frameCount() - 1;
+        if (parser.isSet(historyGenerationOption))
+            frame = history.frameForGeneration(parser.value(historyGenerationOption).toLongLong());
+        if (frame < 0)
+        {
+            err << "Generation not recorded in the history log" << '\n';
+            return 1;
+        }
+        if (!history.loadFrame(frame, engine, errorMessage))
+        {
+            err << errorMessage << '\n';
+            return 1;
+        }
+        size = engine.boardSize();
+    }
+    else if (parser.isSet(patternOption))
+    {
+        // (the pattern's own rule applies, unless a rule is given)
+        LifePatternFile::Info info;
+        QString errorMessage;
+        if (!LifePatternFile::load(parser.value(patternOption), engine, info, errorMessage))
+        {
+            err << errorMessage << '\n';
+            return 1;
+        }
+        if (info.hasRule && !parser.isSet(ruleOption))
+            engine.setRule(info.rule);
+    }
+    else
+    {
+        engine.randomize(seed);
+    }
+    engine.setBackend(LifeEngine::Backend(backend));
+
+    // HashLife steps 2^k generations at a time, so run enough steps to cover (at least) the generations asked for
+    qint64 steps = (generations + engine.generationsPerStep() - 1) / engine.generationsPerStep();
+    // checkpoints during the run are written in the background while the next batch runs, one at a time
+    const QString checkpointFile(parser.value(checkpointOption));
+    bool checkpointCompress = parser.isSet(checkpointCompressOption);
+    bool periodicCheckpoints = checkpointEvery > 0 && !checkpointFile.isEmpty();
+    qint64 checkpointSteps = periodicCheckpoints ? qMax(checkpointEvery / engine.generationsPerStep(), qint64(1)) : steps;
+    // whether the board has stabilised is checked between (shorter) batches
+    const qint64 stabilisationCheckSteps = 100;
+    qint64 stepsToCheckpoint = checkpointSteps;
+    qint64 stabilisedGeneration;
+    int stabilisedPeriod;
+    QFuture<QString> checkpointWrite;
+    bool checkpointWriting = false;
+    auto finishCheckpointWrite = [&checkpointWrite, &checkpointWriting]()->QString {
+        if (!checkpointWriting)
+            return QString();
+        checkpointWriting = false;
+        return checkpointWrite.result();
+    };
+    if (parser.isSet(recordOption))
+    {
+        QString errorMessage;
+        if (!engine.startRecordingHistory(parser.value(recordOption), recordKeyframes, errorMessage))
+        {
+            err << errorMessage << '\n';
+            return 1;
+        }
+    }
+    qint64 startGeneration = engine.generationNumber();
+    bool temporallyBlocked = engine.temporalBlockingApplies();
+    engine.resetStatistics();
+    QElapsedTimer et;
+    et.start();
+    while (steps > 0)
+    {
+        int batch = int(qMin(qMin(steps, stepsToCheckpoint), qint64(std::numeric_limits<int>::max())));
+        if (untilStabilised)
+            batch = int(qMin(qint64(batch), stabilisationCheckSteps));
+        engine.runSteps(batch);
+        steps -= batch;
+        stepsToCheckpoint -= batch;
+        if (untilStabilised && engine.stabilisation(stabilisedGeneration, stabilisedPeriod))
+            break;
+        if (periodicCheckpoints && steps > 0 && stepsToCheckpoint == 0)
+        {
+            stepsToCheckpoint = checkpointSteps;
+            const QString errorMessage(finishCheckpointWrite());
+            if (!errorMessage.isEmpty())
+            {
+                err << errorMessage << '\n';
+                return 1;
+            }
+            checkpointWrite = LifeCheckpoint::writeAsync(LifeCheckpoint::capture(engine, seed), checkpointFile, checkpointCompress);
+            checkpointWriting = true;
+        }
+    }
+    // (the time includes the history recorder catching up, as recording is only free while it keeps up)
+    QString recordError;
+    if (engine.historyRecording())
+        engine.stopRecordingHistory(recordError);
+    qint64 elapsedNsecs = qMax(et.nsecsElapsed(), qint64(1));
+    if (!recordError.isEmpty())
+    {
+        err << recordError << '\n';
+        return 1;
+    }
+    QString checkpointError(finishCheckpointWrite());
+    if (checkpointError.isEmpty() && !checkpointFile.isEmpty())
+        LifeCheckpoint::capture(engine, seed).write(checkpointFile, checkpointCompress, checkpointError);
+    if (!checkpointError.isEmpty())
+    {
+        err << checkpointError << '\n';
+        return 1;
+    }
+
+    qint64 generationsRun = engine.generationNumber() - startGeneration;
+    double elapsedSeconds = elapsedNsecs / 1e9;
+    QJsonObject result;
+    result["backend"] = backendNames[backend];
+    result["boardSize"] = size;
+    result["boardLayout"] = LifeEngine::boardLayoutName();
+    result["seed"] = qint64(seed);
+    if (parser.isSet(patternOption))
+        result["pattern"] = parser.value(patternOption);
+    result["recorded"] = parser.isSet(recordOption);
+    result["threads"] = threadMode == LifeEngine::ThreadsNone ? 1 : threadCount;
+    result["threadMode"] = threadModeNames[threadMode];
+    result["partition"] = threadMode == LifeEngine::ThreadsNumaWorkerPool ? partitionNames[LifeEngine::PartitionBanded] : partitionNames[partition];
+    // (for the worker pool's bands, the fraction of the boards' memory on a different NUMA node from the worker generating it)
+    if (backend == LifeEngine::BackendBoard && threadCount > 1
+            && (threadMode == LifeEngine::ThreadsNumaWorkerPool || (threadMode == LifeEngine::ThreadsWorkerPool && partition == LifeEngine::PartitionBanded)))
+    {
+        QJsonObject numaResult;
+        numaResult["topology"] = LifeNumaTopology::system().description();
+        numaResult["remotePageFraction"] = engine.remotePageFraction(threadCount);
+        result["numa"] = numaResult;
+    }
+    result["rule"] = engine.rule().toString();
+    result["wrap"] = engine.edgesWrap();
+    result["activeRegions"] = engine.activeRegionsOnly();
+    // (the generations each tile was advanced at a time, 1 if not temporally blocked)
+    result["temporalBlock"] = temporallyBlocked ? temporalBlock : 1;
+#if BOARD_BIT_PACKED
+    result["kernel"] = BitBoard::kernelName(BitBoard::kernel());
+#endif
+    result["generations"] = generationsRun;
+    result["elapsedSeconds"] = elapsedSeconds;
+    result["generationsPerSecond"] = generationsRun / elapsedSeconds;
+    // (ns per cell is relative to the initial board's area, which is only the whole universe for the board backend)
+    result["nsPerCell"] = generationsRun > 0 ? elapsedNsecs / (double(generationsRun) * size * size) : 0.0;
+    result["population"] = qint64(engine.population());
+    LifeGenerationStatistics statistics;
+    if (engine.generationStatistics(statistics))
+    {
+        QJsonObject statisticsResult;
+        statisticsResult["births"] = qint64(statistics.births);
+        statisticsResult["deaths"] = qint64(statistics.deaths);
+        if (!statistics.isEmpty())
+            statisticsResult["bounds"] = QJsonArray({ statistics.top, statistics.left, statistics.bottom, statistics.right });
+        result["lastGeneration"] = statisticsResult;
+    }
+    if (engine.stabilisation(stabilisedGeneration, stabilisedPeriod))
+    {
+        QJsonObject stabilisedResult;
+        stabilisedResult["generation"] = stabilisedGeneration;
+        stabilisedResult["period"] = stabilisedPeriod;
+        result["stabilised"] = stabilisedResult;
+    }
+    // the time per generation (or step), and how each thread's time was split between its share of the board and waiting for the others
+    const LifeMetrics::Sample metrics(engine.metrics().sample());
+    const LifeMetrics::Histogram &generationTimes(metrics.timings[LifeMetrics::TimingGeneration]);
+    QJsonObject metricsResult;
+    metricsResult["generationMeanUs"] = generationTimes.count > 0 ? generationTimes.totalNsecs / 1000.0 / generationTimes.count : 0.0;
+    metricsResult["generationP50Us"] = LifeMetrics::percentileNsecs(generationTimes, 50) / 1000;
+    metricsResult["generationP99Us"] = LifeMetrics::percentileNsecs(generationTimes, 99) / 1000;
+    QJsonArray threadResults;
+    for (const LifeMetrics::ThreadSample &thread : metrics.threads)
+    {
+        QJsonObject threadResult;
+        threadResult["cpu"] = thread.cpu;
+        threadResult["busyMs"] = thread.busyNsecs / 1e6;
+        threadResult["waitMs"] = thread.waitNsecs / 1e6;
+        threadResults.append(threadResult);
+    }
+    metricsResult["threads"] = threadResults;
+    result["metrics"] = metricsResult;
+
+    if (parser.isSet(saveOption))
+    {
+        QString errorMessage;
+        if (!LifePatternFile::save(parser.value(saveOption), engine, errorMessage))
+        {
+            err << errorMessage << '\n';
+            return 1;
+        }
+    }
+
+    QTextStream out(stdout);
+    out << QJsonDocument(result).toJson(QJsonDocument::Indented);
+    return 0;
+}
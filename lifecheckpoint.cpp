@@ -0,0 +1,179 @@
+#include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include "lifecheckpoint.h"
+
+
+////////// LifeCheckpoint Class //////////
+
+LifeCheckpoint::LifeCheckpoint()
+{
+    this->size = 0;
+    this->generation = 0;
+    this->wrap = false;
+    this->seed = 0;
+}
+
+/*static*/ LifeCheckpoint LifeCheckpoint::capture(const LifeEngine &engine, quint64 seed /*= 0*/)
+{
+    // take a checkpoint of the engine's state (the caller must stop the engine stepping meanwhile)
+    // `seed` is the random seed the run started from, saved for the caller to pick up again on restoring
+    LifeCheckpoint checkpoint;
+    checkpoint.size = engine.boardSize();
+    checkpoint.generation = engine.generationNumber();
+    checkpoint.rule = engine.rule();
+    checkpoint.wrap = engine.edgesWrap();
+    checkpoint.seed = seed;
+    checkpoint.words.resize(checkpoint.size * LifeEngine::packedWordsPerRow(checkpoint.size));
+    engine.packRows(0, checkpoint.size, checkpoint.words.data());
+    return checkpoint;
+}
+
+bool LifeCheckpoint::write(const QString &fileName, bool compress, QString &errorMessage) const
+{
+    // write the checkpoint to file `fileName`, compressing the tiles if `compress`
+    // the file is only replaced once it is completely written, so a crash while writing leaves the previous checkpoint intact
+    Q_ASSERT(!isEmpty());
+    int rowWords = LifeEngine::packedWordsPerRow(size);
+    int tileCount = (size + tileRows - 1) / tileRows;
+    FileHeader header;
+    memcpy(header.magic, fileMagic, sizeof(header.magic));
+    header.version = fileVersion;
+    header.flags = wrap ? FlagEdgesWrap : 0;
+    header.boardSize = size;
+    header.tileRows = tileRows;
+    header.tileCount = tileCount;
+    header.birthMask = rule.birthMask();
+    header.survivalMask = rule.survivalMask();
+    header.generation = generation;
+    header.seed = seed;
+
+    // compress (where it helps) and lay out the tiles, before writing anything
+    QVector<FileTile> tiles(tileCount);
+    QVector<QByteArray> compressedTiles(compress ? tileCount : 0);
+    quint64 offset = sizeof(FileHeader) + (tileCount * sizeof(FileTile));
+    for (int tile = 0; tile < tileCount; tile++)
+    {
+        int rows = qMin(tileRows, size - (tile * tileRows));
+        int length = rows * rowWords * int(sizeof(quint64));
+        const uchar *data = reinterpret_cast<const uchar *>(words.constData() + (tile * tileRows * rowWords));
+        if (compress)
+        {
+            compressedTiles[tile] = qCompress(data, length);
+            if (compressedTiles.at(tile).size() < length)
+                length = compressedTiles.at(tile).size();
+            else
+                compressedTiles[tile].clear();
+        }
+        tiles[tile].offset = offset;
+        tiles[tile].length = quint32(length);
+        tiles[tile].compressed = compress && !compressedTiles.at(tile).isEmpty();
+        offset += (quint64(length) + sizeof(quint64) - 1) & ~quint64(sizeof(quint64) - 1);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    static const char padding[sizeof(quint64)] = {};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(tiles.constData()), tileCount * int(sizeof(FileTile)));
+    for (int tile = 0; tile < tileCount; tile++)
+    {
+        if (tiles.at(tile).compressed)
+            file.write(compressedTiles.at(tile));
+        else
+            file.write(reinterpret_cast<const char *>(words.constData() + (tile * tileRows * rowWords)), tiles.at(tile).length);
+        file.write(padding, (sizeof(quint64) - (tiles.at(tile).length % sizeof(quint64))) % sizeof(quint64));
+    }
+    if (!file.commit())
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    return true;
+}
+
+/*static*/ QFuture<QString> LifeCheckpoint::writeAsync(const LifeCheckpoint &checkpoint, const QString &fileName, bool compress)
+{
+    // write `checkpoint` to file `fileName` (see `write()`) in a thread from Qt's global thread pool
+    // the future's result is the error message, empty if the write succeeded
+    return QtConcurrent::run([checkpoint, fileName, compress]() -> QString {
+        QString errorMessage;
+        checkpoint.write(fileName, compress, errorMessage);
+        return errorMessage;
+    });
+}
+
+/*static*/ bool LifeCheckpoint::restore(const QString &fileName, LifeEngine &engine, quint64 &seed, QString &errorMessage)
+{
+    // replace the engine's board, generation number, rule and edges by those in checkpoint file `fileName`
+    // and set `seed` to the random seed saved with it
+    // return false if the file cannot be read, or is not a valid checkpoint: the engine is left as it was,
+    // unless a compressed tile turns out to be corrupt, when it is left with an empty board
+    QFile file(fileName);
+    auto fail = [&errorMessage, &fileName](const QString &message)->bool {
+        errorMessage = QString("%1: %2").arg(fileName).arg(message);
+        return false;
+    };
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(file.errorString());
+    qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(FileHeader)))
+        return fail("not a checkpoint file");
+    const uchar *data = file.map(0, fileSize);
+    if (data == nullptr)
+        return fail(file.errorString());
+
+    // validate everything before touching the engine
+    FileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, fileMagic, sizeof(header.magic)) != 0)
+        return fail("not a checkpoint file");
+    if (header.version != fileVersion)
+        return fail(QString("unsupported checkpoint version %1").arg(header.version));
+    if (header.boardSize <= 0 || header.tileRows <= 0 || header.tileCount != (header.boardSize + header.tileRows - 1) / header.tileRows
+            || qint64(sizeof(FileHeader) + (header.tileCount * sizeof(FileTile))) > fileSize)
+        return fail("corrupt checkpoint header");
+    if (header.birthMask >= (1 << 9) || header.survivalMask >= (1 << 9) || (header.birthMask & 1))
+        return fail("unsupported rule");
+    const FileTile *tiles = reinterpret_cast<const FileTile *>(data + sizeof(FileHeader));
+    int rowWords = LifeEngine::packedWordsPerRow(header.boardSize);
+    for (int tile = 0; tile < header.tileCount; tile++)
+    {
+        const FileTile &fileTile(tiles[tile]);
+        int rows = qMin(header.tileRows, header.boardSize - (tile * header.tileRows));
+        quint64 length = quint64(rows) * quint64(rowWords) * sizeof(quint64);
+        if (fileTile.offset % sizeof(quint64) != 0 || fileTile.offset + fileTile.length > quint64(fileSize)
+                || (!fileTile.compressed && fileTile.length != length))
+            return fail(QString("corrupt checkpoint tile %1").arg(tile));
+    }
+
+    engine.newBoard(header.boardSize);
+    engine.setRule(LifeRule(header.birthMask, header.survivalMask));
+    engine.setEdgesWrap(header.flags & FlagEdgesWrap);
+    for (int tile = 0; tile < header.tileCount; tile++)
+    {
+        const FileTile &fileTile(tiles[tile]);
+        int yStart = tile * header.tileRows;
+        int yEnd = qMin(yStart + header.tileRows, header.boardSize);
+        if (!fileTile.compressed)
+        {
+            engine.unpackRows(yStart, yEnd, reinterpret_cast<const quint64 *>(data + fileTile.offset));
+            continue;
+        }
+        const QByteArray rows(qUncompress(data + fileTile.offset, int(fileTile.length)));
+        if (rows.size() != (yEnd - yStart) * rowWords * int(sizeof(quint64)))
+        {
+            engine.newBoard();
+            return fail(QString("corrupt checkpoint tile %1").arg(tile));
+        }
+        engine.unpackRows(yStart, yEnd, reinterpret_cast<const quint64 *>(rows.constData()));
+    }
+    engine.setGenerationNumber(header.generation);
+    seed = header.seed;
+    return true;
+}
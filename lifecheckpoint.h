@@ -0,0 +1,65 @@
+#ifndef LIFECHECKPOINT_H
+#define LIFECHECKPOINT_H
+
+#include <QFuture>
+#include <QString>
+#include <QVector>
+
+#include "lifeengine.h"
+#include "liferule.h"
+
+// a checkpoint of the simulation's state: the board's cells, generation number, rule, edges and random seed
+// `capture()` takes a copy of the board, packed 64 cells to a word, which is quick enough to do between generations,
+// and the copy can then be written out (compressing if asked) in a background thread with `writeAsync()` while the run carries on
+// `restore()` maps the file into memory, so that (uncompressed) rows are copied straight from the page cache into the board
+//
+// the file is a header, then an index of the tiles (bands of `tileRows` rows), then each tile's packed rows,
+// either as they are or, if that is smaller, compressed with `qCompress()`
+// it is in the byte order of the machine which wrote it: checkpoints are for resuming runs, not for exchanging patterns
+class LifeCheckpoint
+{
+public:
+    static constexpr int tileRows = 64;
+
+    LifeCheckpoint();
+
+    static LifeCheckpoint capture(const LifeEngine &engine, quint64 seed = 0);
+    bool isEmpty() const { return size == 0; }
+    qint64 generationNumber() const { return generation; }
+    quint64 randomSeed() const { return seed; }
+
+    bool write(const QString &fileName, bool compress, QString &errorMessage) const;
+    static QFuture<QString> writeAsync(const LifeCheckpoint &checkpoint, const QString &fileName, bool compress);
+    static bool restore(const QString &fileName, LifeEngine &engine, quint64 &seed, QString &errorMessage);
+
+private:
+    static constexpr char fileMagic[8] = { 'L', 'I', 'F', 'E', 'C', 'K', 'P', 'T' };
+    static constexpr quint32 fileVersion = 1;
+    enum FileFlag : quint32 { FlagEdgesWrap = 1 };
+    struct FileHeader {
+        char magic[8];
+        quint32 version;
+        quint32 flags;
+        qint32 boardSize;
+        qint32 tileRows;
+        qint32 tileCount;
+        quint16 birthMask, survivalMask;
+        qint64 generation;
+        quint64 seed;
+    };
+    // each tile's data starts on a word boundary, so that uncompressed tiles can be copied from the mapped file a word at a time
+    struct FileTile {
+        quint64 offset;
+        quint32 length;
+        quint32 compressed;
+    };
+
+    int size;
+    qint64 generation;
+    LifeRule rule;
+    bool wrap;
+    quint64 seed;
+    QVector<quint64> words;
+};
+
+#endif // LIFECHECKPOINT_H
@@ -0,0 +1,1936 @@
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QtConcurrent>
+#include <QThread>
+
+#include "lifeengine.h"
+#include "lifenuma.h"
+#include "liferandom.h"
+
+
+////////// Cell Generation Kernels //////////
+
+// the kernels for boards of cells (rather than bit-packed boards) are written once, as templates over
+// - how the board's edges are treated: dead, wrapped around, or already filled in a ghost border round the board
+// - the rule: B3/S23 (Conway's Life) is tested inline, any other rule is looked up in its table
+// every combination is instantiated, and `LifeEngine::selectCellKernel()` picks one whenever the edges or rule change,
+// so the inner loop has no per-cell tests of the settings, and its only bounds checks are in the first & last columns
+// a kernel is given pointers to a row's cells and to those of the rows above & below, so it serves every board layout
+
+enum CellKernelEdges { DeadEdges, WrappedEdges, GhostBorder };
+
+template <bool Conway>
+static inline bool cellNextState(const LifeRule &rule, bool occupied, int neighbours)
+{
+    // RULES: 3 neighbours => birth/survival, 2 neighbours => survival only (or whatever `rule` says)
+    return Conway ? (neighbours == 3 || (occupied && neighbours == 2)) : rule.nextState(occupied, neighbours);
+}
+
+template <CellKernelEdges Edges>
+static inline int countEdgeColumnNeighbours(const LifeEngine::BoardCell *above, const LifeEngine::BoardCell *row, const LifeEngine::BoardCell *below,
+                                            int x, int columns)
+{
+    // return how many neighbours a cell in the first or last column has, where the columns beyond are dead or wrap around
+    int neighbours = above[x].occupied + below[x].occupied;
+    int xLeft = x - 1, xRight = x + 1;
+    if (Edges == WrappedEdges)
+    {
+        if (xLeft < 0)
+            xLeft = columns - 1;
+        if (xRight >= columns)
+            xRight = 0;
+    }
+    if (xLeft >= 0)
+        neighbours += above[xLeft].occupied + row[xLeft].occupied + below[xLeft].occupied;
+    if (xRight < columns)
+        neighbours += above[xRight].occupied + row[xRight].occupied + below[xRight].occupied;
+    return neighbours;
+}
+
+template <CellKernelEdges Edges, bool Conway>
+static void stepCells(const LifeEngine::BoardCell *above, const LifeEngine::BoardCell *row, const LifeEngine::BoardCell *below, LifeEngine::BoardCell *newRow,
+                      int xStart, int xEnd, int columns, const LifeRule &rule)
+{
+    // populate cells `xStart` to `xEnd - 1` of `newRow` from `row`, and the rows `above` & `below` it, all `columns` cells wide
+    // (above/below the board's top/bottom edge, the caller passes the wrapped-around row, or a row of empty cells)
+    if (Edges == GhostBorder)
+    {
+        // the ghost border means every cell's 3x3 neighbourhood can be read without bounds checks,
+        // and it is kept as a 9-bit index into the rule's table, moving one column to the right each cell
+        auto column = [above, row, below](int x) { return above[x].occupied | (row[x].occupied << 1) | (below[x].occupied << 2); };
+        int neighbourhood = (column(xStart - 1) << 3) | (column(xStart) << 6);
+        for (int x = xStart; x < xEnd; x++)
+        {
+            neighbourhood = (neighbourhood >> 3) | (column(x + 1) << 6);
+            newRow[x].occupied = rule.nextState3x3(neighbourhood);
+        }
+        return;
+    }
+    int x = xStart;
+    if (x == 0 && x < xEnd)
+    {
+        newRow[0].occupied = cellNextState<Conway>(rule, row[0].occupied, countEdgeColumnNeighbours<Edges>(above, row, below, 0, columns));
+        x++;
+    }
+    int xInteriorEnd = qMin(xEnd, columns - 1);
+    for (; x < xInteriorEnd; x++)
+    {
+        int neighbours = above[x - 1].occupied + above[x].occupied + above[x + 1].occupied
+                + row[x - 1].occupied + row[x + 1].occupied
+                + below[x - 1].occupied + below[x].occupied + below[x + 1].occupied;
+        newRow[x].occupied = cellNextState<Conway>(rule, row[x].occupied, neighbours);
+    }
+    for (; x < xEnd; x++)
+        newRow[x].occupied = cellNextState<Conway>(rule, row[x].occupied, countEdgeColumnNeighbours<Edges>(above, row, below, x, columns));
+}
+
+// indexed by [edges][rule is B3/S23]
+static const LifeEngine::CellKernel cellKernels[3][2] = {
+    { stepCells<DeadEdges, false>, stepCells<DeadEdges, true> },
+    { stepCells<WrappedEdges, false>, stepCells<WrappedEdges, true> },
+    { stepCells<GhostBorder, false>, stepCells<GhostBorder, true> },
+};
+
+#if !BOARD_BIT_PACKED
+// (a bit-packed board's rows are added up a word at a time by `BitBoard`)
+static void addRowStatistics(const LifeEngine::BoardCell *row, const LifeEngine::BoardCell *newRow, int y, int xStart, int xEnd, int columns,
+                             LifeGenerationStatistics &statistics)
+{
+    // add the population, births, deaths & hash of cells `xStart` to `xEnd - 1` of a newly generated row `newRow` (from `row`),
+    // of a board `columns` wide, to `statistics`
+    // (counted in a loop without branches, then the first & last occupied cells are found from either end)
+    quint64 population = 0, births = 0, deaths = 0, hash = 0;
+    for (int x = xStart; x < xEnd; x++)
+    {
+        int occupied = row[x].occupied, newOccupied = newRow[x].occupied;
+        hash += LifeGenerationStatistics::positionHash(quint64(y) * columns + x, 1) & (0 - quint64(newOccupied));
+        population += newOccupied;
+        births += newOccupied & ~occupied;
+        deaths += occupied & ~newOccupied;
+    }
+    int xFirst = xStart, xLast = xEnd - 1;
+    if (population > 0)
+    {
+        while (!newRow[xFirst].occupied)
+            xFirst++;
+        while (!newRow[xLast].occupied)
+            xLast--;
+    }
+    statistics.addRow(y, population, births, deaths, xFirst, xLast, hash);
+}
+#endif
+
+
+////////// LifeEngine Class //////////
+
+LifeEngine::LifeEngine()
+{
+#if !BOARD_BIT_PACKED && !BOARD_CONTIGUOUS && BOARD_C_ARRAYS
+    board0 = board1 = nullptr;
+#endif
+    this->size = 0;
+    this->generation = 0;
+    this->lastRandomSeed = 0;
+    this->currentBackend = BackendBoard;
+    this->currentThreadMode = ThreadsNone;
+    this->threads = QThread::idealThreadCount();
+    this->currentPartitionMode = PartitionInterleaved;
+    this->placedWorkerCount = 0;
+    this->blockGenerations = 1;
+    this->wrap = false;
+    selectCellKernel();
+    this->activeRegions = false;
+    this->trackChanges = false;
+    this->trackAges = false;
+    this->trackStatistics = false;
+    this->lastStatisticsKnown = this->previousStatisticsKnown = false;
+    this->stepRegion = { 0, 0, 0, 0 };
+    this->recentGenerationCount = this->recentGenerationNext = 0;
+    this->stabilisedGeneration = 0;
+    this->stabilisedPeriod = 0;
+    this->allChangedUntaken = true;
+    this->activeTileRows = this->activeTileColumns = 0;
+    this->activeTileStatistics.total = this->activeTileStatistics.last = 0;
+    this->log2Step = 0;
+    this->historyFrameWords = nullptr;
+    hashLife.setMemoryLimit(hashLifeDefaultMemoryLimit);
+    workerPool.setMetrics(&runMetrics);
+
+    // create an empty board
+    newBoard(defaultBoardSize);
+}
+
+LifeEngine::~LifeEngine()
+{
+    deleteBoard(board0);
+    deleteBoard(board1);
+}
+
+/*static*/ const QVector<LifeEngine::CategoryFormations> &LifeEngine::formationCategories()
+{
+    // return the catalogue of formations, by category
+    // each formation's deltas are (x, y) offsets from where it is placed
+    static const QVector<CategoryFormations> categories = {
+        { "Still Lifes",
+          {
+              { "Block", { {0,0}, {1,0}, {0,1}, {1,1} } },
+              { "Beehive", { {1,0}, {2,0}, {0,1}, {3,1}, {1,2}, {2,2} } },
+          }
+        },
+        { "Oscillators",
+          {
+              { "Blinker", { {0,0}, {1,0}, {2,0} } },
+              { "Beacon", { {0,0}, {0,1}, {1,0}, {3,2}, {2,3}, {3,3} } },
+              { "Toad", { {1,0}, {2,0}, {0,1}, {3,2}, {1,3}, {2,3} } },
+              { "Clock", { {2,0}, {0,1}, {2,1}, {1,2}, {3,2}, {1,3} } },
+          }
+        },
+        { "Spaceships",
+          {
+              { "Glider", { {3,1}, {1,1}, {3,2}, {2,3}, {3,3} } },
+          }
+        },
+        { "Glider Guns",
+          {
+              { "Gosper Glider Gun", {
+                    {23,1},
+                    {22,2}, {24,2},
+                    {12,3}, {13,3}, {21,3}, {23,3}, {24,3}, {35,3}, {36,3},
+                    {11,4}, {13,4}, {20,4}, {21,4}, {23,4}, {24,4}, {35,4}, {36,4},
+                    {1,5}, {2,5}, {10,5}, {17,5}, {18,5}, {19,5}, {21,5}, {23,5}, {24,5},
+                    {1,6}, {2,6}, {10,6}, {13,6}, {16,6}, {19,6}, {22,6}, {24,6},
+                    {10,7}, {17,7}, {18,7}, {23,7},
+                    {11,8}, {13,8},
+                    {12,9}, {13,9},
+                }
+              },
+          }
+        },
+    };
+    return categories;
+}
+
+void LifeEngine::setBackend(Backend backend)
+{
+    // set the backend, copying the cells across from the old one
+    if (backend == currentBackend)
+        return;
+    copyBackendToBoard();
+    currentBackend = backend;
+    loadBackendFromBoard();
+    this->allChangedUntaken = true;
+}
+
+/*static*/ QString LifeEngine::backendName(Backend backend)
+{
+    switch (backend)
+    {
+    case BackendBoard: return "Board";
+    case BackendHashLife: return "HashLife";
+    case BackendUnbounded: return "Unbounded";
+    }
+    return QString();
+}
+
+/*static*/ QString LifeEngine::boardLayoutName()
+{
+    // return the name of the board's storage layout, which this build was compiled with
+#if BOARD_BIT_PACKED
+    return "Bit-packed";
+#elif BOARD_CONTIGUOUS
+    return "Contiguous";
+#elif BOARD_C_ARRAYS
+    return "C arrays";
+#else
+    return "QVector";
+#endif
+}
+
+/*static*/ QString LifeEngine::threadModeName(ThreadMode mode)
+{
+    switch (mode)
+    {
+    case ThreadsNone: return "No threads";
+    case ThreadsQtConcurrent: return "QtConcurrent";
+    case ThreadsQThreads: return "QThreads";
+    case ThreadsWorkerPool: return "Worker pool";
+    case ThreadsNumaWorkerPool: return "NUMA-local worker pool";
+    }
+    return QString();
+}
+
+void LifeEngine::setThreadCount(int threadCount)
+{
+    Q_ASSERT(threadCount > 0);
+    this->threads = threadCount;
+}
+
+/*static*/ QString LifeEngine::partitionModeName(PartitionMode mode)
+{
+    switch (mode)
+    {
+    case PartitionInterleaved: return "Interleaved";
+    case PartitionBanded: return "Banded";
+    case PartitionTiled: return "Tiled";
+    }
+    return QString();
+}
+
+void LifeEngine::setRule(const LifeRule &rule)
+{
+    // set the rule, for the board and the backends
+    this->currentRule = rule;
+    hashLife.setRule(rule);
+    universe.setRule(rule);
+    selectCellKernel();
+    markAllTilesChanged();
+}
+
+void LifeEngine::setEdgesWrap(bool wrap)
+{
+    this->wrap = wrap;
+    selectCellKernel();
+    markAllTilesChanged();
+}
+
+void LifeEngine::selectCellKernel()
+{
+    // select the cell generation kernel for the edges & rule
+    // (a ghost border already holds the wrapped-around or dead cells beyond the edges)
+#if BOARD_CONTIGUOUS
+    CellKernelEdges edges = GhostBorder;
+#else
+    CellKernelEdges edges = wrap ? WrappedEdges : DeadEdges;
+#endif
+    this->cellKernel = cellKernels[edges][currentRule.isConway()];
+}
+
+void LifeEngine::setActiveRegionsOnly(bool activeRegionsOnly)
+{
+    // (the per-tile changed flags are not maintained while it is off, so all tiles are marked changed when it is turned on)
+    this->activeRegions = activeRegionsOnly;
+    markAllTilesChanged();
+}
+
+void LifeEngine::setTrackChangedTiles(bool track)
+{
+    // (as with active regions, the per-tile changed flags are not maintained while off, so all tiles are marked changed)
+    this->trackChanges = track;
+    markAllTilesChanged();
+}
+
+void LifeEngine::setTrackAges(bool track)
+{
+    // set whether the board's cells' ages are tracked (only while the counters are shown in colour)
+    // the age plane is only allocated while tracked, and all ages start from 0 when it is turned on
+    if (track == trackAges)
+        return;
+    this->trackAges = track;
+    if (track)
+        clearAges();
+    else
+    {
+        ages.clear();
+        ages.squeeze();
+    }
+}
+
+void LifeEngine::setTrackStatistics(bool track)
+{
+    // set whether each generation's statistics are gathered as it is generated (see `generationStatistics()`)
+    // they are first known once the next generation has been generated
+    // (the per-tile statistics are not maintained while off, so all tiles are marked changed, to be generated afresh)
+    if (track == trackStatistics)
+        return;
+    this->trackStatistics = track;
+    markAllTilesChanged();
+}
+
+void LifeEngine::clearAges()
+{
+    // set every cell's age to 0 (if ages are tracked)
+    if (trackAges)
+        ages.fill(0, size * size);
+}
+
+void LifeEngine::setTemporalBlockGenerations(int generations)
+{
+    // set how many generations `runSteps()` advances each tile of the board at a time (1 for none, see `runTemporalBlocks()`)
+    Q_ASSERT(generations >= 1 && generations <= maxTemporalBlockGenerations);
+    this->blockGenerations = generations;
+}
+
+bool LifeEngine::temporalBlockingApplies() const
+{
+    // return whether `runSteps()` temporally blocks the board's generations (see `runTemporalBlocks()`)
+    // only the last generation of each block is ever on the board, so not while anything is tracked or recorded every generation
+    // (ages, statistics, changed or active tiles, history), nor for threads started afresh every generation (QtConcurrent/QThreads)
+    return blockGenerations > 1 && currentBackend == BackendBoard && (currentThreadMode == ThreadsNone || usesWorkerPool())
+            && !trackAges && !trackStatistics && !activeRegions && !trackChanges && !historyRecorder.isRecording();
+}
+
+void LifeEngine::setHashLifeLog2Step(int log2Step)
+{
+    Q_ASSERT(log2Step >= 0 && log2Step < 62);
+    this->log2Step = log2Step;
+}
+
+void LifeEngine::createOrClearBoard(Board &board)
+{
+    // create a new board (or clear the existing one)
+    allocateBoard(board);
+    createOrClearRows(board, 0, size);
+}
+
+void LifeEngine::createOrClearBoards(int workerCount)
+{
+    // create (or clear) board0 & board1
+    // for `workerCount` (more than one) workers in the NUMA-local worker pool, each worker creates & clears its own band of rows of both boards,
+    // the same band as it generates (see `stepPass1Partition()`), so that it is the first to touch them,
+    // which puts their memory on its own node (the operating system places each page on the node of the thread which first touches it)
+    // otherwise (`workerCount` 0) the calling thread creates & clears them all
+    // if they were placed for a different number of workers (or not at all, or were placed but now should not be), they are re-created
+    Q_ASSERT(workerCount == 0 || workerCount > 1);
+    if (workerCount != placedWorkerCount)
+    {
+        deleteBoard(board0);
+        deleteBoard(board1);
+    }
+    allocateBoard(board0);
+    allocateBoard(board1);
+    auto createOrClearBands = [this](int workerIndex, int workerCount)->void {
+        int yStart = size * workerIndex / workerCount, yEnd = size * (workerIndex + 1) / workerCount;
+        createOrClearRows(board0, yStart, yEnd);
+        createOrClearRows(board1, yStart, yEnd);
+    };
+    if (workerCount > 0)
+    {
+        workerPool.setNumaLocal(true);
+        workerPool.setThreadCount(workerCount);
+        workerPool.run(1, createOrClearBands, nullptr);
+        this->placedWorkerCount = workerCount;
+    }
+    else
+        createOrClearBands(0, 1);
+}
+
+void LifeEngine::placeBoards(int workerCount)
+{
+    // re-create board0 & board1 placed for `workerCount` workers (see `createOrClearBoards()`), keeping the cells & their ages
+    // (`nextBoard` no longer holds the last generation)
+    QVector<quint64> words(size * packedWordsPerRow(size));
+    packRows(0, size, words.data());
+    QVector<quint8> savedAges(ages);
+    createOrClearBoards(workerCount);
+    unpackRows(0, size, words.data());
+    this->ages = savedAges;
+}
+
+void LifeEngine::allocateBoard(Board &board)
+{
+    // allocate a board of `size` x `size` cells, if not already allocated, without touching its cells,
+    // which are left for `createOrClearRows()` to create (or clear)
+#if BOARD_BIT_PACKED || BOARD_CONTIGUOUS
+    board.resize(size, size, false);
+#elif BOARD_C_ARRAYS
+    if (board == nullptr)
+    {
+        board = new BoardRow[size];
+        for (int i = 0; i < size; i++)
+            board[i] = nullptr;
+    }
+#else
+    board.resize(size);
+#endif
+}
+
+void LifeEngine::createOrClearRows(Board &board, int yStart, int yEnd)
+{
+    // create (or clear) rows `yStart` to `yEnd - 1` of a board allocated by `allocateBoard()`
+    Q_ASSERT(yStart >= 0 && yStart <= yEnd && yEnd <= size);
+#if BOARD_BIT_PACKED
+    board.clearRows(yStart, yEnd);
+#elif BOARD_CONTIGUOUS
+    board.fillRows(yStart, yEnd, BoardCell());
+#elif BOARD_C_ARRAYS
+    BoardCell cell;
+    for (int i = yStart; i < yEnd; i++)
+    {
+        // each row starts a cache line (see `stepPass1Partition()`)
+        if (board[i] == nullptr)
+            board[i] = static_cast<BoardCell *>(qMallocAligned(size_t(size) * sizeof(BoardCell), 64));
+        for (int j = 0; j < size; j++)
+            new (&board[i][j]) BoardCell(cell);
+    }
+#else
+    BoardCell cell;
+    for (int i = yStart; i < yEnd; i++)
+    {
+        board[i].resize(size);
+        board[i].fill(cell);
+    }
+#endif
+}
+
+void LifeEngine::deleteBoard(Board &board)
+{
+    // delete a board, releasing its memory (C arrays are deleted, the others are resized to nothing)
+    // (after which the boards are no longer placed for any workers, see `createOrClearBoards()`)
+#if BOARD_BIT_PACKED || BOARD_CONTIGUOUS
+    board.resize(0, 0, false);
+#elif BOARD_C_ARRAYS
+    if (board != nullptr)
+    {
+        for (int i = 0; i < BOARD_COUNT(board); i++)
+            if (board[i] != nullptr)
+                qFreeAligned(board[i]);
+        delete[] board;
+    }
+    board = nullptr;
+#else
+    board.clear();
+#endif
+    this->placedWorkerCount = 0;
+}
+
+void LifeEngine::newBoard(int boardSize)
+{
+    // create or clear board0 & board1, of `boardSize` x `boardSize` cells, and clear the other backends
+    Q_ASSERT(boardSize > 0);
+    if (boardSize != size)
+    {
+        deleteBoard(board0);
+        deleteBoard(board1);
+        this->size = boardSize;
+        this->activeTileRows = (size + activeTileHeight - 1) / activeTileHeight;
+        this->activeTileColumns = (size + activeTileWidth - 1) / activeTileWidth;
+        tileChangedLast.fill(true, activeTileRows * activeTileColumns);
+        tileChangedNext.fill(true, activeTileRows * activeTileColumns);
+        tileChangedUntaken.fill(false, activeTileRows * activeTileColumns);
+        tileStatistics.fill(LifeGenerationStatistics(), activeTileRows * activeTileColumns);
+    }
+    createOrClearBoards(currentThreadMode == ThreadsNumaWorkerPool && threads > 1 ? threads : 0);
+    emptyRow.fill(BoardCell(), size);
+    clearAges();
+    this->curBoard = &this->board0;
+    this->nextBoard = &this->board1;
+    markAllTilesChanged();
+    hashLife.clear();
+    universe.clear();
+    this->generation = 0;
+}
+
+void LifeEngine::randomize(quint64 seed, double density /*= 0.5*/)
+{
+    // clear the board and randomly fill it with counters, from `seed`
+    // each cell is occupied with probability `density` (to 1/65536)
+    // the rows are filled 64 cells at a time from a counter-based generator (see `LifeRandom`), in the worker pool if using threads,
+    // so the board is the same for the same seed whatever the thread count
+    Q_ASSERT(density >= 0 && density <= 1);
+    newBoard();
+    this->lastRandomSeed = seed;
+    Board &board(*curBoard);
+    auto fillRows = [this, &board, seed, density](int workerIndex, int workerCount)->void {
+        int rowWords = packedWordsPerRow(size);
+#if BOARD_BIT_PACKED
+        for (int y = workerIndex; y < size; y += workerCount)
+        {
+            BitBoard::Word *row = board.rowWords(y);
+            LifeRandom::fillRow(seed, y, density, row, rowWords);
+            row[rowWords - 1] &= board.lastRowWordMask();
+        }
+#else
+        QVector<quint64> words(rowWords);
+        for (int y = workerIndex; y < size; y += workerCount)
+        {
+            LifeRandom::fillRow(seed, y, density, words.data(), rowWords);
+            for (int x = 0; x < size; x++)
+                BOARDCELL_SET_OCCUPIED(board, y, x, (words.at(x / 64) >> (x % 64)) & 1);
+        }
+#endif
+    };
+    int threadCount = currentThreadMode == ThreadsNone ? 1 : qMin(threads, size);
+    if (threadCount > 1)
+    {
+        workerPool.setNumaLocal(currentThreadMode == ThreadsNumaWorkerPool);
+        workerPool.setThreadCount(threadCount);
+        workerPool.run(1, fillRows, nullptr);
+    }
+    else
+        fillRows(0, 1);
+    loadBackendFromBoard();
+}
+
+bool LifeEngine::positionIsValid(int y, int x) const
+{
+    // return whether a board position is within the bounds of the board
+    // (any position is valid in the unbounded backends)
+    if (currentBackend != BackendBoard)
+        return true;
+    const Board &board(*curBoard);
+    return (y >= 0 && y < BOARD_COUNT(board)
+            && x >= 0 && x < BOARDROW_COUNT(BOARDROW_AT(board, y)));
+}
+
+LifeEngine::Cell LifeEngine::cellAt(int y, int x) const
+{
+    // return the cell at a (valid) board position
+    Q_ASSERT(positionIsValid(y, x));
+    switch (currentBackend)
+    {
+    case BackendBoard: return Cell{BOARDCELL_AT((*curBoard), y, x).occupied, trackAges ? ages.at(y * size + x) : quint8(0)};
+    case BackendHashLife: return Cell{hashLife.cellAt(y - (size / 2), x - (size / 2))};
+    case BackendUnbounded: return Cell{universe.cellAt(y, x)};
+    }
+    return Cell();
+}
+
+void LifeEngine::setCellAt(int y, int x, bool occupied)
+{
+    // set whether the cell at a (valid) board position is occupied
+    Q_ASSERT(positionIsValid(y, x));
+    switch (currentBackend)
+    {
+    case BackendBoard: {
+        Board &board(*curBoard);
+        BOARDCELL_SET_OCCUPIED(board, y, x, occupied);
+        if (trackAges)
+            ages[y * size + x] = 0;
+        markTileChanged(y, x);
+        break;
+    }
+    case BackendHashLife: hashLife.setCellAt(y - (size / 2), x - (size / 2), occupied); break;
+    case BackendUnbounded: universe.setCellAt(y, x, occupied); break;
+    }
+}
+
+void LifeEngine::setCellRun(int y, int x, int length)
+{
+    // occupy the run of `length` cells from board position (y, x) rightwards (clipped to valid positions)
+    // (for loading patterns, which are mostly runs of cells, without going through `setCellAt()` for each cell of the board)
+    switch (currentBackend)
+    {
+    case BackendBoard: {
+        if (y < 0 || y >= size)
+            return;
+        int xEnd = qMin(x + length, size);
+        x = qMax(x, 0);
+        if (x >= xEnd)
+            return;
+        Board &board(*curBoard);
+        for (int i = x; i < xEnd; i++)
+            BOARDCELL_SET_OCCUPIED(board, y, i, true);
+        if (trackAges)
+            memset(ages.data() + y * size + x, 0, size_t(xEnd - x));
+        for (int i = x; i < xEnd; i += activeTileWidth - (i % activeTileWidth))
+            markTileChanged(y, i);
+        break;
+    }
+    case BackendHashLife:
+        for (int i = 0; i < length; i++)
+            hashLife.setCellAt(y - (size / 2), x + i - (size / 2), true);
+        break;
+    case BackendUnbounded:
+        for (int i = 0; i < length; i++)
+            universe.setCellAt(y, x + i, true);
+        break;
+    }
+}
+
+void LifeEngine::placeFormation(const Formation &formation, int y, int x)
+{
+    // place a formation with its top-left at board position (y, x), clipped to valid positions
+    for (const QPoint &delta : formation.deltas)
+        if (positionIsValid(y + delta.y(), x + delta.x()))
+            setCellAt(y + delta.y(), x + delta.x(), true);
+}
+
+void LifeEngine::forEachLiveCell(int top, int left, int rows, int columns, const std::function<void(int y, int x, const Cell &cell)> &callback) const
+{
+    // call `callback(y, x, cell)` for each occupied cell within the `rows` x `columns` board positions whose top-left is at (top, left)
+    switch (currentBackend)
+    {
+    case BackendBoard: {
+        const Board &board(*curBoard);
+        int yEnd = qMin(top + rows, BOARD_COUNT(board)), xEnd = qMin(left + columns, size);
+        for (int y = qMax(top, 0); y < yEnd; y++)
+            for (int x = qMax(left, 0); x < xEnd; x++)
+                if (BOARDCELL_AT(board, y, x).occupied)
+                    callback(y, x, Cell{true, trackAges ? ages.at(y * size + x) : quint8(0)});
+        break;
+    }
+    case BackendHashLife: {
+        const Cell cell{true};
+        hashLife.forEachLiveCell(qint64(top) - (size / 2), qint64(left) - (size / 2), rows, columns,
+                                 [&](int y, int x)->void { callback(top + y, left + x, cell); });
+        break;
+    }
+    case BackendUnbounded: {
+        const Cell cell{true};
+        universe.forEachLiveCell(top, left, rows, columns,
+                                 [&](qint64 y, qint64 x)->void { callback(int(y), int(x), cell); });
+        break;
+    }
+    }
+}
+
+void LifeEngine::forEachLiveRun(int y, const std::function<void(int x, int length)> &callback) const
+{
+    // call `callback(x, length)` for each run of occupied cells, left to right, in row `y` of the board positions
+    // (for saving patterns, which are written a run at a time)
+    Q_ASSERT(y >= 0 && y < size);
+    if (currentBackend != BackendBoard)
+    {
+        for (int x = 0; x < size; x++)
+            if (cellAt(y, x).occupied)
+            {
+                int xStart = x;
+                while (x + 1 < size && cellAt(y, x + 1).occupied)
+                    x++;
+                callback(xStart, x + 1 - xStart);
+            }
+        return;
+    }
+    const Board &board(*curBoard);
+#if BOARD_BIT_PACKED
+    // find the start & end of each run a word at a time
+    const BitBoard::Word *words = board.rowWords(y);
+    auto nextCell = [words, this](int x, bool occupied)->int {
+        // return the first column from `x` whose cell is (or is not) occupied, or `size` if there is none
+        while (x < size)
+        {
+            int i = x / BitBoard::bitsPerWord;
+            BitBoard::Word word = (occupied ? words[i] : ~words[i]) & (~BitBoard::Word(0) << (x % BitBoard::bitsPerWord));
+            if (word != 0)
+                return qMin(size, (i * BitBoard::bitsPerWord) + int(qCountTrailingZeroBits(word)));
+            x = (i + 1) * BitBoard::bitsPerWord;
+        }
+        return size;
+    };
+    for (int x = nextCell(0, true); x < size; )
+    {
+        int xEnd = nextCell(x, false);
+        callback(x, xEnd - x);
+        x = nextCell(xEnd, true);
+    }
+#else
+    const BoardCell *row = BOARDROW_CELLS(board, y);
+    for (int x = 0; x < size; x++)
+        if (row[x].occupied)
+        {
+            int xStart = x;
+            while (x + 1 < size && row[x + 1].occupied)
+                x++;
+            callback(xStart, x + 1 - xStart);
+        }
+#endif
+}
+
+void LifeEngine::packRows(int yStart, int yEnd, quint64 *words) const
+{
+    // pack the cells of board rows `yStart` to `yEnd` (exclusive) into `words`, `packedWordsPerRow()` words per row
+    // (for checkpoints: on the bit-packed board this is a copy of each row's words)
+    Q_ASSERT(yStart >= 0 && yStart <= yEnd && yEnd <= size);
+    int rowWords = packedWordsPerRow(size);
+    if (currentBackend != BackendBoard)
+    {
+        memset(words, 0, size_t(yEnd - yStart) * size_t(rowWords) * sizeof(quint64));
+        forEachLiveCell(yStart, 0, yEnd - yStart, size, [words, rowWords, yStart](int y, int x, const Cell &)->void {
+            words[((y - yStart) * rowWords) + (x / 64)] |= quint64(1) << (x % 64);
+        });
+        return;
+    }
+    const Board &board(*curBoard);
+    for (int y = yStart; y < yEnd; y++, words += rowWords)
+    {
+#if BOARD_BIT_PACKED
+        static_assert(sizeof(BitBoard::Word) == sizeof(quint64), "BitBoard words are not 64 bits");
+        memcpy(words, board.rowWords(y), size_t(rowWords) * sizeof(quint64));
+        words[rowWords - 1] &= board.lastRowWordMask();
+#else
+        // (without branching on each cell, as whether cells are occupied is unpredictable)
+        // 8 cells at a time, their bytes (each 0 or 1) gathered into the top byte of a multiplication, the first cell's in its lowest bit
+        static_assert(sizeof(BoardCell) == 1, "BoardCell is not one byte");
+        const BoardCell *row = BOARDROW_CELLS(board, y);
+        for (int word = 0; word < rowWords; word++)
+        {
+            quint64 bits = 0;
+            int x = word * 64, xEnd = qMin(x + 64, size);
+            for (; x + 8 <= xEnd; x += 8)
+            {
+                quint64 bytes;
+                memcpy(&bytes, row + x, sizeof(bytes));
+                bits |= ((bytes * Q_UINT64_C(0x0102040810204080)) >> 56) << (x % 64);
+            }
+            for (; x < xEnd; x++)
+                bits |= quint64(row[x].occupied) << (x % 64);
+            words[word] = bits;
+        }
+#endif
+    }
+}
+
+void LifeEngine::unpackRows(int yStart, int yEnd, const quint64 *words)
+{
+    // replace the cells of board rows `yStart` to `yEnd` (exclusive) by those packed in `words` (see `packRows()`)
+    Q_ASSERT(yStart >= 0 && yStart <= yEnd && yEnd <= size);
+    int rowWords = packedWordsPerRow(size);
+    if (currentBackend != BackendBoard)
+    {
+        // (the other backends are only ever unpacked into when empty, so only the occupied cells need setting)
+        for (int y = yStart; y < yEnd; y++, words += rowWords)
+            for (int x = 0; x < size; x++)
+                if ((words[x / 64] >> (x % 64)) & 1)
+                    setCellAt(y, x, true);
+        return;
+    }
+    Board &board(*curBoard);
+    for (int y = yStart; y < yEnd; y++, words += rowWords)
+    {
+#if BOARD_BIT_PACKED
+        BitBoard::Word *row = board.rowWords(y);
+        memcpy(row, words, size_t(rowWords) * sizeof(quint64));
+        row[rowWords - 1] &= board.lastRowWordMask();
+#else
+        for (int x = 0; x < size; x++)
+            BOARDCELL_SET_OCCUPIED(board, y, x, (words[x / 64] >> (x % 64)) & 1);
+#endif
+        if (trackAges)
+            memset(ages.data() + (y * size), 0, size_t(size));
+    }
+    markAllTilesChanged();
+}
+
+bool LifeEngine::readMacrocell(QIODevice &device, QStringList &headerLines, QString &errorMessage)
+{
+    // replace the cells by a pattern read from Macrocell format (see `HashLife::readMacrocell()`), centred on the centre of the board
+    // the pattern is read straight into HashLife's quadtree, and from there into the board if that is not the backend
+    // (as when switching backends, the unbounded universe gets the part of the pattern the board covers)
+    newBoard();
+    if (!hashLife.readMacrocell(device, headerLines, errorMessage))
+        return false;
+    if (currentBackend != BackendHashLife)
+    {
+        Board &board(*curBoard);
+        hashLife.forEachLiveCell(-size / 2, -size / 2, size, size,
+                                 [this, &board](int y, int x)->void { BOARDCELL_SET_OCCUPIED(board, y, x, true); });
+        hashLife.clear();
+        loadBackendFromBoard();
+    }
+    markAllTilesChanged();
+    return true;
+}
+
+void LifeEngine::writeMacrocell(QIODevice &device)
+{
+    // write the cells in Macrocell format (see `HashLife::writeMacrocell()`), the centre of the board being the centre of the pattern
+    // when HashLife is not the backend, the board (or unbounded universe) is loaded into HashLife's quadtree just to be written
+    if (currentBackend == BackendHashLife)
+    {
+        hashLife.writeMacrocell(device);
+        return;
+    }
+    qint64 top, left, bottom, right;
+    if (currentBackend == BackendUnbounded && universe.boundingRect(top, left, bottom, right))
+        hashLife.loadCells(top - (size / 2), left - (size / 2), int(bottom - top), int(right - left),
+                           [this, top, left](int y, int x)->bool { return universe.cellAt(top + y, left + x); });
+    else
+    {
+        const Board &board(*curBoard);
+        hashLife.loadCells(-size / 2, -size / 2, size, size,
+                           [&board](int y, int x)->bool { return BOARDCELL_AT(board, y, x).occupied; });
+    }
+    hashLife.writeMacrocell(device);
+    hashLife.clear();
+}
+
+static inline quint8 cellPixelValue(quint8 age)
+{
+    // return the pixel value `rasterize()` uses for an occupied cell: 1 + its age (capped), so older cells have higher values
+    return quint8(1 + qMin(int(age), 254));
+}
+
+void LifeEngine::rasterize(int top, int left, int rows, int columns, int cellsPerPixel, quint8 *pixels, int bytesPerLine) const
+{
+    // render the `rows` x `columns` board positions whose top-left is at (top, left) into `pixels`, an 8-bit image of `bytesPerLine` bytes per line
+    // each pixel covers `cellsPerPixel` x `cellsPerPixel` cells, and is 0 if none of them is occupied,
+    // else the greatest `cellPixelValue()` of its occupied cells
+    // the board is read directly (skipping empty words when bit-packed), so this costs about the same whatever the population
+    Q_ASSERT(cellsPerPixel > 0);
+    int pixelRows = (rows + cellsPerPixel - 1) / cellsPerPixel;
+    int pixelColumns = (columns + cellsPerPixel - 1) / cellsPerPixel;
+    for (int py = 0; py < pixelRows; py++)
+        memset(pixels + py * bytesPerLine, 0, size_t(pixelColumns));
+
+    if (currentBackend != BackendBoard)
+    {
+        forEachLiveCell(top, left, rows, columns, [&](int y, int x, const Cell &cell)->void {
+            quint8 &pixel(pixels[((y - top) / cellsPerPixel) * bytesPerLine + (x - left) / cellsPerPixel]);
+            pixel = qMax(pixel, cellPixelValue(cell.age));
+        });
+        return;
+    }
+
+    const Board &board(*curBoard);
+    int yStart = qMax(top, 0), yEnd = qMin(top + rows, size);
+    int xStart = qMax(left, 0), xEnd = qMin(left + columns, size);
+    if (xStart >= xEnd)
+        return;
+    for (int y = yStart; y < yEnd; y++)
+    {
+        quint8 *line = pixels + ((y - top) / cellsPerPixel) * bytesPerLine;
+        const quint8 *rowAges = trackAges ? ages.constData() + y * size : nullptr;
+#if BOARD_BIT_PACKED
+        const BitBoard::Word *words = board.rowWords(y);
+        for (int w = xStart / BitBoard::bitsPerWord; w <= (xEnd - 1) / BitBoard::bitsPerWord; w++)
+        {
+            BitBoard::Word word = words[w];
+            // mask off the bits outside [xStart, xEnd)
+            int x0 = w * BitBoard::bitsPerWord;
+            if (x0 < xStart)
+                word &= ~BitBoard::Word(0) << (xStart - x0);
+            if (x0 + BitBoard::bitsPerWord > xEnd)
+                word &= (BitBoard::Word(1) << (xEnd - x0)) - 1;
+            for (; word != 0; word &= word - 1)
+            {
+                int x = x0 + int(qCountTrailingZeroBits(word));
+                quint8 &pixel(line[(x - left) / cellsPerPixel]);
+                pixel = qMax(pixel, cellPixelValue(rowAges != nullptr ? rowAges[x] : 0));
+            }
+        }
+#else
+        for (int x = xStart; x < xEnd; x++)
+            if (BOARDCELL_AT(board, y, x).occupied)
+            {
+                quint8 &pixel(line[(x - left) / cellsPerPixel]);
+                pixel = qMax(pixel, cellPixelValue(rowAges != nullptr ? rowAges[x] : 0));
+            }
+#endif
+    }
+}
+
+bool LifeEngine::boundingRect(qint64 &top, qint64 &left, qint64 &bottom, qint64 &right) const
+{
+    // set `top`, `left` and (exclusive) `bottom`, `right` to (roughly) the bounds of the occupied cells of the unbounded universe
+    // return false if there are none, or the backend is not the unbounded universe
+    if (currentBackend != BackendUnbounded)
+        return false;
+    return universe.boundingRect(top, left, bottom, right);
+}
+
+quint64 LifeEngine::population() const
+{
+    // return the number of occupied cells
+    switch (currentBackend)
+    {
+    case BackendHashLife: return hashLife.population();
+    case BackendUnbounded: return universe.population();
+    case BackendBoard: break;
+    }
+    // (as gathered by the last generation, if known, else counted)
+    LifeGenerationStatistics statistics;
+    if (generationStatistics(statistics))
+        return statistics.population;
+    quint64 population = 0;
+    forEachLiveCell(0, 0, size, size, [&population](int, int, const Cell &)->void { population++; });
+    return population;
+}
+
+quint64 LifeEngine::changedCellCount() const
+{
+    // return the number of cells which changed in the last generation (births + deaths), by comparing `curBoard` with `nextBoard`
+    // (which holds the last generation once a step has been generated; cells altered since then count as changed too)
+    // only known for the board, 0 for the other backends
+    if (currentBackend != BackendBoard)
+        return 0;
+    const Board &board(*curBoard);
+    const Board &lastBoard(*nextBoard);
+    quint64 changed = 0;
+#if BOARD_BIT_PACKED
+    for (int y = 0; y < size; y++)
+    {
+        const BitBoard::Word *row = board.rowWords(y), *lastRow = lastBoard.rowWords(y);
+        for (int i = 0; i < board.wordsPerRow(); i++)
+        {
+            BitBoard::Word mask = (i == board.wordsPerRow() - 1) ? board.lastRowWordMask() : ~BitBoard::Word(0);
+            changed += qPopulationCount((row[i] ^ lastRow[i]) & mask);
+        }
+    }
+#else
+    for (int y = 0; y < BOARD_COUNT(board); y++)
+    {
+        const BoardCell *row = BOARDROW_CELLS(board, y), *lastRow = BOARDROW_CELLS(lastBoard, y);
+        for (int x = 0; x < size; x++)
+            changed += row[x].occupied != lastRow[x].occupied;
+    }
+#endif
+    return changed;
+}
+
+double LifeEngine::remotePageFraction(int workerCount) const
+{
+    // return the fraction of the memory pages of board0 & board1's rows which are not on the NUMA node of the worker whose band of rows they are in,
+    // for `workerCount` workers each generating a band, as in the banded partition (or -1 if this is not known)
+    // each worker's node is that of the CPU it last ran on in the worker pool, as recorded in the metrics
+    // these pages are read & written across nodes every generation, so this is (roughly) the fraction of the board's memory traffic which crosses sockets
+    const QVector<LifeMetrics::ThreadSample> threadSamples(runMetrics.sample().threads);
+    const LifeNumaTopology &topology(LifeNumaTopology::system());
+    const quintptr pageMask = ~quintptr(LifeNumaTopology::pageSize() - 1);
+#if BOARD_BIT_PACKED
+    const size_t rowBytes = size_t(board0.wordsPerRow()) * sizeof(BitBoard::Word);
+#else
+    const size_t rowBytes = size_t(size) * sizeof(BoardCell);
+#endif
+    qint64 pages = 0, remotePages = 0;
+    for (int workerIndex = 0; workerIndex < workerCount; workerIndex++)
+    {
+        int node = workerIndex < threadSamples.count() ? topology.nodeOfCpu(threadSamples.at(workerIndex).cpu) : -1;
+        if (node < 0)
+            return -1;
+        // the distinct pages of the worker's band of each board
+        QVector<const void *> bandPages;
+        for (const Board *board : { &board0, &board1 })
+            for (int y = size * workerIndex / workerCount; y < size * (workerIndex + 1) / workerCount; y++)
+            {
+#if BOARD_BIT_PACKED
+                quintptr start = reinterpret_cast<quintptr>(board->rowWords(y));
+#else
+                quintptr start = reinterpret_cast<quintptr>(BOARDROW_CELLS((*board), y));
+#endif
+                for (quintptr page = start & pageMask; page < start + rowBytes; page += ~pageMask + 1)
+                    if (bandPages.isEmpty() || bandPages.last() != reinterpret_cast<const void *>(page))
+                        bandPages.append(reinterpret_cast<const void *>(page));
+            }
+        QVector<int> nodes;
+        if (!LifeNumaTopology::pageNodes(bandPages, nodes))
+            return -1;
+        for (int pageNode : nodes)
+            if (pageNode >= 0)
+            {
+                pages++;
+                if (pageNode != node)
+                    remotePages++;
+            }
+    }
+    return pages > 0 ? double(remotePages) / pages : -1;
+}
+
+bool LifeEngine::generationStatistics(LifeGenerationStatistics &statistics) const
+{
+    // set `statistics` to the population, births, deaths & bounds of the last generation, gathered as it was generated
+    // return false if they are not known: they are not being tracked, the backend is not the board,
+    // or the board has been altered since the last generation (including by being a new board)
+    if (currentBackend != BackendBoard || !trackStatistics || !lastStatisticsKnown)
+        return false;
+    statistics = lastStatistics;
+    return true;
+}
+
+bool LifeEngine::stabilisation(qint64 &stabilisedGeneration, int &period) const
+{
+    // set `stabilisedGeneration` & `period` to the generation from which the board repeats, and how often
+    // (detected from the generations' hashes & populations, up to `maxStabilisationPeriod`, without comparing boards: see `detectStabilisation()`)
+    // return false if it has not been detected to have stabilised: as for `generationStatistics()`, statistics must be tracked,
+    // and the board not altered since
+    if (currentBackend != BackendBoard || !trackStatistics || stabilisedPeriod == 0)
+        return false;
+    stabilisedGeneration = this->stabilisedGeneration;
+    period = stabilisedPeriod;
+    return true;
+}
+
+bool LifeEngine::takeChangedRegions(QVector<QRect> &regions)
+{
+    // set `regions` to the board rectangles which have changed since the last call (and forget them)
+    // each is a run of changed tiles along a row of tiles, clipped to the board
+    // return false if which cells have changed is not known (changed tiles are not tracked, the backend is not the board,
+    // or everything may have changed), in which case the caller should assume they all have
+    regions.clear();
+    bool known = trackChanges && currentBackend == BackendBoard && !allChangedUntaken;
+    if (known)
+        for (int tileRow = 0; tileRow < activeTileRows; tileRow++)
+        {
+            const quint8 *changed = tileChangedUntaken.constData() + tileRow * activeTileColumns;
+            for (int tileColumn = 0; tileColumn < activeTileColumns; tileColumn++)
+            {
+                if (!changed[tileColumn])
+                    continue;
+                int runStart = tileColumn;
+                while (tileColumn + 1 < activeTileColumns && changed[tileColumn + 1])
+                    tileColumn++;
+                int y = tileRow * activeTileHeight, x = runStart * activeTileWidth;
+                regions.append(QRect(x, y, qMin((tileColumn + 1) * activeTileWidth, size) - x, qMin(activeTileHeight, size - y)));
+            }
+        }
+    tileChangedUntaken.fill(false);
+    this->allChangedUntaken = false;
+    return known;
+}
+
+void LifeEngine::loadBackendFromBoard()
+{
+    // replace the backend's cells by the board's (the board is the backend's cells if it is the board)
+    const Board &board(*curBoard);
+    switch (currentBackend)
+    {
+    case BackendBoard:
+        break;
+    case BackendHashLife:
+        // HashLife's universe is centred on the centre of the board
+        hashLife.loadCells(-size / 2, -size / 2, size, size,
+                           [&board](int y, int x)->bool { return BOARDCELL_AT(board, y, x).occupied; });
+        break;
+    case BackendUnbounded:
+        universe.clear();
+        for (int y = 0; y < BOARD_COUNT(board); y++)
+            for (int x = 0; x < BOARDROW_COUNT(BOARDROW_AT(board, y)); x++)
+                if (BOARDCELL_AT(board, y, x).occupied)
+                    universe.setCellAt(y, x, true);
+        break;
+    }
+}
+
+void LifeEngine::copyBackendToBoard()
+{
+    // replace the board's cells by that part of the backend which the board covers
+    if (currentBackend == BackendBoard)
+        return;
+    Board &board(*curBoard);
+    createOrClearBoard(board);
+    auto setOccupied = [this, &board](int y, int x, const Cell &)->void { BOARDCELL_SET_OCCUPIED(board, y, x, true); };
+    forEachLiveCell(0, 0, size, size, setOccupied);
+    // (the backends do not track ages)
+    clearAges();
+    // `nextBoard` no longer holds the last generation
+    markAllTilesChanged();
+}
+
+void LifeEngine::fillBoardBorder()
+{
+    // fill the border around `curBoard`, for dead or wrapped edges, ready to generate a step
+    // (only boards with a ghost border need this, others check the edges as they count neighbours)
+#if BOARD_BIT_PACKED || BOARD_CONTIGUOUS
+    curBoard->fillBorder(wrap);
+#endif
+}
+
+void LifeEngine::stepPass1(bool multiThread /*= false*/, int startRow /*= 0*/, int incRow /*=1*/, LifeGenerationStatistics *statistics /*= nullptr*/)
+{
+    // populate `nextBoard` from `curBoard` by generating a step (within `stepRegion`), adding to `statistics` (if any) as it goes
+
+    /* RULES (Conway's Life, B3/S23, the default `currentRule`):
+     * 1. Survival:
+     *      counter with 2/3 neighbours => survives
+     * 2. Death:
+     *      counter with 4+ neighbours => dies (overcrowding)
+     *      counter with 0/1 neighbours => dies (isolation)
+     * 3. Birth:
+     *      no counter with 3 neighbours => birth
+     * other Life-like rules change the neighbour counts for survival & birth
+     */
+
+    int yStart = stepRegion.top;
+    int yStep = 1;
+    if (multiThread)
+    {
+        // (the rows numbered `startRow` modulo `incRow`, from the top of the region)
+        Q_ASSERT(incRow > 0);
+        Q_ASSERT(startRow >= 0 && startRow < incRow);
+        yStart += (((startRow - yStart) % incRow) + incRow) % incRow;
+        yStep = incRow;
+    }
+#if BOARD_BIT_PACKED
+    // do a whole word of cells at a time
+    BitBoard::stepRows(*curBoard, *nextBoard, yStart, qMax(yStart, stepRegion.bottom), yStep,
+                       stepRegion.left / BitBoard::bitsPerWord, (stepRegion.right + BitBoard::bitsPerWord - 1) / BitBoard::bitsPerWord,
+                       currentRule, statistics);
+    if (trackAges)
+        for (int y = yStart; y < stepRegion.bottom; y += yStep)
+            ageBlock(y, y + 1, stepRegion.left, stepRegion.right);
+#else
+    for (int y = yStart; y < stepRegion.bottom; y += yStep)
+        stepPass1Block(y, y + 1, stepRegion.left, stepRegion.right, statistics);
+#endif
+}
+
+void LifeEngine::stepPass1Block(int yStart, int yEnd, int xStart, int xEnd, LifeGenerationStatistics *statistics /*= nullptr*/)
+{
+    // populate the block of rows `yStart` to `yEnd - 1`, columns `xStart` to `xEnd - 1`, of `nextBoard`
+    // from `curBoard` by generating a step, adding each row's figures to `statistics` (if any) straight after it is generated
+    const Board &board(*curBoard);
+    Board &newBoard(*nextBoard);
+#if BOARD_BIT_PACKED
+    // do a whole word of cells at a time, so the columns are widened to word boundaries
+    BitBoard::stepBlock(board, newBoard, yStart, yEnd,
+                        xStart / BitBoard::bitsPerWord, (xEnd + BitBoard::bitsPerWord - 1) / BitBoard::bitsPerWord, currentRule, statistics);
+#else
+    for (int y = yStart; y < yEnd; y++)
+    {
+        // (a ghost border's rows -1 & `size` are the rows beyond the edges, else they are the wrapped-around rows or empty)
+#if BOARD_CONTIGUOUS
+        const BoardCell *above = BOARDROW_CELLS(board, y - 1), *below = BOARDROW_CELLS(board, y + 1);
+#else
+        int rows = BOARD_COUNT(board);
+        const BoardCell *above = y > 0 ? BOARDROW_CELLS(board, y - 1) : wrap ? BOARDROW_CELLS(board, rows - 1) : emptyRow.constData();
+        const BoardCell *below = y < rows - 1 ? BOARDROW_CELLS(board, y + 1) : wrap ? BOARDROW_CELLS(board, 0) : emptyRow.constData();
+#endif
+        cellKernel(above, BOARDROW_CELLS(board, y), below, BOARDROW_CELLS(newBoard, y), xStart, xEnd, size, currentRule);
+        if (statistics != nullptr)
+            addRowStatistics(BOARDROW_CELLS(board, y), BOARDROW_CELLS(newBoard, y), y, xStart, xEnd, size, *statistics);
+    }
+#endif
+    if (trackAges)
+        ageBlock(yStart, yEnd, xStart, xEnd);
+}
+
+void LifeEngine::ageBlock(int yStart, int yEnd, int xStart, int xEnd)
+{
+    // update the ages of the block of rows `yStart` to `yEnd - 1`, columns `xStart` to `xEnd - 1`, once `nextBoard` has been populated:
+    // a cell occupied in both `curBoard` & `nextBoard` is a generation older (saturating at 255), any other is age 0
+    // (a cell's age only depends on the cell itself, so the one plane is updated in place, and workers' blocks never overlap)
+    const Board &board(*curBoard);
+    const Board &newBoard(*nextBoard);
+    for (int y = yStart; y < yEnd; y++)
+    {
+        quint8 *rowAges = ages.data() + y * size;
+#if BOARD_BIT_PACKED
+        const BitBoard::Word *row = board.rowWords(y), *newRow = newBoard.rowWords(y);
+        for (int x = xStart; x < xEnd; x++)
+        {
+            int i = x / BitBoard::bitsPerWord, bit = x % BitBoard::bitsPerWord;
+            bool survived = ((row[i] & newRow[i]) >> bit) & 1;
+            rowAges[x] = survived ? rowAges[x] + (rowAges[x] != 255) : 0;
+        }
+#else
+        const BoardCell *row = BOARDROW_CELLS(board, y), *newRow = BOARDROW_CELLS(newBoard, y);
+        for (int x = xStart; x < xEnd; x++)
+            rowAges[x] = row[x].occupied && newRow[x].occupied ? rowAges[x] + (rowAges[x] != 255) : 0;
+#endif
+    }
+}
+
+void LifeEngine::stepPass1Partition(int workerIndex, int workerCount)
+{
+    // populate worker `workerIndex`'s share (of `workerCount`) of `nextBoard` from `curBoard`,
+    // according to how the board is partitioned between threads
+    Q_ASSERT(workerCount > 0);
+    Q_ASSERT(workerIndex >= 0 && workerIndex < workerCount);
+    // (the worker adds up its share's statistics itself, and only stores them in its slot once done)
+    LifeGenerationStatistics shareStatistics;
+    LifeGenerationStatistics *statistics = trackStatistics ? &shareStatistics : nullptr;
+    // (when recording history in the worker pool, the worker packs its band of rows of `curBoard` into the frame for it,
+    // see `runGenerationsInWorkerPool()`; it is the same band as the NUMA-local worker pool's worker owns)
+    if (historyFrameWords != nullptr)
+    {
+        int yStart = size * workerIndex / workerCount, yEnd = size * (workerIndex + 1) / workerCount;
+        packRows(yStart, yEnd, historyFrameWords + size_t(yStart) * size_t(packedWordsPerRow(size)));
+    }
+    if (activeRegions || trackChanges)
+        stepPass1ActiveTiles(workerIndex, workerCount, statistics);
+    else
+    {
+        // the partitions cover the whole board, but only their parts within `stepRegion` are generated
+        const Board &board(*curBoard);
+        int rows = BOARD_COUNT(board);
+        int columns = rows > 0 ? BOARDROW_COUNT(BOARDROW_AT(board, 0)) : 0;
+        // (the NUMA-local worker pool's workers each generate the band they own)
+        switch (currentThreadMode == ThreadsNumaWorkerPool ? PartitionBanded : currentPartitionMode)
+        {
+        case PartitionInterleaved:
+            // every `workerCount` numbered rows starting from `workerIndex`
+            stepPass1(true, workerIndex, workerCount, statistics);
+            break;
+        case PartitionBanded: {
+            // one contiguous band of rows
+            // neighbouring bands only meet at their edges, where each worker reads (never writes) the other's edge row of `curBoard`
+            int yStart = qMax(rows * workerIndex / workerCount, stepRegion.top);
+            int yEnd = qMin(rows * (workerIndex + 1) / workerCount, stepRegion.bottom);
+            if (yStart < yEnd)
+                stepPass1Block(yStart, yEnd, stepRegion.left, stepRegion.right, statistics);
+            break;
+        }
+        case PartitionTiled: {
+            // one contiguous run (in row-major order) of tiles
+            // every row of `nextBoard` starts a cache line, and tile widths are whole cache lines,
+            // so workers never write to the same cache line (except for `QVector` rows, which are not aligned)
+            int tileRows = (rows + partitionTileHeight - 1) / partitionTileHeight;
+            int tileColumns = (columns + partitionTileWidth - 1) / partitionTileWidth;
+            int tileCount = tileRows * tileColumns;
+            int tileEnd = tileCount * (workerIndex + 1) / workerCount;
+            for (int tile = tileCount * workerIndex / workerCount; tile < tileEnd; tile++)
+            {
+                int y = (tile / tileColumns) * partitionTileHeight;
+                int x = (tile % tileColumns) * partitionTileWidth;
+                int yStart = qMax(y, stepRegion.top), yEnd = qMin(qMin(y + partitionTileHeight, rows), stepRegion.bottom);
+                int xStart = qMax(x, stepRegion.left), xEnd = qMin(qMin(x + partitionTileWidth, columns), stepRegion.right);
+                if (yStart < yEnd && xStart < xEnd)
+                    stepPass1Block(yStart, yEnd, xStart, xEnd, statistics);
+            }
+            break;
+        }
+        }
+    }
+    if (statistics != nullptr)
+        workerStatistics[workerIndex] = shareStatistics;
+}
+
+void LifeEngine::stepPass1ActiveTiles(int workerIndex, int workerCount, LifeGenerationStatistics *statistics)
+{
+    // populate worker `workerIndex`'s share (of `workerCount`) of `nextBoard` from `curBoard`, tile by tile,
+    // recording whether each tile changed as it goes, and adding each tile's figures to `statistics` (if any)
+    // (a generated tile's figures are kept, and used again for as long as it is not active, as its cells are then unchanged;
+    // with the figures, whether a tile changed is known from its births & deaths, without comparing its cells)
+    // when only active regions are generated, only the tiles which changed in the last generation or border one which did are generated
+    // a tile which is not active is unchanged from the last generation to this one,
+    // so `nextBoard` (which holds the last generation) already holds that tile's cells for the next generation
+    // each worker takes a contiguous run (in row-major order) of tiles, whatever the partition mode
+    const Board &board(*curBoard);
+    int rows = BOARD_COUNT(board);
+    int columns = rows > 0 ? BOARDROW_COUNT(BOARDROW_AT(board, 0)) : 0;
+    int tileCount = activeTileRows * activeTileColumns;
+    int tileEnd = tileCount * (workerIndex + 1) / workerCount;
+    int activeTiles = 0;
+    for (int tile = tileCount * workerIndex / workerCount; tile < tileEnd; tile++)
+    {
+        int tileRow = tile / activeTileColumns, tileColumn = tile % activeTileColumns;
+        if (activeRegions && !tileIsActive(tileRow, tileColumn))
+        {
+            tileChangedNext[tile] = false;
+            // (its cells are unchanged, but still age)
+            if (trackAges)
+                ageBlock(tileRow * activeTileHeight, qMin((tileRow + 1) * activeTileHeight, rows),
+                         tileColumn * activeTileWidth, qMin((tileColumn + 1) * activeTileWidth, columns));
+            if (statistics != nullptr)
+            {
+                LifeGenerationStatistics &unchanged(tileStatistics[tile]);
+                unchanged.births = unchanged.deaths = 0;
+                statistics->merge(unchanged);
+            }
+            continue;
+        }
+        activeTiles++;
+        int yStart = tileRow * activeTileHeight, yEnd = qMin(yStart + activeTileHeight, rows);
+        int xStart = tileColumn * activeTileWidth, xEnd = qMin(xStart + activeTileWidth, columns);
+        if (statistics != nullptr)
+        {
+            LifeGenerationStatistics &generated(tileStatistics[tile]);
+            generated = LifeGenerationStatistics();
+            stepPass1Block(yStart, yEnd, xStart, xEnd, &generated);
+            tileChangedNext[tile] = generated.changedCells() > 0;
+            statistics->merge(generated);
+            continue;
+        }
+        stepPass1Block(yStart, yEnd, xStart, xEnd);
+        tileChangedNext[tile] = blockChanged(yStart, yEnd, xStart, xEnd);
+    }
+    activeTileCount.fetchAndAddRelaxed(activeTiles);
+}
+
+bool LifeEngine::tileIsActive(int tileRow, int tileColumn) const
+{
+    // return whether a tile, or any of its 8 neighbouring tiles, changed in the last generation
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        int row = tileRow + dy;
+        if (row < 0 || row >= activeTileRows)
+        {
+            if (!wrap)
+                continue;
+            row = (row + activeTileRows) % activeTileRows;
+        }
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int column = tileColumn + dx;
+            if (column < 0 || column >= activeTileColumns)
+            {
+                if (!wrap)
+                    continue;
+                column = (column + activeTileColumns) % activeTileColumns;
+            }
+            if (tileChangedLast.at(row * activeTileColumns + column))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool LifeEngine::blockChanged(int yStart, int yEnd, int xStart, int xEnd) const
+{
+    // return whether any cell in the block of rows `yStart` to `yEnd - 1`, columns `xStart` to `xEnd - 1`,
+    // differs between `curBoard` and `nextBoard`
+    const Board &board(*curBoard);
+    const Board &newBoard(*nextBoard);
+#if BOARD_BIT_PACKED
+    // compare whole words (the bits beyond the right-hand edge may differ, as they can hold wrapped cells)
+    int wordStart = xStart / BitBoard::bitsPerWord;
+    int wordEnd = (xEnd + BitBoard::bitsPerWord - 1) / BitBoard::bitsPerWord;
+    for (int y = yStart; y < yEnd; y++)
+    {
+        const BitBoard::Word *row = board.rowWords(y), *newRow = newBoard.rowWords(y);
+        for (int i = wordStart; i < wordEnd; i++)
+        {
+            BitBoard::Word mask = (i == board.wordsPerRow() - 1) ? board.lastRowWordMask() : ~BitBoard::Word(0);
+            if ((row[i] ^ newRow[i]) & mask)
+                return true;
+        }
+    }
+#else
+    for (int y = yStart; y < yEnd; y++)
+        for (int x = xStart; x < xEnd; x++)
+            if (BOARDCELL_AT(board, y, x).occupied != BOARDCELL_AT(newBoard, y, x).occupied)
+                return true;
+#endif
+    return false;
+}
+
+void LifeEngine::markAllTilesChanged()
+{
+    // mark every tile as changed in the last generation, so that all are generated next time
+    // (needed whenever `nextBoard` may not hold the last generation, e.g. a new board)
+    tileChangedLast.fill(true);
+    this->allChangedUntaken = true;
+    // (nor are the statistics known, of the board or of the generation `nextBoard` held, nor whether it has stabilised)
+    this->lastStatisticsKnown = this->previousStatisticsKnown = false;
+    this->recentGenerationCount = this->stabilisedPeriod = 0;
+}
+
+void LifeEngine::markTileChanged(int y, int x)
+{
+    // mark the tile holding a board position as changed in the last generation, after the cell has been altered
+    int tile = (y / activeTileHeight) * activeTileColumns + (x / activeTileWidth);
+    tileChangedLast[tile] = true;
+    tileChangedUntaken[tile] = true;
+    this->lastStatisticsKnown = false;
+    this->recentGenerationCount = this->stabilisedPeriod = 0;
+}
+
+void LifeEngine::stepPass2(int generations /*= 1*/)
+{
+    // swap `curBoard` and `nextBoard`, which is `generations` generations on (more than 1 only when temporally blocked)
+    Q_ASSERT(generations == 1 || temporalBlockingApplies());
+    if (this->curBoard == &this->board0)
+    {
+        this->curBoard = &this->board1;
+        this->nextBoard = &this->board0;
+    }
+    else
+    {
+        this->curBoard = &this->board0;
+        this->nextBoard = &this->board1;
+    }
+    this->generation += generations;
+    // this generation's tile changes become the last generation's
+    if (activeRegions || trackChanges)
+    {
+        tileChangedLast.swap(tileChangedNext);
+        activeTileStatistics.last = activeTileCount.fetchAndStoreRelaxed(0);
+        activeTileStatistics.total += activeTileStatistics.last;
+        if (trackChanges)
+            for (int tile = 0; tile < tileChangedUntaken.count(); tile++)
+                tileChangedUntaken[tile] |= tileChangedLast[tile];
+    }
+    // the workers' statistics for this generation are merged, and the last generation's become the one before's
+    if (trackStatistics)
+    {
+        this->previousStatistics = lastStatistics;
+        this->previousStatisticsKnown = lastStatisticsKnown;
+        this->lastStatistics = LifeGenerationStatistics();
+        for (const LifeGenerationStatistics &statistics : workerStatistics)
+            lastStatistics.merge(statistics);
+        this->lastStatisticsKnown = true;
+        detectStabilisation();
+    }
+    updateStepRegion();
+}
+
+void LifeEngine::detectStabilisation()
+{
+    // look for the generation just generated among the recent generations, by its hash & population,
+    // when the board has stabilised from that generation on, with a period of how many generations ago it was
+    // then add it to the recent generations (once stabilised, it keeps repeating, so there is nothing more to detect until the board is altered)
+    if (stabilisedPeriod == 0)
+        for (int period = 1; period <= recentGenerationCount; period++)
+        {
+            const RecentGeneration &recent(recentGenerations[(recentGenerationNext - period + maxStabilisationPeriod) % maxStabilisationPeriod]);
+            if (recent.hash == lastStatistics.hash && recent.population == lastStatistics.population)
+            {
+                this->stabilisedGeneration = generation - period;
+                this->stabilisedPeriod = period;
+                break;
+            }
+        }
+    recentGenerations[recentGenerationNext] = { lastStatistics.hash, lastStatistics.population };
+    this->recentGenerationNext = (recentGenerationNext + 1) % maxStabilisationPeriod;
+    this->recentGenerationCount = qMin(recentGenerationCount + 1, maxStabilisationPeriod);
+}
+
+void LifeEngine::updateStepRegion()
+{
+    // set `stepRegion`, the region of the board the next generation is generated in
+    // it is the whole board, unless the statistics of the board and of the generation before (held in `nextBoard`) are both known,
+    // when it is narrowed to the bounds of the board's occupied cells grown by one cell (the only cells which can be occupied next),
+    // plus the bounds of the generation before's (the only cells `nextBoard` has occupied, and which must be cleared)
+    // it is not narrowed when the edges wrap (births then spread across them),
+    // nor when generating tile by tile (when only active regions are generated, which narrows it tile by tile anyway)
+    this->stepRegion = { 0, 0, size, size };
+    if (!trackStatistics || !lastStatisticsKnown || !previousStatisticsKnown || wrap || activeRegions || trackChanges)
+        return;
+    int top = size, left = size, bottom = 0, right = 0;
+    if (!lastStatistics.isEmpty())
+    {
+        top = qMax(lastStatistics.top - 1, 0);
+        left = qMax(lastStatistics.left - 1, 0);
+        bottom = qMin(lastStatistics.bottom + 1, size);
+        right = qMin(lastStatistics.right + 1, size);
+    }
+    if (!previousStatistics.isEmpty())
+    {
+        top = qMin(top, previousStatistics.top);
+        left = qMin(left, previousStatistics.left);
+        bottom = qMax(bottom, previousStatistics.bottom);
+        right = qMax(right, previousStatistics.right);
+    }
+    if (top >= bottom || left >= right)
+        top = left = bottom = right = 0;
+    this->stepRegion = { top, left, bottom, right };
+}
+
+qint64 LifeEngine::generationsPerStep() const
+{
+    // return the number of generations `step()` progresses through
+    return currentBackend == BackendHashLife ? qint64(1) << log2Step : 1;
+}
+
+void LifeEngine::step()
+{
+    // progress through a single generation (or 2^k generations in HashLife)
+    // (the board's generations are timed for the metrics as they are generated, other backends' steps here)
+    QElapsedTimer et;
+    et.start();
+    switch (currentBackend)
+    {
+    case BackendBoard:
+        stepBoard();
+        break;
+    case BackendHashLife:
+        hashLife.step(log2Step);
+        this->generation += qint64(1) << log2Step;
+        break;
+    case BackendUnbounded:
+        universe.step();
+        this->generation++;
+        break;
+    }
+    // (the board's generations are recorded as they are generated, see `stepBoard()` & `runGenerationsInWorkerPool()`)
+    if (currentBackend != BackendBoard && historyRecorder.isRecording())
+        historyRecorder.record(*this);
+    if (currentBackend != BackendBoard)
+        runMetrics.recordTiming(LifeMetrics::TimingGeneration, et.nsecsElapsed());
+}
+
+void LifeEngine::runSteps(int steps)
+{
+    // progress through `steps` steps, without returning in between
+    // in the worker pool, the threads stay running for all of them
+    // when temporally blocked, as many as make whole blocks are run in blocks, and any left over singly,
+    // always leaving at least the last generation to run singly, so that `nextBoard` holds the generation before the last
+    // (a blocked pass leaves it holding the generation before the block, see `changedCellCount()`)
+    if (temporalBlockingApplies() && steps > blockGenerations)
+    {
+        int passes = (steps - 1) / blockGenerations;
+        runTemporalBlocks(passes);
+        steps -= passes * blockGenerations;
+    }
+    if (currentBackend == BackendBoard && usesWorkerPool())
+    {
+        if (steps > 0)
+            runGenerationsInWorkerPool(threads, steps);
+        return;
+    }
+    for (int i = 0; i < steps; i++)
+        step();
+}
+
+void LifeEngine::stepBoard()
+{
+    // progress the board through a single generation, in threads according to the thread mode
+    // the generation, and each thread's share of it, are timed for the metrics
+
+    if (usesWorkerPool())
+    {
+        // do rows in the long-lived worker pool threads
+        runGenerationsInWorkerPool(threads, 1);
+        return;
+    }
+
+    QElapsedTimer et;
+    et.start();
+
+    fillBoardBorder();
+    // (the settings may have changed since the last generation)
+    updateStepRegion();
+    if (trackStatistics)
+        workerStatistics.resize(currentThreadMode != ThreadsNone ? threads : 1);
+
+    if (currentThreadMode != ThreadsNone)
+    {
+        // do rows in sub-threads
+        bool useQtConcurrent = currentThreadMode == ThreadsQtConcurrent;
+        int incRow = threads;
+        Q_ASSERT(incRow > 0);
+        QList<QFuture<void>> futures;
+        QList<QThread *> threadList;
+
+        // do the shares of workers 1/2/3... (of `incRow`) in sub-threads
+        auto work = [this](int startRow, int incRow)->void {
+            QElapsedTimer et;
+            et.start();
+            this->stepPass1Partition(startRow, incRow);
+            runMetrics.recordThread(startRow, et.nsecsElapsed(), 0);
+        };
+        for (int startRow = 1; startRow < incRow; startRow++)
+            if (useQtConcurrent)
+            {
+                futures.append(QtConcurrent::run([=]()->void { work(startRow, incRow); }));
+            }
+            else
+            {
+                QThread *thread = QThread::create([=]()->void { work(startRow, incRow); });
+                thread->start();
+                threadList.append(thread);
+            }
+
+        // do the share of worker 0 in main thread
+        QElapsedTimer et0;
+        et0.start();
+        this->stepPass1Partition(0, incRow);
+        qint64 busyNsecs = et0.nsecsElapsed();
+        // wait for all sub-threads to complete their rows
+        if (useQtConcurrent)
+        {
+            for (QFuture<void> &future : futures)
+                future.waitForFinished();
+        }
+        else
+        {
+            for (QThread *thread : threadList)
+            {
+                thread->wait();
+                delete thread;
+            }
+        }
+        runMetrics.recordThread(0, busyNsecs, et0.nsecsElapsed() - busyNsecs);
+    }
+    else
+    {
+        stepPass1Partition(0, 1);
+        runMetrics.recordThread(0, et.nsecsElapsed(), 0);
+    }
+
+    stepPass2();
+    if (historyRecorder.isRecording())
+        historyRecorder.record(*this);
+    runMetrics.recordTiming(LifeMetrics::TimingGeneration, et.nsecsElapsed());
+}
+
+void LifeEngine::runGenerationsInWorkerPool(int threadCount, int generations)
+{
+    // run `generations` generations of the board in `threadCount` threads of the worker pool
+    // each worker does its share of the board (the calling thread is worker #0),
+    // and the boards are swapped once all workers have met at the barrier after each generation,
+    // which is when each generation is timed for the metrics (from when the last one was complete)
+    // when recording history, each generation's frame is packed by the workers, each its band of rows, as they generate the next generation
+    // from it (see `stepPass1Partition()`), and handed over at the barrier after; only the last generation's is packed here, in one thread
+    prepareWorkerPool(threadCount);
+    fillBoardBorder();
+    updateStepRegion();
+    if (trackStatistics)
+        workerStatistics.resize(threadCount);
+    QElapsedTimer et;
+    et.start();
+    int generationsLeft = generations;
+    workerPool.run(generations,
+                   [this](int workerIndex, int workerCount)->void { this->stepPass1Partition(workerIndex, workerCount); },
+                   [this, &et, &generationsLeft]()->void {
+        if (historyFrameWords != nullptr)
+            historyRecorder.endFrame();
+        this->stepPass2();
+        this->fillBoardBorder();
+        this->historyFrameWords = nullptr;
+        bool lastGeneration = --generationsLeft == 0;
+        if (historyRecorder.isRecording())
+        {
+            if (!lastGeneration)
+                this->historyFrameWords = historyRecorder.beginFrame(*this);
+            else
+                historyRecorder.record(*this);
+        }
+        runMetrics.recordTiming(LifeMetrics::TimingGeneration, et.nsecsElapsed());
+        et.start();
+    });
+}
+
+void LifeEngine::prepareWorkerPool(int threadCount)
+{
+    // set the worker pool up to run the board in `threadCount` threads, NUMA-local or not according to the thread mode
+    bool numaLocal = currentThreadMode == ThreadsNumaWorkerPool;
+    workerPool.setNumaLocal(numaLocal);
+    workerPool.setThreadCount(threadCount);
+    // (when NUMA-local, each worker's band of the boards must have been placed on its node, for this many workers)
+    if (numaLocal && threadCount > 1 && placedWorkerCount != threadCount)
+        placeBoards(threadCount);
+}
+
+void LifeEngine::runTemporalBlocks(int passes)
+{
+    // run `passes` passes over the board, each advancing it `blockGenerations` generations (temporal blocking)
+    // each pass advances the board tile by tile, each tile all those generations at once (see `stepTemporalBlock()`),
+    // so `curBoard` is read and `nextBoard` written once a pass, rather than once a generation
+    // the tiles are shared out between the worker pool's threads (or all done in the calling thread, without threads),
+    // and the boards swapped once all are done; each pass is timed for the metrics as that many generations of equal times
+    QElapsedTimer et;
+    auto passComplete = [this, &et]()->void {
+        this->stepPass2(blockGenerations);
+        qint64 nsecs = et.nsecsElapsed();
+        for (int i = 0; i < blockGenerations; i++)
+            runMetrics.recordTiming(LifeMetrics::TimingGeneration, nsecs / blockGenerations);
+        et.start();
+    };
+    if (usesWorkerPool())
+    {
+        prepareWorkerPool(threads);
+        et.start();
+        workerPool.run(passes,
+                       [this](int workerIndex, int workerCount)->void { this->stepTemporalBlockPartition(workerIndex, workerCount); },
+                       passComplete);
+        return;
+    }
+    et.start();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        QElapsedTimer et0;
+        et0.start();
+        stepTemporalBlockPartition(0, 1);
+        runMetrics.recordThread(0, et0.nsecsElapsed(), 0);
+        passComplete();
+    }
+}
+
+void LifeEngine::stepTemporalBlockPartition(int workerIndex, int workerCount)
+{
+    // populate worker `workerIndex`'s share (of `workerCount`) of `nextBoard` with the cells `blockGenerations` generations on from `curBoard`:
+    // a contiguous run (in row-major order) of tiles (near enough the band of rows the NUMA-local worker pool's worker owns)
+    // the tiles' heights are evened out (no more than `temporalTileHeight`), as each tile's halo above & below is the same however high it is
+    // the worker's scratch boards are its own, allocated (and first touched) in its thread for each pass
+    Q_ASSERT(workerCount > 0);
+    Q_ASSERT(workerIndex >= 0 && workerIndex < workerCount);
+    BitBoard scratch, newScratch;
+    int tileRows = (size + temporalTileHeight - 1) / temporalTileHeight;
+    int tileColumns = (size + temporalTileWidth - 1) / temporalTileWidth;
+    int tileHeight = (size + tileRows - 1) / tileRows;
+    int tileCount = tileRows * tileColumns;
+    int tileEnd = tileCount * (workerIndex + 1) / workerCount;
+    for (int tile = tileCount * workerIndex / workerCount; tile < tileEnd; tile++)
+    {
+        int y = (tile / tileColumns) * tileHeight;
+        int x = (tile % tileColumns) * temporalTileWidth;
+        if (y < size)
+            stepTemporalBlock(y, qMin(y + tileHeight, size), x, qMin(x + temporalTileWidth, size), scratch, newScratch);
+    }
+}
+
+void LifeEngine::stepTemporalBlock(int yStart, int yEnd, int xStart, int xEnd, BitBoard &scratch, BitBoard &newScratch)
+{
+    // populate the tile of rows `yStart` to `yEnd - 1`, columns `xStart` to `xEnd - 1` (from a word boundary), of `nextBoard`
+    // with its cells `blockGenerations` generations on from `curBoard`
+    // the tile and a halo round it, of `blockGenerations` rows above & below and a word of 64 cells either side, are copied into `scratch`,
+    // which is small enough to stay in cache, and stepped back & forth with `newScratch` by the bit-packed kernel a generation at a time
+    // a halo cell is wrong from the generation the cells beyond the halo could first have reached it, the nearer its edge the sooner,
+    // so each generation is only generated in one row fewer above & below than the last (a trapezoid), and ends with just the tile right
+    // (neighbouring tiles' halos overlap, so their cells are generated by each tile they are round, which is the price of not sharing them)
+    // beyond dead edges the halo is kept empty, as the cells beyond the board are
+    Q_ASSERT(xStart % BitBoard::bitsPerWord == 0);
+    const int halo = blockGenerations;
+    const int rows = (yEnd - yStart) + 2 * halo;
+    // (the halo on the right is widened to make the words stepped in each row a whole number of cache lines, which as every `BitBoard` row
+    // starts a cache line are whole, aligned numbers of the kernel's vectors; the spare words either side are outside them)
+    const int wordCount = ((xEnd - xStart + BitBoard::bitsPerWord - 1) / BitBoard::bitsPerWord + 2 + 7) / 8 * 8;
+    // (scratch column 0 is board column `xOrigin`)
+    const int xOrigin = xStart - BitBoard::bitsPerWord;
+    scratch.resize(rows, wordCount * BitBoard::bitsPerWord);
+    newScratch.resize(rows, wordCount * BitBoard::bitsPerWord);
+
+    // the scratch rows on the board (all of them, if the edges wrap),
+    // and the scratch words not wholly on the board (before `wordFirst` or from `wordEnd`), whose cells beyond the board are masked off
+    int rowFirst = wrap ? 0 : qMax(halo - yStart, 0);
+    int rowEnd = wrap ? rows : qMin(halo + size - yStart, rows);
+    int wordFirst = wrap ? 0 : qBound(0, -xOrigin / BitBoard::bitsPerWord, wordCount);
+    int wordEnd = wrap ? wordCount : qBound(wordFirst, (size - xOrigin) / BitBoard::bitsPerWord, wordCount);
+    QVector<quint64> columnMask(wordCount, ~quint64(0));
+    for (int i = 0; i < wordCount; i++)
+        if (i < wordFirst || i >= wordEnd)
+        {
+            int x = xOrigin + (i * BitBoard::bitsPerWord);
+            columnMask[i] = x < 0 || x >= size ? 0 : (~quint64(0) >> (BitBoard::bitsPerWord - (size - x)));
+        }
+
+    // copy in the tile & its halo (the rows beyond dead edges are empty in both scratch boards, and are never generated)
+    for (int row = 0; row < rows; row++)
+    {
+        if (row < rowFirst || row >= rowEnd)
+        {
+            memset(scratch.rowWords(row), 0, wordCount * sizeof(BitBoard::Word));
+            memset(newScratch.rowWords(row), 0, wordCount * sizeof(BitBoard::Word));
+            continue;
+        }
+        int y = (((yStart - halo + row) % size) + size) % size;
+        readBoardRowWords(y, xOrigin, wordCount, scratch.rowWords(row));
+    }
+
+    // generate the trapezoid of generations
+    BitBoard *board = &scratch, *newBoard = &newScratch;
+    for (int g = 1; g <= halo; g++)
+    {
+        int rowStart = qMax(g, rowFirst), rowStop = qMin(rows - g, rowEnd);
+        BitBoard::stepRows(*board, *newBoard, rowStart, rowStop, 1, 0, wordCount, currentRule);
+        if (wordFirst > 0 || wordEnd < wordCount)
+            for (int row = rowStart; row < rowStop; row++)
+            {
+                BitBoard::Word *words = newBoard->rowWords(row);
+                for (int i = 0; i < wordFirst; i++)
+                    words[i] &= columnMask.at(i);
+                for (int i = wordEnd; i < wordCount; i++)
+                    words[i] &= columnMask.at(i);
+            }
+        std::swap(board, newBoard);
+    }
+
+    // copy out the tile
+    for (int y = yStart; y < yEnd; y++)
+        writeBoardRowWords(y, xStart, xEnd, board->rowWords(y - yStart + halo) + 1);
+}
+
+void LifeEngine::readBoardRowWords(int y, int xStart, int wordCount, quint64 *words) const
+{
+    // set `words` to `wordCount` words of the cells of row `y` of `curBoard` from column `xStart` on, packed as by `packRows()`,
+    // the columns beyond the board's left & right edges being wrapped around, or empty
+    const Board &board(*curBoard);
+#if BOARD_BIT_PACKED
+    // the words wholly on the board are copied straight (when they are whole words of the board)
+    const BitBoard::Word *row = board.rowWords(y);
+    int iStart = 0, iEnd = 0;
+    if (xStart % BitBoard::bitsPerWord == 0)
+    {
+        iStart = qBound(0, -xStart / BitBoard::bitsPerWord, wordCount);
+        iEnd = qBound(iStart, (size - xStart) / BitBoard::bitsPerWord, wordCount);
+        memcpy(words + iStart, row + (xStart / BitBoard::bitsPerWord) + iStart, (iEnd - iStart) * sizeof(BitBoard::Word));
+        if (iStart == 0 && iEnd == wordCount)
+            return;
+    }
+#else
+    const BoardCell *row = BOARDROW_CELLS(board, y);
+#endif
+    for (int i = 0; i < wordCount; i++)
+    {
+        int x = xStart + (i * BitBoard::bitsPerWord);
+        quint64 word = 0;
+#if BOARD_BIT_PACKED
+        if (i >= iStart && i < iEnd)
+            continue;
+        // a word of the board partly beyond the right-hand edge is masked off (unless the bits beyond are to be wrapped cells)
+        if (x >= 0 && x % BitBoard::bitsPerWord == 0 && x < size && !wrap)
+        {
+            words[i] = row[x / BitBoard::bitsPerWord] & board.lastRowWordMask();
+            continue;
+        }
+#else
+        // a word of cells on the board is packed without checking the edges
+        if (x >= 0 && x + BitBoard::bitsPerWord <= size)
+        {
+            for (int bit = 0; bit < BitBoard::bitsPerWord; bit++)
+                word |= quint64(row[x + bit].occupied) << bit;
+            words[i] = word;
+            continue;
+        }
+#endif
+        // a word wholly beyond a dead edge is empty, otherwise cell by cell
+        if (!wrap && (x + BitBoard::bitsPerWord <= 0 || x >= size))
+        {
+            words[i] = 0;
+            continue;
+        }
+        for (int bit = 0; bit < BitBoard::bitsPerWord; bit++)
+        {
+            int column = x + bit;
+            if (column < 0 || column >= size)
+            {
+                if (!wrap)
+                    continue;
+                column = ((column % size) + size) % size;
+            }
+            word |= quint64(BOARDCELL_AT(board, y, column).occupied) << bit;
+        }
+        words[i] = word;
+    }
+}
+
+void LifeEngine::writeBoardRowWords(int y, int xStart, int xEnd, const quint64 *words)
+{
+    // set cells `xStart` to `xEnd - 1` of row `y` of `nextBoard` from `words`, packed as by `packRows()` (the opposite of `readBoardRowWords()`)
+    Board &board(*nextBoard);
+#if BOARD_BIT_PACKED
+    // (the cells start at a word boundary, and end at one or at the right-hand edge, so whole words are copied)
+    Q_ASSERT(xStart % BitBoard::bitsPerWord == 0 && (xEnd % BitBoard::bitsPerWord == 0 || xEnd == size));
+    BitBoard::Word *row = board.rowWords(y) + (xStart / BitBoard::bitsPerWord);
+    int wordCount = (xEnd - xStart + BitBoard::bitsPerWord - 1) / BitBoard::bitsPerWord;
+    memcpy(row, words, wordCount * sizeof(BitBoard::Word));
+    if (xEnd == size)
+        row[wordCount - 1] &= board.lastRowWordMask();
+#else
+    BoardCell *row = BOARDROW_CELLS(board, y);
+    for (int x = xStart; x < xEnd; x++)
+        row[x].occupied = (words[(x - xStart) / BitBoard::bitsPerWord] >> ((x - xStart) % BitBoard::bitsPerWord)) & 1;
+#endif
+}
+
+bool LifeEngine::startRecordingHistory(const QString &fileName, int keyframeInterval, QString &errorMessage)
+{
+    // start recording each generation (of the board positions, for the backends other than the board) to history log `fileName`,
+    // from the current generation (see `LifeHistoryRecorder`)
+    if (historyRecorder.isRecording() && !historyRecorder.stop(errorMessage))
+        return false;
+    return historyRecorder.start(fileName, *this, keyframeInterval, errorMessage);
+}
+
+void LifeEngine::resetStatistics()
+{
+    // reset the run statistics (active tiles, and the metrics)
+    activeTileStatistics.total = 0;
+    runMetrics.reset();
+}
+
+LifeMetrics::Sample LifeEngine::metricsSample() const
+{
+    // return a sample of the metrics, along with the generation number, population and cells changed in the last generation
+    // they are taken from the statistics gathered as the last generation ran, if known (see `generationStatistics()`),
+    // else counted now (see `population()` & `changedCellCount()`), so the engine must not be stepping meanwhile
+    LifeMetrics::Sample sample(runMetrics.sample());
+    sample.generation = generation;
+    LifeGenerationStatistics statistics;
+    if (generationStatistics(statistics))
+    {
+        sample.population = statistics.population;
+        sample.changedCells = statistics.changedCells();
+    }
+    else
+    {
+        sample.population = population();
+        sample.changedCells = changedCellCount();
+    }
+    return sample;
+}
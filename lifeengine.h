@@ -0,0 +1,347 @@
+#ifndef LIFEENGINE_H
+#define LIFEENGINE_H
+
+#include <functional>
+
+#include <QAtomicInt>
+#include <QIODevice>
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+#include "bitboard.h"
+#include "hashlife.h"
+#include "lifegenerationstatistics.h"
+#include "lifehistory.h"
+#include "lifemetrics.h"
+#include "liferule.h"
+#include "lifeworkerpool.h"
+#include "paddedboard.h"
+#include "sparseuniverse.h"
+
+
+// the board's storage layout is chosen at compile time, either by the defaults here
+// or from qmake with `CONFIG+=board_qvector`, `CONFIG+=board_contiguous` or `CONFIG+=board_bit_packed` (see engine.pri),
+// so comparing layouts means a build of each (`boardLayoutName()` says which this build has)
+// (choosing the layout at runtime from the menu, as the cell kernel is chosen, is not implemented yet)
+
+// compile-time support for using C-style arrays for the board, rather than Qt `QVector`s
+#ifndef BOARD_C_ARRAYS
+#define BOARD_C_ARRAYS 1
+#endif
+
+// compile-time support for a board in one contiguous allocation with a ghost border (no bounds checks when counting neighbours)
+// this takes precedence over `BOARD_C_ARRAYS`
+#ifndef BOARD_CONTIGUOUS
+#define BOARD_CONTIGUOUS 0
+#endif
+
+// compile-time support for a bit-packed board (64 cells per word, with a word-parallel generation kernel)
+// this takes precedence over `BOARD_CONTIGUOUS` & `BOARD_C_ARRAYS`
+#ifndef BOARD_BIT_PACKED
+#define BOARD_BIT_PACKED 0
+#endif
+
+// the Game of Life simulation, independent of any GUI: the board(s), generating steps (in threads), and the alternative backends
+// the board is `boardSize()` x `boardSize()` cells, and board positions are (y, x) with (0, 0) at the top-left
+class LifeEngine
+{
+public:
+    // a cell, as given by `cellAt()` & `forEachLiveCell()`
+    // its age is how many generations it has been occupied for (saturating at 255), only known while ages are tracked on the board
+    struct Cell {
+        bool occupied = false;
+        quint8 age = 0;
+    };
+    // a cell as held in the board: ages are held separately (see `setTrackAges()`), so the board stays one byte per cell
+    struct BoardCell {
+        bool occupied = false;
+    };
+
+    // (the board access macros are only for use within `LifeEngine`, where `this->size` is the board size)
+#if BOARD_BIT_PACKED
+    // cells are only read by value (`BOARDCELL_AT`), and written via `BOARDCELL_SET_OCCUPIED`
+    typedef BitBoard Board;
+    #define BOARD_COUNT(board) board.rowCount()
+    #define BOARDROW_COUNT(boardrow) (boardrow ? this->size : 0)
+    #define BOARDCELL_AT(board, y, x) LifeEngine::BoardCell{board.cellAt(y, x)}
+    #define BOARDCELL_SET_OCCUPIED(board, y, x, isOccupied) board.setCellAt(y, x, isOccupied)
+    #define BOARDROW_AT(board, y) board.rowWords(y)
+#elif BOARD_CONTIGUOUS
+    // `board[y]` is a pointer to the cells of row `y`, which may be indexed from -1 to `size` (the ghost border)
+    typedef PaddedBoard<BoardCell> Board;
+    #define BOARD_COUNT(board) board.rowCount()
+    #define BOARDROW_COUNT(boardrow) (boardrow ? this->size : 0)
+    #define BOARDCELL_AT(board, y, x) board[y][x]
+    #define BOARDCELL_SQUARE(board, y, x) board[y][x]
+    #define BOARDCELL_SET_OCCUPIED(board, y, x, isOccupied) board[y][x].occupied = (isOccupied)
+    #define BOARDROW_AT(board, y) board[y]
+    #define BOARDROW_CELLS(board, y) board[y]
+#elif BOARD_C_ARRAYS
+    typedef BoardCell *BoardRow;
+    typedef BoardRow *Board;
+    #define BOARD_COUNT(board) (board ? this->size : 0)
+    #define BOARDROW_COUNT(boardrow) (boardrow ? this->size : 0)
+    #define BOARDCELL_AT(board, y, x) board[y][x]
+    #define BOARDCELL_SQUARE(board, y, x) board[y][x]
+    #define BOARDCELL_SET_OCCUPIED(board, y, x, isOccupied) board[y][x].occupied = (isOccupied)
+    #define BOARDROW_AT(board, y) board[y]
+    #define BOARDROW_CELLS(board, y) board[y]
+#else
+    typedef QVector<BoardCell> BoardRow;
+    typedef QVector<BoardRow> Board;
+    #define BOARD_COUNT(board) board.count()
+    #define BOARDROW_COUNT(boardrow) boardrow.count()
+    #define BOARDCELL_AT(board, y, x) board.at(y).at(x)
+    #define BOARDCELL_SQUARE(board, y, x) board[y][x]
+    #define BOARDCELL_SET_OCCUPIED(board, y, x, isOccupied) board[y][x].occupied = (isOccupied)
+    #define BOARDROW_AT(board, y) board.at(y)
+    #define BOARDROW_CELLS(board, y) board[y].data()
+#endif
+
+    static constexpr int defaultBoardSize = 1000;
+
+    // a cell generation kernel: populates cells `xStart` to `xEnd - 1` of a row from it and its neighbouring rows
+    // (see "Cell Generation Kernels" in lifeengine.cpp)
+    typedef void (*CellKernel)(const BoardCell *above, const BoardCell *row, const BoardCell *below, BoardCell *newRow,
+                               int xStart, int xEnd, int columns, const LifeRule &rule);
+
+    // what holds the cells and generates the steps
+    // the HashLife & unbounded universes are unbounded, and the board is then only the initial area they are loaded from
+    enum Backend { BackendBoard, BackendHashLife, BackendUnbounded };
+    // how (and whether) the board is shared out between threads
+    // the NUMA-local worker pool always partitions into bands, each worker owning its band of both boards, placed on its own node
+    enum ThreadMode { ThreadsNone, ThreadsQtConcurrent, ThreadsQThreads, ThreadsWorkerPool, ThreadsNumaWorkerPool };
+    enum PartitionMode { PartitionInterleaved, PartitionBanded, PartitionTiled };
+    // size of each tile when partitioning into tiles (width is a whole number of cache lines, which every board row starts)
+    static constexpr int partitionTileHeight = 64;
+#if BOARD_BIT_PACKED
+    static constexpr int partitionTileWidth = 8 * BitBoard::bitsPerWord;
+#else
+    static constexpr int partitionTileWidth = 128;
+#endif
+    // size of each tile advanced several generations at a time when temporally blocked (see `setTemporalBlockGenerations()`),
+    // small enough that it and its halo stay in cache (width is a whole number of words of 64 cells,
+    // which with a halo word either side is 32 words, a whole number of the cache lines that each scratch row starts on)
+    static constexpr int temporalTileHeight = 128;
+    static constexpr int temporalTileWidth = 30 * BitBoard::bitsPerWord;
+    // the most generations a tile can be advanced at a time (its halo either side is one word of 64 cells),
+    // and how many it is when temporal blocking is turned on from the GUI
+    static constexpr int maxTemporalBlockGenerations = BitBoard::bitsPerWord;
+    static constexpr int defaultTemporalBlockGenerations = 8;
+    // size of each tile tracked for changes when only active regions are generated (width is one word/cache line)
+    static constexpr int activeTileHeight = 32;
+    static constexpr int activeTileWidth = 64;
+    // default memory limit for the HashLife backend
+    static constexpr size_t hashLifeDefaultMemoryLimit = size_t(512) * 1024 * 1024;
+    // the longest period of oscillation the board is detected to have stabilised into (enough for mixes of period 2, 3 & 5 oscillators, as in soups)
+    static constexpr int maxStabilisationPeriod = 32;
+
+    // the catalogue of formations which can be placed on the board
+    struct Formation {
+        QString name;
+        QList<QPoint> deltas;
+    };
+    struct CategoryFormations {
+        QString title;
+        QVector<Formation> formations;
+    };
+    static const QVector<CategoryFormations> &formationCategories();
+
+    LifeEngine();
+    ~LifeEngine();
+    LifeEngine(const LifeEngine &) = delete;
+    LifeEngine &operator=(const LifeEngine &) = delete;
+
+    Backend backend() const { return currentBackend; }
+    void setBackend(Backend backend);
+    static QString backendName(Backend backend);
+    static QString boardLayoutName();
+    ThreadMode threadMode() const { return currentThreadMode; }
+    void setThreadMode(ThreadMode mode) { currentThreadMode = mode; }
+    static QString threadModeName(ThreadMode mode);
+    int threadCount() const { return threads; }
+    void setThreadCount(int threadCount);
+    PartitionMode partitionMode() const { return currentPartitionMode; }
+    void setPartitionMode(PartitionMode mode) { currentPartitionMode = mode; }
+    static QString partitionModeName(PartitionMode mode);
+    const LifeRule &rule() const { return currentRule; }
+    void setRule(const LifeRule &rule);
+    bool edgesWrap() const { return wrap; }
+    void setEdgesWrap(bool wrap);
+    bool activeRegionsOnly() const { return activeRegions; }
+    void setActiveRegionsOnly(bool activeRegionsOnly);
+    bool changedTilesTracked() const { return trackChanges; }
+    void setTrackChangedTiles(bool track);
+    bool agesTracked() const { return trackAges; }
+    void setTrackAges(bool track);
+    bool statisticsTracked() const { return trackStatistics; }
+    void setTrackStatistics(bool track);
+    int temporalBlockGenerations() const { return blockGenerations; }
+    void setTemporalBlockGenerations(int generations);
+    bool temporalBlockingApplies() const;
+    int hashLifeLog2Step() const { return log2Step; }
+    void setHashLifeLog2Step(int log2Step);
+    size_t hashLifeMemoryLimit() const { return hashLife.memoryLimit(); }
+    void setHashLifeMemoryLimit(size_t bytes) { hashLife.setMemoryLimit(bytes); }
+
+    int boardSize() const { return size; }
+    void newBoard(int boardSize);
+    void newBoard() { newBoard(size); }
+    void randomize(quint64 seed, double density = 0.5);
+    quint64 randomSeed() const { return lastRandomSeed; }
+    bool positionIsValid(int y, int x) const;
+    Cell cellAt(int y, int x) const;
+    void setCellAt(int y, int x, bool occupied);
+    void setCellRun(int y, int x, int length);
+    void placeFormation(const Formation &formation, int y, int x);
+    void forEachLiveCell(int top, int left, int rows, int columns, const std::function<void(int y, int x, const Cell &cell)> &callback) const;
+    void forEachLiveRun(int y, const std::function<void(int x, int length)> &callback) const;
+    // rows packed 64 cells to a `quint64` word, bit `x % 64` of word `x / 64` being the cell in column `x`
+    static int packedWordsPerRow(int boardSize) { return (boardSize + 63) / 64; }
+    void packRows(int yStart, int yEnd, quint64 *words) const;
+    void unpackRows(int yStart, int yEnd, const quint64 *words);
+    bool readMacrocell(QIODevice &device, QStringList &headerLines, QString &errorMessage);
+    void writeMacrocell(QIODevice &device);
+    void rasterize(int top, int left, int rows, int columns, int cellsPerPixel, quint8 *pixels, int bytesPerLine) const;
+    bool boundingRect(qint64 &top, qint64 &left, qint64 &bottom, qint64 &right) const;
+    quint64 population() const;
+    quint64 changedCellCount() const;
+    double remotePageFraction(int workerCount) const;
+    bool generationStatistics(LifeGenerationStatistics &statistics) const;
+    bool stabilisation(qint64 &stabilisedGeneration, int &period) const;
+    bool takeChangedRegions(QVector<QRect> &regions);
+
+    qint64 generationNumber() const { return generation; }
+    void setGenerationNumber(qint64 generationNumber) { generation = generationNumber; }
+    qint64 generationsPerStep() const;
+    void step();
+    void runSteps(int steps);
+    void runGenerationsInWorkerPool(int threadCount, int generations);
+
+    bool historyRecording() const { return historyRecorder.isRecording(); }
+    bool startRecordingHistory(const QString &fileName, int keyframeInterval, QString &errorMessage);
+    bool stopRecordingHistory(QString &errorMessage) { return historyRecorder.stop(errorMessage); }
+
+    void resetStatistics();
+    qint64 activeTileTotal() const { return activeTileStatistics.total; }
+    int lastActiveTileCount() const { return activeTileStatistics.last; }
+    int tileCount() const { return activeTileRows * activeTileColumns; }
+    LifeMetrics &metrics() { return runMetrics; }
+    const LifeMetrics &metrics() const { return runMetrics; }
+    LifeMetrics::Sample metricsSample() const;
+    const HashLife &hashLifeUniverse() const { return hashLife; }
+    const SparseUniverse &unboundedUniverse() const { return universe; }
+
+private:
+    Board board0, board1;
+    Board *curBoard, *nextBoard;
+    // the board is `size` x `size` cells
+    int size;
+    qint64 generation;
+    // the seed the board was last randomized from
+    quint64 lastRandomSeed;
+    Backend currentBackend;
+    ThreadMode currentThreadMode;
+    int threads;
+    PartitionMode currentPartitionMode;
+    LifeWorkerPool workerPool;
+    // the number of workers whose bands of board0 & board1 were each first touched by that worker, for the NUMA-local worker pool (0 if none)
+    int placedWorkerCount;
+    // the performance counters, always recorded
+    LifeMetrics runMetrics;
+    // the rule the board & backends generate steps under
+    LifeRule currentRule;
+    // the cell generation kernel for the edges & rule, and a row of empty cells for it to use beyond dead edges
+    CellKernel cellKernel;
+    QVector<BoardCell> emptyRow;
+    // whether the board's cells' ages are tracked, in a plane of `size` x `size` bytes (empty while not tracked)
+    bool trackAges;
+    QVector<quint8> ages;
+    // whether each generation's statistics are gathered as it is generated, each worker adding up its own share in `workerStatistics`,
+    // which are merged into `lastStatistics` once all are done; the generation before's are kept, as `nextBoard` then holds it,
+    // and each active tile's, for the tiles not generated when only active regions are
+    // the statistics are not known for a board which has been altered since it was generated
+    bool trackStatistics;
+    QVector<LifeGenerationStatistics> workerStatistics;
+    LifeGenerationStatistics lastStatistics, previousStatistics;
+    bool lastStatisticsKnown, previousStatisticsKnown;
+    QVector<LifeGenerationStatistics> tileStatistics;
+    // the hashes & populations of the last `recentGenerationCount` (up to `maxStabilisationPeriod`) consecutive generations whose statistics are known,
+    // in a ring ending before `recentGenerationNext`, in which each generation is looked for to detect the board has stabilised (see `stabilisation()`)
+    struct RecentGeneration {
+        quint64 hash, population;
+    } recentGenerations[maxStabilisationPeriod];
+    int recentGenerationCount, recentGenerationNext;
+    // the generation from which the board repeats with period `stabilisedPeriod` (0 if it has not been detected to have stabilised)
+    qint64 stabilisedGeneration;
+    int stabilisedPeriod;
+    // the region of the board the next generation is generated in, `bottom` & `right` exclusive (see `updateStepRegion()`)
+    struct {
+        int top, left, bottom, right;
+    } stepRegion;
+    // how many generations `runSteps()` advances each tile of the board at a time, in a cache-resident copy (1 if not temporally blocked)
+    int blockGenerations;
+    // whether the board's edges wrap around (toroidal)
+    bool wrap;
+    // whether only active regions are generated
+    bool activeRegions;
+    // per-tile flags of whether the tile changed in the last generation (read), and in this generation (written)
+    int activeTileRows, activeTileColumns;
+    QVector<quint8> tileChangedLast, tileChangedNext;
+    // whether the per-tile flags are maintained (even when not only generating active regions), so that changes can be shown
+    // and the per-tile flags of whether the tile changed since last taken by `takeChangedRegions()` (or everything did)
+    bool trackChanges;
+    QVector<quint8> tileChangedUntaken;
+    bool allChangedUntaken;
+    QAtomicInt activeTileCount;
+    struct {
+        qint64 total;
+        int last;
+    } activeTileStatistics;
+    // the HashLife backend, centred on the centre of the board
+    HashLife hashLife;
+    int log2Step;
+    // the unbounded universe backend, whose cell coordinates are the same as the board's
+    SparseUniverse universe;
+    // records each generation to a history log, while recording
+    LifeHistoryRecorder historyRecorder;
+    // the history frame the worker pool's workers are packing `curBoard` into, each its band, as they generate from it (else nullptr)
+    quint64 *historyFrameWords;
+
+    void createOrClearBoard(Board &board);
+    void createOrClearBoards(int workerCount);
+    void placeBoards(int workerCount);
+    void allocateBoard(Board &board);
+    void createOrClearRows(Board &board, int yStart, int yEnd);
+    void deleteBoard(Board &board);
+    bool usesWorkerPool() const { return currentThreadMode == ThreadsWorkerPool || currentThreadMode == ThreadsNumaWorkerPool; }
+    void selectCellKernel();
+    void fillBoardBorder();
+    void stepPass1(bool multiThread = false, int startRow = 0, int incRow =1, LifeGenerationStatistics *statistics = nullptr);
+    void stepPass1Block(int yStart, int yEnd, int xStart, int xEnd, LifeGenerationStatistics *statistics = nullptr);
+    void ageBlock(int yStart, int yEnd, int xStart, int xEnd);
+    void clearAges();
+    void stepPass1Partition(int workerIndex, int workerCount);
+    void stepPass1ActiveTiles(int workerIndex, int workerCount, LifeGenerationStatistics *statistics);
+    void stepPass2(int generations = 1);
+    void stepBoard();
+    void prepareWorkerPool(int threadCount);
+    void runTemporalBlocks(int passes);
+    void stepTemporalBlockPartition(int workerIndex, int workerCount);
+    void stepTemporalBlock(int yStart, int yEnd, int xStart, int xEnd, BitBoard &scratch, BitBoard &newScratch);
+    void readBoardRowWords(int y, int xStart, int wordCount, quint64 *words) const;
+    void writeBoardRowWords(int y, int xStart, int xEnd, const quint64 *words);
+    void updateStepRegion();
+    void detectStabilisation();
+    bool tileIsActive(int tileRow, int tileColumn) const;
+    bool blockChanged(int yStart, int yEnd, int xStart, int xEnd) const;
+    void markAllTilesChanged();
+    void markTileChanged(int y, int x);
+    void loadBackendFromBoard();
+    void copyBackendToBoard();
+};
+
+#endif // LIFEENGINE_H
@@ -0,0 +1,67 @@
+#ifndef LIFEGENERATIONSTATISTICS_H
+#define LIFEGENERATIONSTATISTICS_H
+
+#include <limits>
+
+#include <QtGlobal>
+
+// the population, births, deaths, bounds and hash of the occupied cells of a generation, gathered as it is generated
+// (see `LifeEngine::generationStatistics()`): each row's figures are added up just after the row is generated, while it is still in cache,
+// into the statistics of whichever worker generated it, and the workers' statistics are merged once the generation is complete
+struct LifeGenerationStatistics
+{
+    quint64 population = 0;
+    quint64 births = 0;
+    quint64 deaths = 0;
+    // the bounds of the occupied cells, `bottom` & `right` exclusive (empty, with `bottom <= top`, if there are none)
+    int top = std::numeric_limits<int>::max();
+    int left = std::numeric_limits<int>::max();
+    int bottom = std::numeric_limits<int>::min();
+    int right = std::numeric_limits<int>::min();
+    // the sum of the `positionHash()`es of the occupied cells (in words of 64 cells, on a bit-packed board),
+    // so it adds up the same in any order, in shares or tile by tile, and is 0 for empty cells
+    // (equal boards have equal hashes, and unequal boards almost never do)
+    quint64 hash = 0;
+
+    static quint64 positionHash(quint64 position, quint64 bits)
+    {
+        // return the hash of the `bits` at (linear) position `position` (a "splitmix64" finaliser)
+        quint64 z = bits + (position + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    bool isEmpty() const { return bottom <= top; }
+    quint64 changedCells() const { return births + deaths; }
+
+    void addRow(int y, quint64 rowPopulation, quint64 rowBirths, quint64 rowDeaths, int xFirst, int xLast, quint64 rowHash)
+    {
+        // add the figures for (part of) row `y`, whose first & last occupied cells (if `rowPopulation` > 0) are in columns `xFirst` & `xLast`
+        hash += rowHash;
+        population += rowPopulation;
+        births += rowBirths;
+        deaths += rowDeaths;
+        if (rowPopulation == 0)
+            return;
+        top = qMin(top, y);
+        bottom = qMax(bottom, y + 1);
+        left = qMin(left, xFirst);
+        right = qMax(right, xLast + 1);
+    }
+
+    void merge(const LifeGenerationStatistics &other)
+    {
+        // add another share of the generation's figures
+        hash += other.hash;
+        population += other.population;
+        births += other.births;
+        deaths += other.deaths;
+        top = qMin(top, other.top);
+        left = qMin(left, other.left);
+        bottom = qMax(bottom, other.bottom);
+        right = qMax(right, other.right);
+    }
+};
+
+#endif // LIFEGENERATIONSTATISTICS_H
@@ -0,0 +1,414 @@
+#include <QMutexLocker>
+
+#include "lifeengine.h"
+#include "lifehistory.h"
+
+
+// append `value` to `out` as a varint (7 bits per byte, least significant first, top bit set on all but the last byte)
+static inline uchar *putVarint(uchar *out, quint32 value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = uchar(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = uchar(value);
+    return out;
+}
+
+// read a varint from `in` (not reading at or past `end`) into `value`, return false if it runs past `end`
+static inline bool getVarint(const uchar *&in, const uchar *end, quint32 &value)
+{
+    value = 0;
+    for (int shift = 0; in < end && shift < 32; shift += 7)
+    {
+        uchar byte = *in++;
+        value |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+
+////////// LifeHistoryRecorder Class //////////
+
+LifeHistoryRecorder::LifeHistoryRecorder()
+{
+    this->thread = nullptr;
+    this->size = 0;
+    this->keyframeInterval = defaultKeyframeInterval;
+    this->stopping = false;
+    this->packingFrame = -1;
+    this->framesWritten = 0;
+}
+
+LifeHistoryRecorder::~LifeHistoryRecorder()
+{
+    QString errorMessage;
+    stop(errorMessage);
+}
+
+bool LifeHistoryRecorder::start(const QString &fileName, const LifeEngine &engine, int keyframeInterval, QString &errorMessage)
+{
+    // start recording the engine's history to file `fileName`, from its current board (the first keyframe)
+    // every `keyframeInterval`th frame is a keyframe
+    Q_ASSERT(!isRecording() && keyframeInterval > 0);
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    this->size = engine.boardSize();
+    this->keyframeInterval = keyframeInterval;
+    LifeHistoryFormat::FileHeader header;
+    memcpy(header.magic, LifeHistoryFormat::fileMagic, sizeof(header.magic));
+    header.version = LifeHistoryFormat::fileVersion;
+    header.boardSize = size;
+    header.keyframeInterval = keyframeInterval;
+    header.reserved = 0;
+    if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header)))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        file.close();
+        return false;
+    }
+
+    // all the buffers are allocated up front, so that recording allocates nothing per generation
+    int wordCount = size * LifeEngine::packedWordsPerRow(size);
+    frames.resize(maxQueuedFrames);
+    freeFrames.clear();
+    queuedFrames.clear();
+    for (int i = 0; i < frames.count(); i++)
+    {
+        frames[i].words.resize(wordCount);
+        freeFrames.append(i);
+    }
+    previousWords.fill(0, wordCount);
+    // (the worst case for a delta is runs of one changed word, each with two varints)
+    encoded.reserve((wordCount * 14) + 16);
+    this->framesWritten = 0;
+    this->stopping = false;
+    this->writeError.clear();
+
+    this->thread = QThread::create([this]()->void { this->run(); });
+    thread->start();
+    record(engine);
+    return true;
+}
+
+bool LifeHistoryRecorder::stop(QString &errorMessage)
+{
+    // stop recording, once the writer thread has written all the frames queued
+    // return false if any write failed
+    if (thread == nullptr)
+        return true;
+    {
+        QMutexLocker locker(&mutex);
+        this->stopping = true;
+        frameQueued.wakeAll();
+    }
+    thread->wait();
+    delete thread;
+    this->thread = nullptr;
+    file.close();
+    if (writeError.isEmpty() && file.error() != QFileDevice::NoError)
+        this->writeError = QString("%1: %2").arg(file.fileName()).arg(file.errorString());
+    frames.clear();
+    previousWords.clear();
+    encoded.clear();
+    if (!writeError.isEmpty())
+    {
+        errorMessage = writeError;
+        return false;
+    }
+    return true;
+}
+
+void LifeHistoryRecorder::record(const LifeEngine &engine)
+{
+    // record the engine's board, as the next frame
+    quint64 *words = beginFrame(engine);
+    if (words == nullptr)
+        return;
+    engine.packRows(0, engine.boardSize(), words);
+    endFrame();
+}
+
+quint64 *LifeHistoryRecorder::beginFrame(const LifeEngine &engine)
+{
+    // take the next frame, for the engine's current generation, and return the words for its board to be packed into
+    // (`LifeEngine::packedWordsPerRow()` words per row), for `endFrame()` to hand over to the writer thread once packed
+    // return nullptr if there is nothing to record
+    // (a board of a different size from the one recording started with cannot go in the same log, so is left out)
+    Q_ASSERT(packingFrame < 0);
+    if (!isRecording() || engine.boardSize() != size)
+        return nullptr;
+    {
+        QMutexLocker locker(&mutex);
+        while (freeFrames.isEmpty() && writeError.isEmpty())
+            frameFreed.wait(&mutex);
+        if (!writeError.isEmpty())
+            return nullptr;
+        this->packingFrame = freeFrames.takeLast();
+    }
+    Frame &frame(frames[packingFrame]);
+    frame.generation = engine.generationNumber();
+    return frame.words.data();
+}
+
+void LifeHistoryRecorder::endFrame()
+{
+    // hand the frame taken by `beginFrame()`, now packed, over to the writer thread
+    Q_ASSERT(packingFrame >= 0);
+    QMutexLocker locker(&mutex);
+    queuedFrames.append(packingFrame);
+    this->packingFrame = -1;
+    frameQueued.wakeOne();
+}
+
+void LifeHistoryRecorder::run()
+{
+    // the writer thread: write the queued frames in order, until asked to stop and there are none left
+    for (;;)
+    {
+        int frameIndex;
+        {
+            QMutexLocker locker(&mutex);
+            while (queuedFrames.isEmpty() && !stopping)
+                frameQueued.wait(&mutex);
+            if (queuedFrames.isEmpty())
+                return;
+            frameIndex = queuedFrames.takeFirst();
+        }
+        bool ok = writeFrame(frames[frameIndex]);
+        {
+            QMutexLocker locker(&mutex);
+            freeFrames.append(frameIndex);
+            if (!ok)
+                this->writeError = QString("%1: %2").arg(file.fileName()).arg(file.errorString());
+            frameFreed.wakeAll();
+        }
+        if (!ok)
+            return;
+    }
+}
+
+bool LifeHistoryRecorder::writeFrame(Frame &frame)
+{
+    // encode & write a frame: a keyframe every `keyframeInterval` frames, else a delta from the previous frame
+    // afterwards `frame` holds the previous frame's words (its own having become `previousWords`), ready for reuse
+    int wordCount = previousWords.count();
+    bool keyframe = framesWritten % keyframeInterval == 0;
+    QByteArray compressed;
+    const char *data;
+    int length;
+    if (keyframe)
+    {
+        compressed = qCompress(reinterpret_cast<const uchar *>(frame.words.constData()), wordCount * int(sizeof(quint64)), 1);
+        data = compressed.constData();
+        length = compressed.size();
+    }
+    else
+    {
+        // the runs of words which changed, each as (number of unchanged words skipped, number of words, the words XORed)
+        const quint64 *words = frame.words.constData(), *previous = previousWords.constData();
+        encoded.resize(encoded.capacity());
+        uchar *start = reinterpret_cast<uchar *>(encoded.data()), *out = start;
+        for (int i = 0; i < wordCount; )
+        {
+            int unchangedStart = i;
+            while (i < wordCount && words[i] == previous[i])
+                i++;
+            if (i == wordCount)
+                break;
+            int changedStart = i;
+            while (i < wordCount && words[i] != previous[i])
+                i++;
+            out = putVarint(out, quint32(changedStart - unchangedStart));
+            out = putVarint(out, quint32(i - changedStart));
+            for (int j = changedStart; j < i; j++, out += sizeof(quint64))
+            {
+                quint64 delta = words[j] ^ previous[j];
+                memcpy(out, &delta, sizeof(quint64));
+            }
+        }
+        data = encoded.constData();
+        length = int(out - start);
+    }
+
+    LifeHistoryFormat::FrameHeader header;
+    header.generation = frame.generation;
+    header.length = quint32(length);
+    header.flags = keyframe ? LifeHistoryFormat::FrameKeyframe : 0;
+    if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+            || file.write(data, length) != length)
+        return false;
+    // (keyframes are flushed, so that a crash loses at most the frames since the last one to the file's buffer)
+    if (keyframe && !file.flush())
+        return false;
+    previousWords.swap(frame.words);
+    this->framesWritten++;
+    return true;
+}
+
+
+////////// LifeHistoryReader Class //////////
+
+LifeHistoryReader::LifeHistoryReader()
+{
+    this->data = nullptr;
+    this->size = 0;
+    this->decodedFrame = -1;
+}
+
+LifeHistoryReader::~LifeHistoryReader()
+{
+    close();
+}
+
+bool LifeHistoryReader::open(const QString &fileName, QString &errorMessage)
+{
+    // open history log `fileName`, mapping it into memory and indexing its frames
+    // return false if it cannot be read, or is not a history log
+    close();
+    auto fail = [this, &errorMessage, &fileName](const QString &message)->bool {
+        errorMessage = QString("%1: %2").arg(fileName).arg(message);
+        close();
+        return false;
+    };
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(file.errorString());
+    qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(LifeHistoryFormat::FileHeader)))
+        return fail("not a history log");
+    this->data = file.map(0, fileSize);
+    if (data == nullptr)
+        return fail(file.errorString());
+    LifeHistoryFormat::FileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, LifeHistoryFormat::fileMagic, sizeof(header.magic)) != 0)
+        return fail("not a history log");
+    if (header.version != LifeHistoryFormat::fileVersion)
+        return fail(QString("unsupported history log version %1").arg(header.version));
+    if (header.boardSize <= 0)
+        return fail("corrupt history log header");
+    this->size = header.boardSize;
+
+    // (a frame cut short, by a crash while recording, ends the log)
+    for (qint64 offset = sizeof(header); offset + qint64(sizeof(LifeHistoryFormat::FrameHeader)) <= fileSize; )
+    {
+        LifeHistoryFormat::FrameHeader frameHeader;
+        memcpy(&frameHeader, data + offset, sizeof(frameHeader));
+        offset += sizeof(frameHeader);
+        if (offset + frameHeader.length > fileSize)
+            break;
+        bool keyframe = frameHeader.flags & LifeHistoryFormat::FrameKeyframe;
+        if (index.isEmpty() && !keyframe)
+            return fail("history log does not start with a keyframe");
+        index.append({ frameHeader.generation, offset, frameHeader.length, keyframe });
+        offset += frameHeader.length;
+    }
+    if (index.isEmpty())
+        return fail("history log has no frames");
+    return true;
+}
+
+void LifeHistoryReader::close()
+{
+    if (data != nullptr)
+        file.unmap(const_cast<uchar *>(data));
+    this->data = nullptr;
+    file.close();
+    this->size = 0;
+    index.clear();
+    this->decodedFrame = -1;
+    decodedWords.clear();
+}
+
+int LifeHistoryReader::frameForGeneration(qint64 generation) const
+{
+    // return the last frame recorded at `generation`, or -1 if there is none
+    // (generation numbers go back to 0 if the board is cleared while recording, so the same one can be recorded more than once)
+    for (int frame = index.count() - 1; frame >= 0; frame--)
+        if (index.at(frame).generation == generation)
+            return frame;
+    return -1;
+}
+
+bool LifeHistoryReader::readFrame(int frame, QVector<quint64> &words, QString &errorMessage)
+{
+    // set `words` to the board at `frame`, packed 64 cells to a word (see `LifeEngine::packRows()`)
+    if (!decodeFrame(frame, errorMessage))
+        return false;
+    words = decodedWords;
+    return true;
+}
+
+bool LifeHistoryReader::loadFrame(int frame, LifeEngine &engine, QString &errorMessage)
+{
+    // replace the engine's board and generation number by those at `frame`
+    if (!decodeFrame(frame, errorMessage))
+        return false;
+    engine.newBoard(size);
+    engine.unpackRows(0, size, decodedWords.constData());
+    engine.setGenerationNumber(index.at(frame).generation);
+    return true;
+}
+
+bool LifeHistoryReader::decodeFrame(int frame, QString &errorMessage)
+{
+    // decode `frame` into `decodedWords`, starting from the keyframe at or before it,
+    // or from the frame last decoded if that is between the two
+    Q_ASSERT(frame >= 0 && frame < index.count());
+    int wordCount = size * LifeEngine::packedWordsPerRow(size);
+    int keyframe = frame;
+    while (!index.at(keyframe).keyframe)
+        keyframe--;
+    if (decodedFrame < keyframe || decodedFrame > frame)
+    {
+        const IndexEntry &entry(index.at(keyframe));
+        const QByteArray words(qUncompress(data + entry.offset, int(entry.length)));
+        if (words.size() != wordCount * int(sizeof(quint64)))
+        {
+            this->decodedFrame = -1;
+            errorMessage = QString("%1: corrupt keyframe %2").arg(file.fileName()).arg(keyframe);
+            return false;
+        }
+        decodedWords.resize(wordCount);
+        memcpy(decodedWords.data(), words.constData(), size_t(words.size()));
+        this->decodedFrame = keyframe;
+    }
+    quint64 *words = decodedWords.data();
+    for (int delta = decodedFrame + 1; delta <= frame; delta++)
+    {
+        const IndexEntry &entry(index.at(delta));
+        const uchar *in = data + entry.offset, *end = in + entry.length;
+        bool ok = true;
+        for (int i = 0; ok && in < end; )
+        {
+            quint32 unchanged, changed;
+            ok = getVarint(in, end, unchanged) && getVarint(in, end, changed)
+                    && i + qint64(unchanged) + changed <= wordCount && in + (qint64(changed) * sizeof(quint64)) <= end;
+            if (!ok)
+                break;
+            i += unchanged;
+            for (quint32 j = 0; j < changed; j++, i++, in += sizeof(quint64))
+            {
+                quint64 word;
+                memcpy(&word, in, sizeof(quint64));
+                words[i] ^= word;
+            }
+        }
+        if (!ok)
+        {
+            this->decodedFrame = -1;
+            errorMessage = QString("%1: corrupt frame %2").arg(file.fileName()).arg(delta);
+            return false;
+        }
+        this->decodedFrame = delta;
+    }
+    return true;
+}
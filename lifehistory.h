@@ -0,0 +1,126 @@
+#ifndef LIFEHISTORY_H
+#define LIFEHISTORY_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+class LifeEngine;
+
+// the generation history log: an append-only file of the board at each recorded generation, packed 64 cells to a word
+// every `keyframeInterval`th frame is a keyframe, the whole board compressed with `qCompress()`,
+// and the frames between are deltas, the XOR of the board with the previous frame's, stored as its runs of non-zero words
+// (from one generation to the next few cells change, so a delta is mostly skipped zero words)
+// the file is a header, then each frame as a header followed by its data; a log cut short by a crash is readable up to its last whole frame
+struct LifeHistoryFormat
+{
+    static constexpr char fileMagic[8] = { 'L', 'I', 'F', 'E', 'H', 'I', 'S', 'T' };
+    static constexpr quint32 fileVersion = 1;
+    enum FrameFlag : quint32 { FrameKeyframe = 1 };
+    struct FileHeader {
+        char magic[8];
+        quint32 version;
+        qint32 boardSize;
+        qint32 keyframeInterval;
+        quint32 reserved;
+    };
+    struct FrameHeader {
+        qint64 generation;
+        quint32 length;
+        quint32 flags;
+    };
+};
+
+// records the board's history to a log (see `LifeHistoryFormat`) while the engine runs
+// the engine hands over each generation with `record()`, which only copies the board (a copy of its words when bit-packed),
+// and the encoding & writing is done in the recorder's writer thread, a few generations behind
+// or it takes a frame with `beginFrame()`, packs the board into it itself (in threads, each its own rows), and hands it over with `endFrame()`
+// (if the writer falls `maxQueuedFrames` behind, `record()` & `beginFrame()` wait for it)
+class LifeHistoryRecorder
+{
+public:
+    static constexpr int defaultKeyframeInterval = 100;
+    static constexpr int maxQueuedFrames = 8;
+
+    LifeHistoryRecorder();
+    ~LifeHistoryRecorder();
+    LifeHistoryRecorder(const LifeHistoryRecorder &) = delete;
+    LifeHistoryRecorder &operator=(const LifeHistoryRecorder &) = delete;
+
+    bool isRecording() const { return thread != nullptr; }
+    bool start(const QString &fileName, const LifeEngine &engine, int keyframeInterval, QString &errorMessage);
+    bool stop(QString &errorMessage);
+    void record(const LifeEngine &engine);
+    quint64 *beginFrame(const LifeEngine &engine);
+    void endFrame();
+
+private:
+    struct Frame {
+        qint64 generation;
+        QVector<quint64> words;
+    };
+
+    QThread *thread;
+    QFile file;
+    int size, keyframeInterval;
+    // the frames, each either free or queued for the writer thread, protected by `mutex`
+    QMutex mutex;
+    QWaitCondition frameQueued, frameFreed;
+    QVector<Frame> frames;
+    QVector<int> freeFrames, queuedFrames;
+    // (used only by the engine) the frame taken by `beginFrame()`, being packed, else -1
+    int packingFrame;
+    bool stopping;
+    QString writeError;
+    // (used only by the writer thread) the last frame written, and the buffer frames are encoded into
+    QVector<quint64> previousWords;
+    QByteArray encoded;
+    qint64 framesWritten;
+
+    void run();
+    bool writeFrame(Frame &frame);
+};
+
+// reads a history log (see `LifeHistoryFormat`), giving random access to its frames
+// opening it maps the file and indexes the frames' headers; a frame is decoded from the keyframe at or before it,
+// or from the last frame decoded when that is nearer, so stepping through the frames in order decodes one delta each
+class LifeHistoryReader
+{
+public:
+    LifeHistoryReader();
+    ~LifeHistoryReader();
+    LifeHistoryReader(const LifeHistoryReader &) = delete;
+    LifeHistoryReader &operator=(const LifeHistoryReader &) = delete;
+
+    bool open(const QString &fileName, QString &errorMessage);
+    void close();
+    int boardSize() const { return size; }
+    int frameCount() const { return index.count(); }
+    qint64 frameGeneration(int frame) const { return index.at(frame).generation; }
+    int frameForGeneration(qint64 generation) const;
+    bool readFrame(int frame, QVector<quint64> &words, QString &errorMessage);
+    bool loadFrame(int frame, LifeEngine &engine, QString &errorMessage);
+
+private:
+    struct IndexEntry {
+        qint64 generation;
+        qint64 offset;
+        quint32 length;
+        bool keyframe;
+    };
+
+    QFile file;
+    const uchar *data;
+    int size;
+    QVector<IndexEntry> index;
+    // the last frame decoded, and its words
+    int decodedFrame;
+    QVector<quint64> decodedWords;
+
+    bool decodeFrame(int frame, QString &errorMessage);
+};
+
+#endif // LIFEHISTORY_H
@@ -0,0 +1,132 @@
+#include "lifemetrics.h"
+
+
+////////// LifeMetrics Class //////////
+
+LifeMetrics::LifeMetrics()
+{
+    for (ThreadCounters &counters : threads)
+        counters.cpu = -1;
+}
+
+void LifeMetrics::recordTiming(Timing timing, qint64 nsecs)
+{
+    // count one `timing` which took `nsecs`
+    TimingCounters &counters(timings[timing]);
+    counters.count.fetchAndAddRelaxed(1);
+    counters.totalNsecs.fetchAndAddRelaxed(nsecs);
+    counters.buckets[bucketForNsecs(nsecs)].fetchAndAddRelaxed(1);
+}
+
+void LifeMetrics::recordThread(int threadIndex, qint64 busyNsecs, qint64 waitNsecs)
+{
+    // count a generation's share done by thread `threadIndex`, which was busy for `busyNsecs` then waited `waitNsecs`
+    Q_ASSERT(threadIndex >= 0);
+    ThreadCounters &counters(threads[threadIndex % maxThreads]);
+    counters.busyNsecs.fetchAndAddRelaxed(busyNsecs);
+    counters.waitNsecs.fetchAndAddRelaxed(waitNsecs);
+    counters.generations.fetchAndAddRelaxed(1);
+    int count = qMin(threadIndex + 1, int(maxThreads));
+    for (int known = threadCount.loadRelaxed(); known < count; )
+        if (threadCount.testAndSetRelaxed(known, count, known))
+            break;
+}
+
+void LifeMetrics::setThreadCpu(int threadIndex, int cpu)
+{
+    // note the CPU thread `threadIndex` is running on
+    Q_ASSERT(threadIndex >= 0);
+    threads[threadIndex % maxThreads].cpu.storeRelaxed(cpu);
+}
+
+LifeMetrics::Sample LifeMetrics::sample() const
+{
+    // return a copy of the totals since the last reset
+    // (each counter is read atomically, but they are not read all at the same instant, so a sample taken while running
+    // may include a generation in some counters and not others)
+    Sample sample;
+    for (int timing = 0; timing < TimingCount; timing++)
+    {
+        const TimingCounters &counters(timings[timing]);
+        Histogram &histogram(sample.timings[timing]);
+        histogram.count = counters.count.loadRelaxed();
+        histogram.totalNsecs = counters.totalNsecs.loadRelaxed();
+        for (int bucket = 0; bucket < histogramBuckets; bucket++)
+            histogram.buckets[bucket] = counters.buckets[bucket].loadRelaxed();
+    }
+    sample.threads.resize(threadCount.loadRelaxed());
+    for (int i = 0; i < sample.threads.count(); i++)
+    {
+        ThreadSample &thread(sample.threads[i]);
+        thread.busyNsecs = threads[i].busyNsecs.loadRelaxed();
+        thread.waitNsecs = threads[i].waitNsecs.loadRelaxed();
+        thread.generations = threads[i].generations.loadRelaxed();
+        thread.cpu = threads[i].cpu.loadRelaxed();
+    }
+    return sample;
+}
+
+void LifeMetrics::reset()
+{
+    // zero the totals (the CPUs threads were last seen on are kept)
+    for (TimingCounters &counters : timings)
+    {
+        counters.count.storeRelaxed(0);
+        counters.totalNsecs.storeRelaxed(0);
+        for (QAtomicInteger<qint64> &bucket : counters.buckets)
+            bucket.storeRelaxed(0);
+    }
+    for (ThreadCounters &counters : threads)
+    {
+        counters.busyNsecs.storeRelaxed(0);
+        counters.waitNsecs.storeRelaxed(0);
+        counters.generations.storeRelaxed(0);
+    }
+}
+
+/*static*/ int LifeMetrics::bucketForNsecs(qint64 nsecs)
+{
+    // return the histogram bucket counting a duration of `nsecs`
+    quint64 usecs = quint64(qMax(nsecs, qint64(0))) / 1000;
+    int bucket = 0;
+    while (usecs > 1 && bucket < histogramBuckets - 1)
+    {
+        usecs >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/*static*/ qint64 LifeMetrics::bucketUpperNsecs(int bucket)
+{
+    // return the (exclusive) upper limit of the durations histogram bucket `bucket` counts
+    Q_ASSERT(bucket >= 0 && bucket < histogramBuckets);
+    return (qint64(2) << bucket) * 1000;
+}
+
+/*static*/ qint64 LifeMetrics::percentileNsecs(const Histogram &histogram, double percentile)
+{
+    // return (the upper limit of the bucket holding) the duration which `percentile`% of those counted in `histogram` took no longer than
+    if (histogram.count == 0)
+        return 0;
+    qint64 rank = qMax(qint64(histogram.count * percentile / 100 + 0.5), qint64(1));
+    qint64 counted = 0;
+    for (int bucket = 0; bucket < histogramBuckets; bucket++)
+    {
+        counted += histogram.buckets[bucket];
+        if (counted >= rank)
+            return bucketUpperNsecs(bucket);
+    }
+    return bucketUpperNsecs(histogramBuckets - 1);
+}
+
+/*static*/ LifeMetrics::Histogram LifeMetrics::difference(const Histogram &later, const Histogram &earlier)
+{
+    // return what was counted in `later` since `earlier` (both from samples, `earlier` taken first)
+    Histogram histogram;
+    histogram.count = later.count - earlier.count;
+    histogram.totalNsecs = later.totalNsecs - earlier.totalNsecs;
+    for (int bucket = 0; bucket < histogramBuckets; bucket++)
+        histogram.buckets[bucket] = later.buckets[bucket] - earlier.buckets[bucket];
+    return histogram;
+}
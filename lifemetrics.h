@@ -0,0 +1,74 @@
+#ifndef LIFEMETRICS_H
+#define LIFEMETRICS_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+// live performance counters for the engine and the display, cheap enough to be always on
+// each counter is only ever added to by one thread at a time (a worker updates its own thread's counters, which have a cache line of their own),
+// with relaxed atomic adds, so recording never takes a lock or waits; any thread can take a `Sample` of the totals at any time,
+// and the difference between two samples gives what happened in between
+// durations are also counted in a histogram of power-of-2 buckets of microseconds
+class LifeMetrics
+{
+public:
+    // what is timed: each generation (or HashLife step) computed, and each time the board is drawn
+    enum Timing { TimingGeneration, TimingRender, TimingCount };
+    // bucket `b` counts durations of [2^b, 2^(b+1)) microseconds (bucket 0 also counts those under 1 microsecond, the last all longer ones)
+    static constexpr int histogramBuckets = 24;
+    // threads beyond this many share counters (by thread index modulo this)
+    static constexpr int maxThreads = 64;
+
+    struct Histogram {
+        qint64 count = 0;
+        qint64 totalNsecs = 0;
+        qint64 buckets[histogramBuckets] = {};
+    };
+    struct ThreadSample {
+        // time working on its share of the board, waiting at the barrier (or in the main thread, for the others to finish)
+        qint64 busyNsecs = 0;
+        qint64 waitNsecs = 0;
+        qint64 generations = 0;
+        int cpu = -1;
+    };
+    struct Sample {
+        Histogram timings[TimingCount];
+        QVector<ThreadSample> threads;
+        // (filled in by `LifeEngine::metricsSample()`)
+        qint64 generation = 0;
+        quint64 population = 0;
+        quint64 changedCells = 0;
+    };
+
+    LifeMetrics();
+    LifeMetrics(const LifeMetrics &) = delete;
+    LifeMetrics &operator=(const LifeMetrics &) = delete;
+
+    void recordTiming(Timing timing, qint64 nsecs);
+    void recordThread(int threadIndex, qint64 busyNsecs, qint64 waitNsecs);
+    void setThreadCpu(int threadIndex, int cpu);
+    Sample sample() const;
+    void reset();
+
+    static int bucketForNsecs(qint64 nsecs);
+    static qint64 bucketUpperNsecs(int bucket);
+    static qint64 percentileNsecs(const Histogram &histogram, double percentile);
+    static Histogram difference(const Histogram &later, const Histogram &earlier);
+
+private:
+    struct alignas(64) TimingCounters {
+        QAtomicInteger<qint64> count, totalNsecs;
+        QAtomicInteger<qint64> buckets[histogramBuckets];
+    };
+    struct alignas(64) ThreadCounters {
+        QAtomicInteger<qint64> busyNsecs, waitNsecs, generations;
+        QAtomicInt cpu;
+    };
+
+    TimingCounters timings[TimingCount];
+    ThreadCounters threads[maxThreads];
+    // one more than the highest thread index recorded since the last reset
+    QAtomicInt threadCount;
+};
+
+#endif // LIFEMETRICS_H
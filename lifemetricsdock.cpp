@@ -0,0 +1,293 @@
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPushButton>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QVBoxLayout>
+
+#include "lifemetricsdock.h"
+
+
+static QString durationText(double nsecs)
+{
+    // return a duration as text, in whichever of ns/us/ms/s suits its size
+    if (nsecs < 1000)
+        return QString("%1 ns").arg(nsecs, 0, 'f', 0);
+    if (nsecs < 1000000)
+        return QString("%1 us").arg(nsecs / 1000, 0, 'f', nsecs < 10000 ? 1 : 0);
+    if (nsecs < 1000000000)
+        return QString("%1 ms").arg(nsecs / 1000000, 0, 'f', nsecs < 10000000 ? 1 : 0);
+    return QString("%1 s").arg(nsecs / 1000000000, 0, 'f', 1);
+}
+
+
+////////// LifeMetricsDock Class //////////
+
+LifeMetricsDock::LifeMetricsDock(const LifeEngine &engine, QMutex &engineMutex, QWidget *parent /*= nullptr*/)
+    : QDockWidget("Performance Metrics", parent)
+    , engine(engine)
+    , engineMutex(engineMutex)
+{
+    setObjectName("metricsDock");
+    this->lastSampleNsecs = 0;
+
+    QWidget *widget = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(widget);
+    this->summaryLabel = new QLabel(widget);
+    summaryLabel->setTextFormat(Qt::RichText);
+    layout->addWidget(summaryLabel);
+    this->generationHistogram = new LifeHistogramWidget("Generation time", widget);
+    layout->addWidget(generationHistogram);
+    this->renderHistogram = new LifeHistogramWidget("Render time", widget);
+    layout->addWidget(renderHistogram);
+    this->threadLoad = new LifeThreadLoadWidget(widget);
+    layout->addWidget(threadLoad);
+    layout->addStretch();
+    QHBoxLayout *buttons = new QHBoxLayout;
+    QPushButton *exportButton = new QPushButton("Export CSV...", widget);
+    buttons->addStretch();
+    buttons->addWidget(exportButton);
+    layout->addLayout(buttons);
+    setWidget(widget);
+
+    this->timer.setInterval(sampleIntervalMsecs);
+    connect(&timer, &QTimer::timeout, this, &LifeMetricsDock::timerTimeout);
+    connect(exportButton, &QPushButton::clicked, this, &LifeMetricsDock::actionExportCsv);
+    clock.start();
+}
+
+/*virtual*/ void LifeMetricsDock::showEvent(QShowEvent *event) /*override*/
+{
+    // start sampling while shown, from a fresh sample (so the first interval does not cover the time spent hidden)
+    QDockWidget::showEvent(event);
+    {
+        QMutexLocker locker(&engineMutex);
+        this->lastSample = engine.metrics().sample();
+    }
+    this->lastSampleNsecs = clock.nsecsElapsed();
+    timer.start();
+}
+
+/*virtual*/ void LifeMetricsDock::hideEvent(QHideEvent *event) /*override*/
+{
+    // stop sampling while hidden
+    QDockWidget::hideEvent(event);
+    timer.stop();
+}
+
+/*slot*/ void LifeMetricsDock::timerTimeout()
+{
+    // take a sample on `this->timer` timeout, and show (and keep) the figures for the interval since the last one
+    LifeMetrics::Sample sample;
+    {
+        QMutexLocker locker(&engineMutex);
+        sample = engine.metricsSample();
+    }
+    qint64 nowNsecs = clock.nsecsElapsed();
+    double intervalNsecs = qMax(nowNsecs - lastSampleNsecs, qint64(1));
+    // (the metrics are reset when a run starts, after which the interval is measured from zero)
+    const LifeMetrics::Histogram &generations(sample.timings[LifeMetrics::TimingGeneration]);
+    const LifeMetrics::Histogram &renders(sample.timings[LifeMetrics::TimingRender]);
+    if (generations.count < lastSample.timings[LifeMetrics::TimingGeneration].count
+            || renders.count < lastSample.timings[LifeMetrics::TimingRender].count)
+        this->lastSample = LifeMetrics::Sample();
+    const LifeMetrics::Histogram generationDelta(LifeMetrics::difference(generations, lastSample.timings[LifeMetrics::TimingGeneration]));
+    const LifeMetrics::Histogram renderDelta(LifeMetrics::difference(renders, lastSample.timings[LifeMetrics::TimingRender]));
+
+    HistoryRow row;
+    row.elapsedMsecs = nowNsecs / 1000000;
+    row.generation = sample.generation;
+    row.generationsPerSecond = generationDelta.count * 1e9 / intervalNsecs;
+    row.generationMeanUsecs = generationDelta.count > 0 ? generationDelta.totalNsecs / 1000.0 / generationDelta.count : 0.0;
+    row.generationP50Usecs = LifeMetrics::percentileNsecs(generationDelta, 50) / 1000;
+    row.generationP99Usecs = LifeMetrics::percentileNsecs(generationDelta, 99) / 1000;
+    row.renders = renderDelta.count;
+    row.renderMeanUsecs = renderDelta.count > 0 ? renderDelta.totalNsecs / 1000.0 / renderDelta.count : 0.0;
+    row.population = sample.population;
+    row.changedCells = sample.changedCells;
+    for (int i = 0; i < sample.threads.count(); i++)
+    {
+        const LifeMetrics::ThreadSample &thread(sample.threads.at(i));
+        LifeMetrics::ThreadSample last;
+        if (i < lastSample.threads.count())
+            last = lastSample.threads.at(i);
+        row.threadBusyPercent.append(qBound(0.0, (thread.busyNsecs - last.busyNsecs) * 100 / intervalNsecs, 100.0));
+        row.threadWaitPercent.append(qBound(0.0, (thread.waitNsecs - last.waitNsecs) * 100 / intervalNsecs, 100.0));
+    }
+    if (history.count() >= maxHistoryRows)
+        history.removeFirst();
+    history.append(row);
+
+    summaryLabel->setText(QString("<table>"
+                                  "<tr><td>Generation</td><td align=right>%1</td></tr>"
+                                  "<tr><td>Generations/sec</td><td align=right>%2</td></tr>"
+                                  "<tr><td>Generation time</td><td align=right>%3 mean, %4 p99</td></tr>"
+                                  "<tr><td>Renders/sec</td><td align=right>%5 (%6 mean)</td></tr>"
+                                  "<tr><td>Population</td><td align=right>%7</td></tr>"
+                                  "<tr><td>Changed cells</td><td align=right>%8</td></tr>"
+                                  "</table>")
+                          .arg(row.generation).arg(row.generationsPerSecond, 0, 'f', 1)
+                          .arg(durationText(row.generationMeanUsecs * 1000), durationText(row.generationP99Usecs * 1000.0))
+                          .arg(row.renders * 1e9 / intervalNsecs, 0, 'f', 1).arg(durationText(row.renderMeanUsecs * 1000))
+                          .arg(row.population).arg(row.changedCells));
+    generationHistogram->setHistogram(generations);
+    renderHistogram->setHistogram(renders);
+    threadLoad->setThreads(sample.threads, row.threadBusyPercent, row.threadWaitPercent);
+
+    this->lastSample = sample;
+    this->lastSampleNsecs = nowNsecs;
+}
+
+/*slot*/ void LifeMetricsDock::actionExportCsv()
+{
+    // ask for a file and export the samples to it
+    QString fileName = QFileDialog::getSaveFileName(this, "Export Metrics", QString(), "CSV Files (*.csv)");
+    if (fileName.isEmpty())
+        return;
+    QString errorMessage;
+    if (!exportCsv(fileName, errorMessage))
+        QMessageBox::warning(this, "Export Metrics", errorMessage);
+}
+
+bool LifeMetricsDock::exportCsv(const QString &fileName, QString &errorMessage) const
+{
+    // write the figures for every sample kept to file `fileName` as CSV, a row per sample interval
+    // there are busy & wait columns for as many threads as the most any sample had
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    int threadCount = 0;
+    for (const HistoryRow &row : history)
+        threadCount = qMax(threadCount, row.threadBusyPercent.count());
+    QTextStream out(&file);
+    out << "elapsed_ms,generation,generations_per_sec,generation_mean_us,generation_p50_us,generation_p99_us,"
+           "renders,render_mean_us,population,changed_cells";
+    for (int i = 0; i < threadCount; i++)
+        out << QString(",thread%1_busy_pct,thread%1_wait_pct").arg(i);
+    out << '\n';
+    for (const HistoryRow &row : history)
+    {
+        out << row.elapsedMsecs << ',' << row.generation << ',' << QString::number(row.generationsPerSecond, 'f', 2) << ','
+            << QString::number(row.generationMeanUsecs, 'f', 2) << ',' << row.generationP50Usecs << ',' << row.generationP99Usecs << ','
+            << row.renders << ',' << QString::number(row.renderMeanUsecs, 'f', 2) << ',' << row.population << ',' << row.changedCells;
+        for (int i = 0; i < threadCount; i++)
+            if (i < row.threadBusyPercent.count())
+                out << ',' << QString::number(row.threadBusyPercent.at(i), 'f', 1) << ',' << QString::number(row.threadWaitPercent.at(i), 'f', 1);
+            else
+                out << ",,";
+        out << '\n';
+    }
+    out.flush();
+    if (!file.commit())
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    return true;
+}
+
+
+////////// LifeHistogramWidget Class //////////
+
+LifeHistogramWidget::LifeHistogramWidget(const QString &title, QWidget *parent /*= nullptr*/)
+    : QWidget(parent)
+{
+    this->title = title;
+    setMinimumHeight(100);
+}
+
+void LifeHistogramWidget::setHistogram(const LifeMetrics::Histogram &histogram)
+{
+    this->histogram = histogram;
+    update();
+}
+
+/*virtual*/ void LifeHistogramWidget::paintEvent(QPaintEvent *event) /*override*/
+{
+    // draw the title (with the count, mean & percentiles), then a bar per bucket from the first to the last in use,
+    // labelled underneath with each bucket's lower limit
+    Q_UNUSED(event);
+    QPainter painter(this);
+    QFontMetrics metrics(painter.fontMetrics());
+    int lineHeight = metrics.height();
+    QString heading(title);
+    if (histogram.count > 0)
+        heading += QString(": %1 counted, %2 mean, %3 p50, %4 p99").arg(histogram.count)
+                .arg(durationText(double(histogram.totalNsecs) / histogram.count))
+                .arg(durationText(LifeMetrics::percentileNsecs(histogram, 50)))
+                .arg(durationText(LifeMetrics::percentileNsecs(histogram, 99)));
+    painter.drawText(QRect(0, 0, width(), lineHeight), Qt::AlignLeft, heading);
+    if (histogram.count == 0)
+        return;
+
+    // (always show at least 8 buckets, so that a narrow distribution does not fill the width with one bar)
+    int first = 0, last = LifeMetrics::histogramBuckets - 1;
+    while (first < last && histogram.buckets[first] == 0)
+        first++;
+    while (last > first && histogram.buckets[last] == 0)
+        last--;
+    last = qMin(qMax(last, first + 7), LifeMetrics::histogramBuckets - 1);
+    first = qMax(qMin(first, last - 7), 0);
+    qint64 maxCount = 1;
+    for (int bucket = first; bucket <= last; bucket++)
+        maxCount = qMax(maxCount, histogram.buckets[bucket]);
+
+    int barCount = last - first + 1;
+    int chartTop = lineHeight + 2, chartBottom = height() - lineHeight - 2;
+    qreal barWidth = qreal(width()) / barCount;
+    for (int bucket = first; bucket <= last; bucket++)
+    {
+        qreal x = (bucket - first) * barWidth;
+        int barHeight = int((chartBottom - chartTop) * histogram.buckets[bucket] / maxCount);
+        painter.fillRect(QRectF(x + 1, chartBottom - barHeight, barWidth - 2, barHeight), QColor(Qt::darkCyan));
+        painter.drawText(QRectF(x, chartBottom + 2, barWidth, lineHeight), Qt::AlignHCenter,
+                         durationText(bucket == 0 ? 0 : LifeMetrics::bucketUpperNsecs(bucket - 1)));
+    }
+}
+
+
+////////// LifeThreadLoadWidget Class //////////
+
+LifeThreadLoadWidget::LifeThreadLoadWidget(QWidget *parent /*= nullptr*/)
+    : QWidget(parent)
+{
+
+}
+
+void LifeThreadLoadWidget::setThreads(const QVector<LifeMetrics::ThreadSample> &threads, const QVector<double> &busyPercent, const QVector<double> &waitPercent)
+{
+    bool resized = threads.count() != this->threads.count();
+    this->threads = threads;
+    this->busyPercent = busyPercent;
+    this->waitPercent = waitPercent;
+    if (resized)
+        updateGeometry();
+    update();
+}
+
+/*virtual*/ void LifeThreadLoadWidget::paintEvent(QPaintEvent *event) /*override*/
+{
+    // draw a row per thread: its label, then a bar across the rest of the width, busy in green then waiting in red
+    Q_UNUSED(event);
+    QPainter painter(this);
+    int rowHeight = 16;
+    int labelWidth = painter.fontMetrics().horizontalAdvance("#00 (CPU 000) ");
+    int barWidth = qMax(width() - labelWidth, 1);
+    for (int i = 0; i < threads.count(); i++)
+    {
+        int y = i * rowHeight;
+        QString label(threads.at(i).cpu >= 0 ? QString("#%1 (CPU %2)").arg(i).arg(threads.at(i).cpu) : QString("#%1").arg(i));
+        painter.drawText(QRect(0, y, labelWidth, rowHeight), Qt::AlignLeft | Qt::AlignVCenter, label);
+        int busyWidth = int(barWidth * busyPercent.value(i) / 100);
+        int waitWidth = int(barWidth * waitPercent.value(i) / 100);
+        painter.fillRect(QRect(labelWidth, y + 2, busyWidth, rowHeight - 4), QColor(Qt::darkGreen));
+        painter.fillRect(QRect(labelWidth + busyWidth, y + 2, waitWidth, rowHeight - 4), QColor(Qt::darkRed));
+        painter.drawRect(QRect(labelWidth, y + 2, barWidth - 1, rowHeight - 4));
+    }
+}
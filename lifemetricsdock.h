@@ -0,0 +1,109 @@
+#ifndef LIFEMETRICSDOCK_H
+#define LIFEMETRICSDOCK_H
+
+#include <QDockWidget>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+
+#include "lifeengine.h"
+#include "lifemetrics.h"
+
+class LifeHistogramWidget;
+class LifeThreadLoadWidget;
+
+
+// a dock showing the engine's metrics (see `LifeMetrics`) live: the rates & counts over the last sample interval,
+// histograms of generation & render times since the run started, and how busy each thread was
+// it samples the engine only while it is shown, and keeps every sample's figures for exporting as CSV
+class LifeMetricsDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr int sampleIntervalMsecs = 250;
+    // an hour's worth of samples
+    static constexpr int maxHistoryRows = 3600 * 1000 / sampleIntervalMsecs;
+
+    LifeMetricsDock(const LifeEngine &engine, QMutex &engineMutex, QWidget *parent = nullptr);
+
+    bool exportCsv(const QString &fileName, QString &errorMessage) const;
+
+protected:
+    virtual void showEvent(QShowEvent *event) override;
+    virtual void hideEvent(QHideEvent *event) override;
+
+private:
+    // the figures for one sample interval
+    struct HistoryRow {
+        qint64 elapsedMsecs;
+        qint64 generation;
+        double generationsPerSecond;
+        double generationMeanUsecs;
+        qint64 generationP50Usecs, generationP99Usecs;
+        qint64 renders;
+        double renderMeanUsecs;
+        quint64 population, changedCells;
+        // per thread, the percentage of the interval it was busy, and waiting
+        QVector<double> threadBusyPercent, threadWaitPercent;
+    };
+
+    const LifeEngine &engine;
+    QMutex &engineMutex;
+    QTimer timer;
+    QElapsedTimer clock;
+    LifeMetrics::Sample lastSample;
+    qint64 lastSampleNsecs;
+    QVector<HistoryRow> history;
+    QLabel *summaryLabel;
+    LifeHistogramWidget *generationHistogram, *renderHistogram;
+    LifeThreadLoadWidget *threadLoad;
+
+private slots:
+    void timerTimeout();
+    void actionExportCsv();
+};
+
+
+// draws a `LifeMetrics::Histogram` of durations as a bar chart, one bar per bucket
+class LifeHistogramWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LifeHistogramWidget(const QString &title, QWidget *parent = nullptr);
+
+    void setHistogram(const LifeMetrics::Histogram &histogram);
+    virtual QSize sizeHint() const override { return QSize(320, 120); }
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+
+private:
+    QString title;
+    LifeMetrics::Histogram histogram;
+};
+
+
+// draws each thread's busy & waiting time over a sample interval as a bar
+class LifeThreadLoadWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LifeThreadLoadWidget(QWidget *parent = nullptr);
+
+    void setThreads(const QVector<LifeMetrics::ThreadSample> &threads, const QVector<double> &busyPercent, const QVector<double> &waitPercent);
+    virtual QSize sizeHint() const override { return QSize(320, 16 * qMax(threads.count(), 1) + 8); }
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+
+private:
+    QVector<LifeMetrics::ThreadSample> threads;
+    QVector<double> busyPercent, waitPercent;
+};
+
+#endif // LIFEMETRICSDOCK_H
@@ -0,0 +1,157 @@
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "lifenuma.h"
+
+
+////////// LifeNumaTopology Class //////////
+
+LifeNumaTopology::LifeNumaTopology()
+{
+    // read the nodes & their CPUs (in node number order), falling back to a single node of all the CPUs
+#ifdef Q_OS_LINUX
+    QDir nodesDir("/sys/devices/system/node");
+    QStringList nodeDirs(nodesDir.entryList({ "node*" }, QDir::Dirs));
+    for (const QString &nodeDir : nodeDirs)
+    {
+        bool ok;
+        int id = nodeDir.mid(4).toInt(&ok);
+        if (!ok)
+            continue;
+        QFile file(nodesDir.filePath(nodeDir + "/cpulist"));
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        Node node;
+        node.id = id;
+        // (a node may have memory but no CPUs)
+        if (parseCpuList(QString::fromLatin1(file.readAll()).trimmed(), node.cpus) && !node.cpus.isEmpty())
+            nodeList.append(node);
+    }
+    std::sort(nodeList.begin(), nodeList.end(), [](const Node &a, const Node &b)->bool { return a.id < b.id; });
+#endif
+    if (nodeList.isEmpty())
+    {
+        Node node;
+        node.id = 0;
+        for (int cpu = 0; cpu < qMax(QThread::idealThreadCount(), 1); cpu++)
+            node.cpus.append(cpu);
+        nodeList.append(node);
+    }
+}
+
+/*static*/ const LifeNumaTopology &LifeNumaTopology::system()
+{
+    // return the topology of this machine (read once)
+    static const LifeNumaTopology topology;
+    return topology;
+}
+
+int LifeNumaTopology::nodeOfCpu(int cpu) const
+{
+    // return the id of the node CPU `cpu` is on, or -1 if it is not known
+    for (const Node &node : nodeList)
+        if (node.cpus.contains(cpu))
+            return node.id;
+    return -1;
+}
+
+int LifeNumaTopology::nodeIndexForWorker(int workerIndex, int workerCount) const
+{
+    // return the index (in `nodes()`) of the node worker `workerIndex` (of `workerCount`) belongs to
+    // the workers are shared out between the nodes in turn, in runs, so that neighbouring bands of the board are on the same node
+    Q_ASSERT(workerIndex >= 0 && workerIndex < workerCount);
+    return int(qint64(workerIndex) * nodeList.count() / workerCount);
+}
+
+int LifeNumaTopology::cpuForWorker(int workerIndex, int workerCount) const
+{
+    // return the CPU to pin worker `workerIndex` (of `workerCount`) to: one on its node,
+    // the workers of each node taking its CPUs in turn
+    int nodeIndex = nodeIndexForWorker(workerIndex, workerCount);
+    // (the first worker of the node is the first whose node index is `nodeIndex`)
+    int firstWorker = int((qint64(nodeIndex) * workerCount + nodeList.count() - 1) / nodeList.count());
+    const QVector<int> &cpus(nodeList.at(nodeIndex).cpus);
+    return cpus.at((workerIndex - firstWorker) % cpus.count());
+}
+
+QString LifeNumaTopology::description() const
+{
+    // return a description of the topology, e.g. "2 NUMA nodes: #0 (CPUs 0-15), #1 (CPUs 16-31)"
+    QStringList nodeTexts;
+    for (const Node &node : nodeList)
+        nodeTexts.append(QString("#%1 (CPUs %2)").arg(node.id).arg(cpuListText(node.cpus)));
+    return QString("%1 NUMA node%2: %3").arg(nodeList.count()).arg(nodeList.count() == 1 ? "" : "s").arg(nodeTexts.join(", "));
+}
+
+/*static*/ bool LifeNumaTopology::pageNodes(const QVector<const void *> &pages, QVector<int> &nodes)
+{
+    // set `nodes` to the id of the node each of the memory pages holding `pages` is on (-1 for a page not yet touched)
+    // return false if this is not known (only on Linux, by querying `move_pages()` without moving anything)
+    nodes.fill(-1, pages.count());
+#ifdef Q_OS_LINUX
+    QVector<void *> alignedPages(pages.count());
+    for (int i = 0; i < pages.count(); i++)
+        alignedPages[i] = reinterpret_cast<void *>(reinterpret_cast<quintptr>(pages.at(i)) & ~quintptr(pageSize() - 1));
+    QVector<int> status(pages.count());
+    if (syscall(SYS_move_pages, 0, static_cast<unsigned long>(pages.count()), alignedPages.data(), nullptr, status.data(), 0) != 0)
+        return false;
+    for (int i = 0; i < pages.count(); i++)
+        nodes[i] = status.at(i) >= 0 ? status.at(i) : -1;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*static*/ size_t LifeNumaTopology::pageSize()
+{
+    // return the size of a memory page
+#ifdef Q_OS_LINUX
+    static const size_t size = size_t(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+/*static*/ bool LifeNumaTopology::parseCpuList(const QString &text, QVector<int> &cpus)
+{
+    // parse a kernel CPU list, e.g. "0-3,8-11,16", into `cpus`
+    cpus.clear();
+    for (const QString &range : text.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList ends(range.split('-'));
+        bool ok1, ok2 = true;
+        int first = ends.at(0).toInt(&ok1);
+        int last = ends.count() > 1 ? ends.at(1).toInt(&ok2) : first;
+        if (!ok1 || !ok2 || ends.count() > 2 || first < 0 || last < first)
+            return false;
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.append(cpu);
+    }
+    return true;
+}
+
+/*static*/ QString LifeNumaTopology::cpuListText(const QVector<int> &cpus)
+{
+    // return `cpus` as a kernel CPU list, e.g. "0-3,8-11,16" (the opposite of `parseCpuList()`)
+    QStringList ranges;
+    for (int i = 0; i < cpus.count(); )
+    {
+        int j = i;
+        while (j + 1 < cpus.count() && cpus.at(j + 1) == cpus.at(j) + 1)
+            j++;
+        ranges.append(j > i ? QString("%1-%2").arg(cpus.at(i)).arg(cpus.at(j)) : QString::number(cpus.at(i)));
+        i = j + 1;
+    }
+    return ranges.join(',');
+}
@@ -0,0 +1,39 @@
+#ifndef LIFENUMA_H
+#define LIFENUMA_H
+
+#include <QString>
+#include <QVector>
+
+// the machine's NUMA topology: its nodes, and which CPUs are on each (on Linux, read from /sys/devices/system/node)
+// elsewhere, or if there is no NUMA information, it is a single node of all the CPUs
+// used to place the board's rows, and pin the worker pool's threads, so each worker's band of the board is on its own node
+class LifeNumaTopology
+{
+public:
+    struct Node {
+        int id;
+        QVector<int> cpus;
+    };
+
+    static const LifeNumaTopology &system();
+
+    const QVector<Node> &nodes() const { return nodeList; }
+    int nodeCount() const { return nodeList.count(); }
+    int nodeOfCpu(int cpu) const;
+    int nodeIndexForWorker(int workerIndex, int workerCount) const;
+    int cpuForWorker(int workerIndex, int workerCount) const;
+    QString description() const;
+
+    static bool pageNodes(const QVector<const void *> &pages, QVector<int> &nodes);
+    static size_t pageSize();
+
+private:
+    QVector<Node> nodeList;
+
+    LifeNumaTopology();
+
+    static bool parseCpuList(const QString &text, QVector<int> &cpus);
+    static QString cpuListText(const QVector<int> &cpus);
+};
+
+#endif // LIFENUMA_H
@@ -0,0 +1,354 @@
+#include <limits>
+
+#include <QFile>
+#include <QFileInfo>
+
+#include "lifepatternfile.h"
+
+
+////////// LifePatternFile Class //////////
+
+/*static*/ bool LifePatternFile::formatForFileName(const QString &fileName, Format &format)
+{
+    // set `format` from the file name's suffix, return false if it is not one of the formats
+    const QString suffix(QFileInfo(fileName).suffix().toLower());
+    if (suffix == "rle")
+        format = FormatRle;
+    else if (suffix == "cells")
+        format = FormatPlaintext;
+    else if (suffix == "mc")
+        format = FormatMacrocell;
+    else
+        return false;
+    return true;
+}
+
+/*static*/ QString LifePatternFile::fileDialogFilter()
+{
+    return "Life Patterns (*.rle *.cells *.mc);;RLE (*.rle);;Plaintext (*.cells);;Macrocell (*.mc)";
+}
+
+/*static*/ bool LifePatternFile::read(QIODevice &device, Format format, LifeEngine &engine, Info &info, QString &errorMessage)
+{
+    // replace the engine's cells by the pattern read from `device`, centred on the board
+    // the file's rule (if it has one) is returned in `info`, for the caller to apply
+    // return false (leaving the board empty) if the pattern is not valid
+    info = Info();
+    bool ok = false;
+    switch (format)
+    {
+    case FormatRle: ok = readRle(device, engine, info, errorMessage); break;
+    case FormatPlaintext: ok = readPlaintext(device, engine, info, errorMessage); break;
+    case FormatMacrocell: ok = readMacrocell(device, engine, info, errorMessage); break;
+    }
+    if (!ok)
+        engine.newBoard();
+    return ok;
+}
+
+/*static*/ void LifePatternFile::write(QIODevice &device, Format format, LifeEngine &engine)
+{
+    // write the engine's cells to `device`
+    switch (format)
+    {
+    case FormatRle: writeRle(device, engine); break;
+    case FormatPlaintext: writePlaintext(device, engine); break;
+    case FormatMacrocell: writeMacrocell(device, engine); break;
+    }
+}
+
+/*static*/ bool LifePatternFile::load(const QString &fileName, LifeEngine &engine, Info &info, QString &errorMessage)
+{
+    // read the pattern in file `fileName`, in the format for its suffix
+    Format format;
+    if (!formatForFileName(fileName, format))
+    {
+        errorMessage = QString("%1: not a pattern file type (.rle, .cells or .mc)").arg(fileName);
+        return false;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    if (!read(file, format, engine, info, errorMessage))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(errorMessage);
+        return false;
+    }
+    return true;
+}
+
+/*static*/ bool LifePatternFile::save(const QString &fileName, LifeEngine &engine, QString &errorMessage)
+{
+    // write the pattern to file `fileName`, in the format for its suffix
+    Format format;
+    if (!formatForFileName(fileName, format))
+    {
+        errorMessage = QString("%1: not a pattern file type (.rle, .cells or .mc)").arg(fileName);
+        return false;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    write(file, format, engine);
+    file.close();
+    if (file.error() != QFileDevice::NoError)
+    {
+        errorMessage = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    return true;
+}
+
+/*static*/ bool LifePatternFile::readRle(QIODevice &device, LifeEngine &engine, Info &info, QString &errorMessage)
+{
+    // "#" lines are comments ("#N" the name), then a header line "x = <width>, y = <height>[, rule = <rule>]"
+    // then the cells, a row at a time from the top left, as "<count><tag>": tag 'b' is empty cells, 'o' occupied cells
+    // and '$' the end of a row, a missing count being 1; the pattern ends at '!'
+    // the cells are decoded a line at a time, each run of occupied cells going straight onto the board
+    static constexpr int maxCount = std::numeric_limits<int>::max() / 16;
+    int lineNumber = 0;
+    auto fail = [&errorMessage, &lineNumber](const QString &message)->bool {
+        errorMessage = QString("Line %1: %2").arg(lineNumber).arg(message);
+        return false;
+    };
+    QByteArray line;
+    while (!device.atEnd() && (line.isEmpty() || line.startsWith('#')))
+    {
+        line = device.readLine().trimmed();
+        lineNumber++;
+        if (line.startsWith("#N"))
+            info.name = QString::fromUtf8(line.mid(2).trimmed());
+    }
+    if (!line.startsWith('x'))
+        return fail("missing \"x = ..., y = ...\" header line");
+    // (the rule is the rest of the line, as it may have a ":" suffix for a bounded grid with commas in it)
+    for (QByteArray fields(line); !fields.isEmpty(); )
+    {
+        int equals = fields.indexOf('=');
+        if (equals < 0)
+            return fail("invalid header line");
+        const QByteArray key(fields.left(equals).trimmed());
+        fields = fields.mid(equals + 1);
+        int comma = key == "rule" ? -1 : fields.indexOf(',');
+        const QByteArray value(comma < 0 ? fields.trimmed() : fields.left(comma).trimmed());
+        fields = comma < 0 ? QByteArray() : fields.mid(comma + 1);
+        bool ok = true;
+        if (key == "x")
+            info.width = value.toInt(&ok);
+        else if (key == "y")
+            info.height = value.toInt(&ok);
+        else if (key == "rule")
+            // (the board's own size & edges stand in for any bounded grid)
+            ok = info.hasRule = LifeRule::parse(QString::fromUtf8(value.split(':').first()), info.rule);
+        if (!ok || info.width < 0 || info.height < 0)
+            return fail(QString("invalid header value \"%1\"").arg(QString::fromUtf8(value)));
+    }
+
+    engine.newBoard();
+    int size = engine.boardSize();
+    int top = (size - info.height) / 2, left = (size - info.width) / 2;
+    int y = 0, x = 0, count = 0;
+    while (!device.atEnd())
+    {
+        line = device.readLine();
+        lineNumber++;
+        for (char c : line)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                count = (count * 10) + (c - '0');
+                if (count > maxCount)
+                    return fail("count too large");
+                continue;
+            }
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+                continue;
+            int n = count > 0 ? count : 1;
+            count = 0;
+            if (c == '!')
+                return true;
+            else if (c == '$')
+            {
+                y += n;
+                x = 0;
+            }
+            else if (c == 'b' || c == '.')
+                x += n;
+            // (any other letter is a state of a multi-state rule, taken as occupied)
+            else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+            {
+                engine.setCellRun(top + y, left + x, n);
+                x += n;
+            }
+            else
+                return fail(QString("invalid character '%1'").arg(QChar(c)));
+            if (x > maxCount || y > maxCount)
+                return fail("pattern too large");
+        }
+    }
+    return fail("missing '!' at end of pattern");
+}
+
+/*static*/ bool LifePatternFile::readPlaintext(QIODevice &device, LifeEngine &engine, Info &info, QString &errorMessage)
+{
+    // "!" lines are comments ("!Name:" the name), every other line is a row of cells, '.' empty and 'O' (or '*') occupied
+    // the rows are read in first, to centre the pattern by its size, then decoded a run of occupied cells at a time
+    QList<QByteArray> rows;
+    while (!device.atEnd())
+    {
+        QByteArray line(device.readLine());
+        while (line.endsWith('\n') || line.endsWith('\r'))
+            line.chop(1);
+        if (line.startsWith('!'))
+        {
+            if (line.startsWith("!Name:"))
+                info.name = QString::fromUtf8(line.mid(6).trimmed());
+            continue;
+        }
+        rows.append(line);
+        info.width = qMax(info.width, line.size());
+    }
+    info.height = rows.count();
+
+    engine.newBoard();
+    int size = engine.boardSize();
+    int top = (size - info.height) / 2, left = (size - info.width) / 2;
+    for (int y = 0; y < rows.count(); y++)
+    {
+        const QByteArray &row(rows.at(y));
+        for (int x = 0; x < row.size(); x++)
+        {
+            char c = row.at(x);
+            if (c == 'O' || c == '*')
+            {
+                int xStart = x;
+                while (x + 1 < row.size() && (row.at(x + 1) == 'O' || row.at(x + 1) == '*'))
+                    x++;
+                engine.setCellRun(top + y, left + xStart, x + 1 - xStart);
+            }
+            else if (c != '.' && c != ' ')
+            {
+                errorMessage = QString("Row %1: invalid character '%2'").arg(y + 1).arg(QChar(c));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*static*/ bool LifePatternFile::readMacrocell(QIODevice &device, LifeEngine &engine, Info &info, QString &errorMessage)
+{
+    // the nodes are read by the engine (see `LifeEngine::readMacrocell()`), the rule & name come from the "#R" & "#N" header lines
+    QStringList headerLines;
+    if (!engine.readMacrocell(device, headerLines, errorMessage))
+        return false;
+    for (const QString &line : headerLines)
+        if (line.startsWith("#R"))
+        {
+            info.hasRule = LifeRule::parse(line.mid(2), info.rule);
+            if (!info.hasRule)
+            {
+                errorMessage = QString("unsupported rule \"%1\"").arg(line.mid(2).trimmed());
+                return false;
+            }
+        }
+        else if (line.startsWith("#N"))
+            info.name = line.mid(2).trimmed();
+    return true;
+}
+
+/*static*/ void LifePatternFile::writeRle(QIODevice &device, const LifeEngine &engine)
+{
+    // the header line, then the rows of the occupied cells' bounding box as runs of "<count><tag>", in lines of up to `rleLineLength`
+    // empty rows are folded into the count of the next '$', and empty cells at the end of a row are left out
+    int top, left, bottom, right;
+    if (!liveBounds(engine, top, left, bottom, right))
+        top = left = bottom = right = 0;
+    device.write(QString("x = %1, y = %2, rule = %3\n").arg(right - left).arg(bottom - top).arg(engine.rule().toString()).toUtf8());
+    // (the line buffer's capacity is reserved, so that it is allocated once)
+    QByteArray line;
+    line.reserve(rleLineLength + 1);
+    auto writeRun = [&device, &line](int count, char tag) {
+        char run[16];
+        int length = count > 1 ? qsnprintf(run, sizeof(run), "%d", count) : 0;
+        run[length++] = tag;
+        if (line.size() + length > rleLineLength)
+        {
+            line += '\n';
+            device.write(line);
+            line.resize(0);
+        }
+        line.append(run, length);
+    };
+    int endedRows = 0;
+    for (int y = top; y < bottom; y++)
+    {
+        int x = left;
+        engine.forEachLiveRun(y, [&writeRun, &endedRows, &x](int runX, int length) {
+            if (endedRows > 0)
+            {
+                writeRun(endedRows, '$');
+                endedRows = 0;
+            }
+            if (runX > x)
+                writeRun(runX - x, 'b');
+            writeRun(length, 'o');
+            x = runX + length;
+        });
+        endedRows++;
+    }
+    writeRun(1, '!');
+    line += '\n';
+    device.write(line);
+}
+
+/*static*/ void LifePatternFile::writePlaintext(QIODevice &device, const LifeEngine &engine)
+{
+    // the rows of the occupied cells' bounding box, 'O' for occupied and '.' for empty, leaving out empty cells at the end of a row
+    int top, left, bottom, right;
+    if (!liveBounds(engine, top, left, bottom, right))
+        return;
+    // (the row buffer's capacity is reserved, so that it is allocated once)
+    QByteArray row;
+    row.reserve(right - left + 1);
+    for (int y = top; y < bottom; y++)
+    {
+        row.resize(0);
+        engine.forEachLiveRun(y, [&row, left](int x, int length) {
+            row.append((x - left) - row.size(), '.');
+            row.append(length, 'O');
+        });
+        row += '\n';
+        device.write(row);
+    }
+}
+
+/*static*/ void LifePatternFile::writeMacrocell(QIODevice &device, LifeEngine &engine)
+{
+    // the header & rule lines, then the nodes written by the engine (see `LifeEngine::writeMacrocell()`)
+    device.write("[M2] (conwaylife)\n");
+    device.write(QString("#R %1\n").arg(engine.rule().toString()).toUtf8());
+    engine.writeMacrocell(device);
+}
+
+/*static*/ bool LifePatternFile::liveBounds(const LifeEngine &engine, int &top, int &left, int &bottom, int &right)
+{
+    // set `top`, `left` and (exclusive) `bottom`, `right` to the bounding box of the occupied board positions
+    // return false if there are none
+    top = left = std::numeric_limits<int>::max();
+    bottom = right = std::numeric_limits<int>::min();
+    for (int y = 0; y < engine.boardSize(); y++)
+        engine.forEachLiveRun(y, [&top, &left, &bottom, &right, y](int x, int length) {
+            top = qMin(top, y);
+            bottom = y + 1;
+            left = qMin(left, x);
+            right = qMax(right, x + length);
+        });
+    return bottom > top;
+}
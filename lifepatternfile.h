@@ -0,0 +1,47 @@
+#ifndef LIFEPATTERNFILE_H
+#define LIFEPATTERNFILE_H
+
+#include <QIODevice>
+#include <QString>
+
+#include "lifeengine.h"
+#include "liferule.h"
+
+// reading & writing patterns in the common Life file formats:
+// RLE (".rle", run-length encoded), plaintext (".cells", one character per cell) and Macrocell (".mc", Golly's quadtree format)
+// readers decode straight into the engine's board a run of cells at a time, and writers encode from it a run at a time,
+// so neither builds a list of cells (RLE & plaintext are of the board, Macrocell is of the whole universe of the unbounded backends)
+class LifePatternFile
+{
+public:
+    enum Format { FormatRle, FormatPlaintext, FormatMacrocell };
+    // what a file said about its pattern
+    struct Info {
+        QString name;
+        int width = 0, height = 0;
+        bool hasRule = false;
+        LifeRule rule;
+    };
+
+    static bool formatForFileName(const QString &fileName, Format &format);
+    static QString fileDialogFilter();
+
+    static bool read(QIODevice &device, Format format, LifeEngine &engine, Info &info, QString &errorMessage);
+    static void write(QIODevice &device, Format format, LifeEngine &engine);
+    static bool load(const QString &fileName, LifeEngine &engine, Info &info, QString &errorMessage);
+    static bool save(const QString &fileName, LifeEngine &engine, QString &errorMessage);
+
+private:
+    // RLE lines are kept to this length, as most readers expect
+    static constexpr int rleLineLength = 70;
+
+    static bool readRle(QIODevice &device, LifeEngine &engine, Info &info, QString &errorMessage);
+    static bool readPlaintext(QIODevice &device, LifeEngine &engine, Info &info, QString &errorMessage);
+    static bool readMacrocell(QIODevice &device, LifeEngine &engine, Info &info, QString &errorMessage);
+    static void writeRle(QIODevice &device, const LifeEngine &engine);
+    static void writePlaintext(QIODevice &device, const LifeEngine &engine);
+    static void writeMacrocell(QIODevice &device, LifeEngine &engine);
+    static bool liveBounds(const LifeEngine &engine, int &top, int &left, int &bottom, int &right);
+};
+
+#endif // LIFEPATTERNFILE_H
@@ -0,0 +1,64 @@
+#include "liferandom.h"
+
+
+////////// LifeRandom Class //////////
+
+/*static*/ void LifeRandom::generate(quint64 seed, quint32 counter0, quint32 counter1, quint32 counter2, quint32 counter3, quint32 result[4])
+{
+    // set `result` to the 128 random bits for the counter (`counter0` to `counter3`) under key `seed`
+    // (Philox4x32 with 10 rounds, as in Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3")
+    static constexpr quint32 multiplier0 = 0xD2511F53, multiplier1 = 0xCD9E8D57;
+    static constexpr quint32 keyIncrement0 = 0x9E3779B9, keyIncrement1 = 0xBB67AE85;
+    quint32 c0 = counter0, c1 = counter1, c2 = counter2, c3 = counter3;
+    quint32 key0 = quint32(seed), key1 = quint32(seed >> 32);
+    for (int round = 0; round < 10; round++)
+    {
+        quint64 product0 = quint64(multiplier0) * c0;
+        quint64 product1 = quint64(multiplier1) * c2;
+        c0 = quint32(product1 >> 32) ^ c1 ^ key0;
+        c1 = quint32(product1);
+        c2 = quint32(product0 >> 32) ^ c3 ^ key1;
+        c3 = quint32(product0);
+        key0 += keyIncrement0;
+        key1 += keyIncrement1;
+    }
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+
+/*static*/ void LifeRandom::fillRow(quint64 seed, int y, double density, quint64 *words, int wordCount)
+{
+    // fill the `wordCount` words of row `y` with random bits, each set with probability `density`, 64 bits at a time
+    // a bit of probability `threshold / densitySteps` is built from one random word per binary digit of `threshold`,
+    // from the lowest set digit up: OR-ing in a random word for a 1 takes p to (1 + p) / 2, AND-ing for a 0 takes it to p / 2
+    // (so a density of 0.5 costs one random word, 0.25 or 0.75 two, and so on)
+    // the counter is (pair of words, row, digit, 0), each draw giving two words
+    Q_ASSERT(density >= 0 && density <= 1);
+    quint32 threshold = quint32(qRound(density * densitySteps));
+    if (threshold == 0 || threshold == quint32(densitySteps))
+    {
+        for (int i = 0; i < wordCount; i++)
+            words[i] = threshold == 0 ? 0 : ~quint64(0);
+        return;
+    }
+    int lowestDigit = qCountTrailingZeroBits(threshold);
+    for (int pair = 0; pair < (wordCount + 1) / 2; pair++)
+    {
+        quint64 bits[2] = { 0, 0 };
+        for (int digit = lowestDigit; digit < densityBits; digit++)
+        {
+            quint32 random[4];
+            generate(seed, quint32(pair), quint32(y), quint32(digit), 0, random);
+            quint64 random0 = quint64(random[0]) | (quint64(random[1]) << 32);
+            quint64 random1 = quint64(random[2]) | (quint64(random[3]) << 32);
+            bool one = (threshold >> digit) & 1;
+            bits[0] = one ? (bits[0] | random0) : (bits[0] & random0);
+            bits[1] = one ? (bits[1] | random1) : (bits[1] & random1);
+        }
+        words[pair * 2] = bits[0];
+        if ((pair * 2) + 1 < wordCount)
+            words[(pair * 2) + 1] = bits[1];
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef LIFERANDOM_H
+#define LIFERANDOM_H
+
+#include <QtGlobal>
+
+// a counter-based pseudo-random generator (Philox4x32-10): each draw is a pure function of the seed and a counter,
+// so any part of the sequence can be generated on its own, in any order, in any thread, always giving the same numbers
+// used to fill the board a row at a time in parallel, identically for a given seed whatever the number of threads
+class LifeRandom
+{
+public:
+    // the density of occupied cells is rounded to a multiple of 1/`densitySteps`
+    static constexpr int densityBits = 16;
+    static constexpr int densitySteps = 1 << densityBits;
+
+    static void generate(quint64 seed, quint32 counter0, quint32 counter1, quint32 counter2, quint32 counter3, quint32 result[4]);
+    static void fillRow(quint64 seed, int y, double density, quint64 *words, int wordCount);
+};
+
+#endif // LIFERANDOM_H
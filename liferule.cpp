@@ -0,0 +1,107 @@
+#include <QStringList>
+
+#include "liferule.h"
+
+
+////////// LifeRule Class //////////
+
+static const QVector<LifeRule::NamedRule> namedRuleList
+{
+    { "Conway's Life", "B3/S23" },
+    { "HighLife", "B36/S23" },
+    { "Day & Night", "B3678/S34678" },
+    { "Seeds", "B2/S" },
+    { "Life without Death", "B3/S012345678" },
+    { "Maze", "B3/S12345" },
+    { "Morley", "B368/S245" },
+    { "2x2", "B36/S125" },
+    { "Replicator", "B1357/S1357" },
+};
+
+/*static*/ const QVector<LifeRule::NamedRule> &LifeRule::namedRules()
+{
+    return namedRuleList;
+}
+
+LifeRule::LifeRule()
+{
+    this->birth = conwayBirthMask;
+    this->survival = conwaySurvivalMask;
+    buildTables();
+}
+
+LifeRule::LifeRule(CountMask birthMask, CountMask survivalMask)
+{
+    Q_ASSERT(birthMask < (1 << 9) && survivalMask < (1 << 9));
+    // birth at 0 neighbours would fill all of (unbounded) empty space
+    Q_ASSERT(!(birthMask & 1));
+    this->birth = birthMask;
+    this->survival = survivalMask;
+    buildTables();
+}
+
+/*static*/ bool LifeRule::parse(const QString &text, LifeRule &rule)
+{
+    // parse a rule in B/S notation ("B3/S23"), either way round ("S23/B3"), or in the older S/B notation ("23/3")
+    // return false if it is not a valid rule, or is one which gives birth at 0 neighbours
+    QStringList parts(text.trimmed().toUpper().split('/'));
+    if (parts.count() != 2)
+        return false;
+    bool lettered = parts.at(0).startsWith('B') || parts.at(0).startsWith('S');
+    if (!lettered)
+    {
+        parts[0].prepend('S');
+        parts[1].prepend('B');
+    }
+    CountMask masks[2] = { 0, 0 };
+    bool seen[2] = { false, false };
+    for (const QString &part : parts)
+    {
+        if (part.isEmpty() || (part.at(0) != 'B' && part.at(0) != 'S'))
+            return false;
+        int which = part.at(0) == 'B' ? 0 : 1;
+        if (seen[which])
+            return false;
+        seen[which] = true;
+        for (int i = 1; i < part.length(); i++)
+        {
+            int n = part.at(i).digitValue();
+            if (n < 0 || n > 8)
+                return false;
+            masks[which] |= 1 << n;
+        }
+    }
+    if (masks[0] & 1)
+        return false;
+    rule = LifeRule(masks[0], masks[1]);
+    return true;
+}
+
+QString LifeRule::toString() const
+{
+    // return the rule in B/S notation
+    QString text("B");
+    for (int n = 0; n <= 8; n++)
+        if (birth & (1 << n))
+            text += QString::number(n);
+    text += "/S";
+    for (int n = 0; n <= 8; n++)
+        if (survival & (1 << n))
+            text += QString::number(n);
+    return text;
+}
+
+void LifeRule::buildTables()
+{
+    // build the next state table for (occupied, neighbours), and from it the table for every 3x3 neighbourhood
+    this->transitions = quint32(birth) | (quint32(survival) << 9);
+    for (int neighbourhood = 0; neighbourhood < 512; neighbourhood++)
+    {
+        bool occupied = neighbourhood & (1 << 4);
+        int neighbours = 0;
+        for (int bit = 0; bit < 9; bit++)
+            if (bit != 4 && (neighbourhood & (1 << bit)))
+                neighbours++;
+        table3x3[neighbourhood] = nextState(occupied, neighbours);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef LIFERULE_H
+#define LIFERULE_H
+
+#include <QString>
+#include <QVector>
+
+// a Life-like rule: the neighbour counts (0 to 8) at which an empty cell is born, and at which an occupied cell survives
+// written in B/S notation, e.g. "B3/S23" (Conway's Life, the default), "B36/S23" (HighLife), "B3678/S34678" (Day & Night)
+// the rule is compiled into lookup tables, so that evaluating it costs the same whatever the rule is
+class LifeRule
+{
+public:
+    typedef quint16 CountMask;
+
+    struct NamedRule {
+        QString name;
+        QString rule;
+    };
+    static const QVector<NamedRule> &namedRules();
+
+    LifeRule();
+    LifeRule(CountMask birthMask, CountMask survivalMask);
+
+    static bool parse(const QString &text, LifeRule &rule);
+    QString toString() const;
+    // bit `n` of the masks is set if the rule applies at `n` neighbours
+    CountMask birthMask() const { return birth; }
+    CountMask survivalMask() const { return survival; }
+    bool isConway() const { return birth == conwayBirthMask && survival == conwaySurvivalMask; }
+
+    // whether a cell is occupied next generation, from whether it is occupied now and how many neighbours it has
+    bool nextState(bool occupied, int neighbours) const
+    {
+        return (transitions >> (neighbours + (occupied ? 9 : 0))) & 1;
+    }
+    // whether the centre cell of a 3x3 neighbourhood is occupied next generation
+    // bit `(3 * (dx + 1)) + (dy + 1)` of `neighbourhood` is the cell at offset (dy, dx), so the centre is bit 4
+    // and moving one cell to the right is `(neighbourhood >> 3) | (nextColumn << 6)`, where a column is its 3 bits from the top
+    bool nextState3x3(int neighbourhood) const { return table3x3[neighbourhood]; }
+
+    bool operator==(const LifeRule &other) const { return birth == other.birth && survival == other.survival; }
+    bool operator!=(const LifeRule &other) const { return !(*this == other); }
+
+private:
+    static constexpr CountMask conwayBirthMask = 1 << 3;
+    static constexpr CountMask conwaySurvivalMask = (1 << 2) | (1 << 3);
+
+    CountMask birth, survival;
+    // bit `n` is birth at `n` neighbours, bit `9 + n` is survival at `n` neighbours
+    quint32 transitions;
+    quint8 table3x3[512];
+
+    void buildTables();
+};
+
+#endif // LIFERULE_H
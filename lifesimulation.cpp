@@ -0,0 +1,114 @@
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include "lifesimulation.h"
+
+
+////////// LifeSimulation Class //////////
+
+LifeSimulation::LifeSimulation(LifeEngine &engine)
+    : engine(engine)
+{
+    this->thread = nullptr;
+    this->stepDelay = 0;
+    this->frameInterval = defaultFrameIntervalMsecs;
+    this->region = { 0, 0, 0, 0, 1 };
+    this->frontIndex = 0;
+    this->readyState = 1;
+    this->backIndex = 2;
+}
+
+LifeSimulation::~LifeSimulation()
+{
+    stop();
+}
+
+void LifeSimulation::start()
+{
+    // start running generations continuously in the simulation thread
+    // a snapshot of the current generation is published first, so that there is always one to acquire
+    if (thread != nullptr)
+        return;
+    publishSnapshot();
+    this->stopRequested = 0;
+    this->thread = QThread::create([this]()->void { this->run(); });
+    thread->start();
+}
+
+void LifeSimulation::stop()
+{
+    // stop running generations, waiting for the current one to finish
+    if (thread == nullptr)
+        return;
+    this->stopRequested = 1;
+    thread->wait();
+    delete thread;
+    this->thread = nullptr;
+}
+
+void LifeSimulation::setRegion(int top, int left, int rows, int columns, int cellsPerPixel)
+{
+    // set the region of the board which published snapshots hold, and how many cells across each of their pixels covers
+    // (takes effect from the next snapshot)
+    Q_ASSERT(cellsPerPixel > 0);
+    QMutexLocker locker(&regionMutex);
+    this->region = { top, left, qMax(rows, 0), qMax(columns, 0), cellsPerPixel };
+}
+
+bool LifeSimulation::acquireSnapshot()
+{
+    // make the latest published snapshot the one returned by `snapshot()`, without waiting
+    // return whether there was a new one since the last call
+    if (!(readyState.loadAcquire() & freshSnapshot))
+        return false;
+    this->frontIndex = readyState.fetchAndStoreAcquire(frontIndex) & ~freshSnapshot;
+    return true;
+}
+
+void LifeSimulation::publishSnapshot()
+{
+    // fill the back buffer from the engine, then make it the ready one
+    // the caller must be the only thread touching the engine
+    LifeSnapshot &snapshot(snapshots[backIndex]);
+    {
+        QMutexLocker locker(&regionMutex);
+        snapshot.top = region.top;
+        snapshot.left = region.left;
+        snapshot.rows = region.rows;
+        snapshot.columns = region.columns;
+        snapshot.cellsPerPixel = region.cellsPerPixel;
+    }
+    snapshot.generation = engine.generationNumber();
+    snapshot.pixelRows = (snapshot.rows + snapshot.cellsPerPixel - 1) / snapshot.cellsPerPixel;
+    snapshot.pixelColumns = (snapshot.columns + snapshot.cellsPerPixel - 1) / snapshot.cellsPerPixel;
+    // (lines are 32-bit aligned, as `QImage` wants)
+    snapshot.bytesPerLine = (snapshot.pixelColumns + 3) & ~3;
+    snapshot.pixels.resize(snapshot.pixelRows * snapshot.bytesPerLine);
+    engine.rasterize(snapshot.top, snapshot.left, snapshot.rows, snapshot.columns, snapshot.cellsPerPixel,
+                     snapshot.pixels.data(), snapshot.bytesPerLine);
+    snapshot.hasBounds = engine.boundingRect(snapshot.boundsTop, snapshot.boundsLeft, snapshot.boundsBottom, snapshot.boundsRight);
+    this->backIndex = readyState.fetchAndStoreRelease(backIndex | freshSnapshot) & ~freshSnapshot;
+}
+
+void LifeSimulation::run()
+{
+    // the simulation thread: run generations until asked to stop,
+    // publishing a snapshot whenever the frame interval has passed since the last one
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    while (!stopRequested.loadRelaxed())
+    {
+        {
+            QMutexLocker locker(&mutex);
+            engine.step();
+            if (frameTimer.elapsed() >= frameInterval.loadRelaxed())
+            {
+                publishSnapshot();
+                frameTimer.restart();
+            }
+        }
+        int delay = stepDelay.loadRelaxed();
+        if (delay > 0)
+            QThread::msleep(delay);
+    }
+}
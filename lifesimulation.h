@@ -0,0 +1,71 @@
+#ifndef LIFESIMULATION_H
+#define LIFESIMULATION_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+#include "lifeengine.h"
+
+// an immutable picture of the engine, published by `LifeSimulation` for the display to draw from
+// it holds the region of the board last asked for by `LifeSimulation::setRegion()`, rendered by `LifeEngine::rasterize()`
+struct LifeSnapshot {
+    qint64 generation = 0;
+    int top = 0, left = 0, rows = 0, columns = 0, cellsPerPixel = 1;
+    int pixelRows = 0, pixelColumns = 0, bytesPerLine = 0;
+    QVector<quint8> pixels;
+    // the bounds of the occupied cells, if known (see `LifeEngine::boundingRect()`)
+    bool hasBounds = false;
+    qint64 boundsTop = 0, boundsLeft = 0, boundsBottom = 0, boundsRight = 0;
+};
+
+// runs the engine's generations continuously in its own thread, so that the display does not hold up the simulation
+// at most once per frame interval, it publishes a snapshot of the region being shown into a triple buffer,
+// which the display picks up (without waiting) at its own rate
+// while running, any other thread must hold `engineMutex()` while it touches the engine
+class LifeSimulation
+{
+public:
+    static constexpr int defaultFrameIntervalMsecs = 16;
+
+    LifeSimulation(LifeEngine &engine);
+    ~LifeSimulation();
+    LifeSimulation(const LifeSimulation &) = delete;
+    LifeSimulation &operator=(const LifeSimulation &) = delete;
+
+    QMutex &engineMutex() { return mutex; }
+    bool isRunning() const { return thread != nullptr; }
+    void start();
+    void stop();
+    void setStepDelay(int msecs) { stepDelay.storeRelaxed(msecs); }
+    void setFrameInterval(int msecs) { frameInterval.storeRelaxed(msecs); }
+    void setRegion(int top, int left, int rows, int columns, int cellsPerPixel);
+
+    bool acquireSnapshot();
+    const LifeSnapshot &snapshot() const { return snapshots[frontIndex]; }
+
+private:
+    // bit set in `readyState` when the ready buffer holds a snapshot the reader has not yet acquired
+    static constexpr int freshSnapshot = 4;
+
+    LifeEngine &engine;
+    QThread *thread;
+    QMutex mutex;
+    QAtomicInt stopRequested, stepDelay, frameInterval;
+    // the region of the board to publish, protected by `regionMutex`
+    QMutex regionMutex;
+    struct {
+        int top, left, rows, columns, cellsPerPixel;
+    } region;
+    // triple buffer: the writer fills `snapshots[backIndex]`, the reader draws `snapshots[frontIndex]`,
+    // and the third (index in `readyState`) is the latest complete one, exchanged atomically with either
+    LifeSnapshot snapshots[3];
+    int frontIndex, backIndex;
+    QAtomicInt readyState;
+
+    void run();
+    void publishSnapshot();
+};
+
+#endif // LIFESIMULATION_H
@@ -0,0 +1,231 @@
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "lifenuma.h"
+#include "lifeworkerpool.h"
+
+
+////////// LifeBarrier Class //////////
+
+LifeBarrier::LifeBarrier(int count /*= 1*/)
+{
+    Q_ASSERT(count > 0);
+    this->count = count;
+    this->waiting = 0;
+    this->phase = 0;
+}
+
+void LifeBarrier::setCount(int count)
+{
+    // set the number of threads which wait at the barrier
+    // must only be called while no thread is waiting
+    QMutexLocker locker(&mutex);
+    Q_ASSERT(count > 0);
+    Q_ASSERT(waiting == 0);
+    this->count = count;
+}
+
+void LifeBarrier::wait(const std::function<void()> &completion /*= nullptr*/)
+{
+    // wait until all `count` threads have arrived at the barrier
+    // the last thread to arrive calls `completion` (if any) before releasing the others
+    QMutexLocker locker(&mutex);
+    quint64 arrivalPhase = phase;
+    if (++waiting == count)
+    {
+        if (completion)
+            completion();
+        waiting = 0;
+        phase++;
+        condition.wakeAll();
+        return;
+    }
+    while (phase == arrivalPhase)
+        condition.wait(&mutex);
+}
+
+
+////////// LifeWorkerPool Class //////////
+
+LifeWorkerPool::LifeWorkerPool()
+{
+    this->jobSequence = 0;
+    this->quitting = false;
+    this->jobGenerations = 0;
+    this->jobWork = nullptr;
+    this->jobBetweenGenerations = nullptr;
+    this->metrics = nullptr;
+    this->isNumaLocal = false;
+}
+
+LifeWorkerPool::~LifeWorkerPool()
+{
+    stopThreads();
+}
+
+int LifeWorkerPool::threadCount() const
+{
+    // return the number of threads, including the one calling `run()`
+    return threads.count() + 1;
+}
+
+void LifeWorkerPool::setThreadCount(int threadCount)
+{
+    // set the number of threads, including the one calling `run()`
+    // (re-)starts the worker threads if the number has changed
+    Q_ASSERT(threadCount > 0);
+    if (threadCount == this->threadCount())
+        return;
+    stopThreads();
+    startThreads(threadCount);
+}
+
+void LifeWorkerPool::setNumaLocal(bool numaLocal)
+{
+    // set whether each worker is pinned to a CPU on its own NUMA node
+    // (re-)starts the worker threads if it has changed, so they are pinned afresh
+    if (numaLocal == isNumaLocal)
+        return;
+    this->isNumaLocal = numaLocal;
+    int threadCount = this->threadCount();
+    stopThreads();
+    startThreads(threadCount);
+}
+
+int LifeWorkerPool::cpuForWorker(int workerIndex, int workerCount) const
+{
+    // return the CPU to pin worker `workerIndex` (of `workerCount`) to, or -1 for none
+    // when NUMA-local, a CPU on the worker's node; otherwise a CPU of its own, leaving CPU #0 to the thread calling `run()` (which is not pinned)
+    if (isNumaLocal)
+        return LifeNumaTopology::system().cpuForWorker(workerIndex, workerCount);
+    int cpuCount = QThread::idealThreadCount();
+    return workerIndex > 0 && cpuCount > 1 ? workerIndex % cpuCount : -1;
+}
+
+void LifeWorkerPool::startThreads(int threadCount)
+{
+    // start the worker threads, for `threadCount` threads including the one calling `run()`
+    barrier.setCount(threadCount);
+    // workers only pick up jobs posted after they are created
+    quint64 startJobSequence = jobSequence;
+    for (int workerIndex = 1; workerIndex < threadCount; workerIndex++)
+    {
+        int cpu = cpuForWorker(workerIndex, threadCount);
+        QThread *thread = QThread::create([=]()->void { this->workerLoop(workerIndex, cpu, startJobSequence); });
+        thread->start();
+        threads.append(thread);
+    }
+}
+
+void LifeWorkerPool::stopThreads()
+{
+    // stop and delete all the worker threads
+    {
+        QMutexLocker locker(&mutex);
+        quitting = true;
+        jobPosted.wakeAll();
+    }
+    for (QThread *thread : threads)
+    {
+        thread->wait();
+        delete thread;
+    }
+    threads.clear();
+    quitting = false;
+    barrier.setCount(1);
+}
+
+void LifeWorkerPool::run(int generations, const WorkFunction &work, const CompletionFunction &betweenGenerations)
+{
+    // run `generations` generations, calling `work(workerIndex, workerCount)` in every thread for each one,
+    // with all threads meeting at the barrier after each generation, where `betweenGenerations()` is called once
+    // returns only when all generations are complete, without going back to the event loop in between
+    if (generations <= 0)
+        return;
+    {
+        QMutexLocker locker(&mutex);
+        jobGenerations = generations;
+        jobWork = &work;
+        jobBetweenGenerations = &betweenGenerations;
+        jobSequence++;
+        jobPosted.wakeAll();
+    }
+    // the calling thread takes part as worker #0 (pinned meanwhile, if NUMA-local)
+#ifdef Q_OS_LINUX
+    cpu_set_t savedSet;
+    int cpu = cpuForWorker(0, threadCount());
+    bool pinned = cpu >= 0 && pthread_getaffinity_np(pthread_self(), sizeof(savedSet), &savedSet) == 0;
+    if (pinned)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+    if (metrics != nullptr)
+        metrics->setThreadCpu(0, sched_getcpu());
+#endif
+    runGenerations(0, generations, work, betweenGenerations);
+#ifdef Q_OS_LINUX
+    if (pinned)
+        pthread_setaffinity_np(pthread_self(), sizeof(savedSet), &savedSet);
+#endif
+}
+
+void LifeWorkerPool::workerLoop(int workerIndex, int cpu, quint64 lastJobSequence)
+{
+    // the body of each worker thread: wait for a job, run its generations, repeat until quitting
+#ifdef Q_OS_LINUX
+    // pin the worker to CPU `cpu` (if any)
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    if (metrics != nullptr)
+        metrics->setThreadCpu(workerIndex, sched_getcpu());
+#else
+    Q_UNUSED(cpu);
+#endif
+    forever
+    {
+        int generations;
+        const WorkFunction *work;
+        const CompletionFunction *betweenGenerations;
+        {
+            QMutexLocker locker(&mutex);
+            while (!quitting && jobSequence == lastJobSequence)
+                jobPosted.wait(&mutex);
+            if (quitting)
+                return;
+            lastJobSequence = jobSequence;
+            generations = jobGenerations;
+            work = jobWork;
+            betweenGenerations = jobBetweenGenerations;
+        }
+        runGenerations(workerIndex, generations, *work, *betweenGenerations);
+    }
+}
+
+void LifeWorkerPool::runGenerations(int workerIndex, int generations, const WorkFunction &work, const CompletionFunction &betweenGenerations)
+{
+    // run this thread's share of `generations` generations, timing its busy (working) and idle (at the barrier) time
+    int workerCount = threadCount();
+    QElapsedTimer et;
+    for (int generation = 0; generation < generations; generation++)
+    {
+        et.start();
+        work(workerIndex, workerCount);
+        qint64 busyNsecs = et.nsecsElapsed();
+        barrier.wait(betweenGenerations);
+        if (metrics != nullptr)
+            metrics->recordThread(workerIndex, busyNsecs, et.nsecsElapsed() - busyNsecs);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef LIFEWORKERPOOL_H
+#define LIFEWORKERPOOL_H
+
+#include <functional>
+
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "lifemetrics.h"
+
+// a reusable barrier, at which `count` threads wait for each other
+class LifeBarrier
+{
+public:
+    LifeBarrier(int count = 1);
+
+    void setCount(int count);
+    void wait(const std::function<void()> &completion = nullptr);
+
+private:
+    QMutex mutex;
+    QWaitCondition condition;
+    int count, waiting;
+    quint64 phase;
+};
+
+// a pool of long-lived worker threads, which stay alive across generations
+// the thread calling `run()` takes part as worker #0, the others are (on Linux) pinned to a CPU each
+// when NUMA-local, each worker is pinned to a CPU on its own node (see `LifeNumaTopology::cpuForWorker()`), worker #0 too for the duration of `run()`
+// each worker's busy time, and time waiting at the barrier for the others, is counted in the metrics given to `setMetrics()` (if any)
+class LifeWorkerPool
+{
+public:
+    typedef std::function<void(int workerIndex, int workerCount)> WorkFunction;
+    typedef std::function<void()> CompletionFunction;
+
+    LifeWorkerPool();
+    ~LifeWorkerPool();
+    LifeWorkerPool(const LifeWorkerPool &) = delete;
+    LifeWorkerPool &operator=(const LifeWorkerPool &) = delete;
+
+    int threadCount() const;
+    void setThreadCount(int threadCount);
+    bool numaLocal() const { return isNumaLocal; }
+    void setNumaLocal(bool numaLocal);
+    void setMetrics(LifeMetrics *metrics) { this->metrics = metrics; }
+    void run(int generations, const WorkFunction &work, const CompletionFunction &betweenGenerations);
+
+private:
+    QVector<QThread *> threads;
+    LifeMetrics *metrics;
+    bool isNumaLocal;
+    LifeBarrier barrier;
+    // the current job, protected by `mutex`
+    QMutex mutex;
+    QWaitCondition jobPosted;
+    quint64 jobSequence;
+    bool quitting;
+    int jobGenerations;
+    const WorkFunction *jobWork;
+    const CompletionFunction *jobBetweenGenerations;
+
+    void startThreads(int threadCount);
+    void stopThreads();
+    int cpuForWorker(int workerIndex, int workerCount) const;
+    void workerLoop(int workerIndex, int cpu, quint64 lastJobSequence);
+    void runGenerations(int workerIndex, int generations, const WorkFunction &work, const CompletionFunction &betweenGenerations);
+};
+
+#endif // LIFEWORKERPOOL_H
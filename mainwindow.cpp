@@ -1,14 +1,25 @@
+#include <limits>
+
+#include <QColor>
 #include <QDebug>
-#include <QFuture>
+#include <QFileDialog>
+#include <QFutureWatcher>
 #include <QGraphicsSceneMouseEvent>
+#include <QInputDialog>
 #include <QLabel>
+#include <QMessageBox>
+#include <QMutexLocker>
+#include <QPainter>
 #include <QRandomGenerator>
-#include <QtConcurrent>
 #include <QThread>
+#include <QtMath>
 #include <QWheelEvent>
 #include <QWidgetAction>
 #include <QActionGroup>
 
+#include "lifecheckpoint.h"
+#include "lifenuma.h"
+#include "lifepatternfile.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
@@ -18,14 +29,10 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , simulation(engine)
 {
     ui->setupUi(this);
 
-#if !COUNTER_COLOURS
-    ui->actionShowColours->setChecked(false);
-    ui->actionShowColours->setEnabled(false);
-#endif
-
     // create the "speed" slider as a submenu of the "Speed" menu item
     this->speedSlider = new QSlider(Qt::Horizontal, ui->menuSpeed);
     speedSlider->setFixedWidth(200);
@@ -41,39 +48,160 @@ MainWindow::MainWindow(QWidget *parent)
     ui->menuThreadSettings->setEnabled(ui->actionUseThreads->isChecked());
     connect(ui->actionUseThreads, &QAction::toggled, ui->menuThreadSettings, &QMenu::setEnabled);
 
-    // replace the design-time "Thread Count" menu action
-    // by a widget with a layout holding the label and a spinbox
-    this->threadCountSpinBox = new QSpinBox(ui->menuThreadSettings);
+    // replace the design-time "Thread Count" menu action by a spinbox
+    this->threadCountSpinBox = replaceMenuActionBySpinBox(ui->menuThreadSettings, ui->actionThreadCount,
+                                                          QString("Thread Count (%1)").arg(QThread::idealThreadCount()));
     threadCountSpinBox->setRange(1, 255);
     threadCountSpinBox->setValue(QThread::idealThreadCount());
-    QWidget *w = new QWidget(this);
-    QHBoxLayout *hl = new QHBoxLayout;
-    hl->setContentsMargins(24, 0, 0, 0);
-    hl->addWidget(new QLabel(QString("Thread Count (%1)").arg(QThread::idealThreadCount())), 0, Qt::AlignLeft);
-    hl->addWidget(threadCountSpinBox, 0, Qt::AlignRight);
-    w->setLayout(hl);
-    QWidgetAction *threadCountAction = new QWidgetAction(this);
-    threadCountAction->setDefaultWidget(w);
-    ui->menuThreadSettings->insertAction(ui->actionThreadCount, threadCountAction);
-    ui->menuThreadSettings->removeAction(ui->actionThreadCount);
-    ui->actionThreadCount = threadCountAction;
 
-    // create an exclusively-checkable group for using QtConcurrent vs QThreads
+    // create an exclusively-checkable group for using QtConcurrent vs QThreads vs worker pool (NUMA-local or not)
     QActionGroup *groupWhatThreads = new QActionGroup(ui->menuThreadSettings);
     groupWhatThreads->addAction(ui->actionUseQtConcurrent);
     groupWhatThreads->addAction(ui->actionUseQThreads);
+    groupWhatThreads->addAction(ui->actionUseWorkerPool);
+    groupWhatThreads->addAction(ui->actionUseNumaWorkerPool);
     groupWhatThreads->setExclusive(true);
 
+    // show the machine's NUMA topology (for information only) below the "Use NUMA-Local Worker Pool" menu item
+    QAction *actionNumaTopology = new QAction(LifeNumaTopology::system().description(), ui->menuThreadSettings);
+    actionNumaTopology->setEnabled(false);
+    const QList<QAction *> threadSettingsActions(ui->menuThreadSettings->actions());
+    int numaActionIndex = threadSettingsActions.indexOf(ui->actionUseNumaWorkerPool);
+    ui->menuThreadSettings->insertAction(threadSettingsActions.value(numaActionIndex + 1), actionNumaTopology);
+
+    // create an exclusively-checkable group for how the board is partitioned between threads
+    QActionGroup *groupPartition = new QActionGroup(ui->menuThreadSettings);
+    groupPartition->addAction(ui->actionPartitionInterleaved);
+    groupPartition->addAction(ui->actionPartitionBanded);
+    groupPartition->addAction(ui->actionPartitionTiled);
+    groupPartition->setExclusive(true);
+    // (the NUMA-local worker pool always partitions into bands)
+    groupPartition->setEnabled(!ui->actionUseNumaWorkerPool->isChecked());
+    connect(ui->actionUseNumaWorkerPool, &QAction::toggled, this, [groupPartition](bool checked) { groupPartition->setEnabled(!checked); });
+
+    // keep the engine's thread settings in step with the "Use Threads" & "Thread Settings" menu items
+    // (settings may be changed while running in the simulation thread, so they lock the engine while they change it)
+    updateEngineThreadMode();
+    engine.setThreadCount(useThreadCount());
+    for (QAction *action : { ui->actionUseThreads, ui->actionUseQtConcurrent, ui->actionUseQThreads, ui->actionUseWorkerPool, ui->actionUseNumaWorkerPool })
+        connect(action, &QAction::toggled, this, &MainWindow::updateEngineThreadMode);
+    connect(threadCountSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setThreadCount(value);
+    });
+    engine.setPartitionMode(partitionMode());
+    connect(groupPartition, &QActionGroup::triggered, this, [this]() { setPartitionMode(partitionMode()); });
+
+    // make "Use HashLife" menu item enable/disable "HashLife Settings" menu item
+    // and replace the design-time "Step 2^k Generations" & "Memory Limit (MB)" menu actions by spinboxes
+    ui->menuHashLifeSettings->setEnabled(ui->actionUseHashLife->isChecked());
+    connect(ui->actionUseHashLife, &QAction::toggled, ui->menuHashLifeSettings, &QMenu::setEnabled);
+    this->hashLifeStepSpinBox = replaceMenuActionBySpinBox(ui->menuHashLifeSettings, ui->actionHashLifeStep, "Step 2^k Generations, k =");
+    hashLifeStepSpinBox->setRange(0, 48);
+    hashLifeStepSpinBox->setValue(engine.hashLifeLog2Step());
+    connect(hashLifeStepSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setHashLifeLog2Step(value);
+    });
+    this->hashLifeMemoryLimitSpinBox = replaceMenuActionBySpinBox(ui->menuHashLifeSettings, ui->actionHashLifeMemoryLimit, "Memory Limit (MB)");
+    hashLifeMemoryLimitSpinBox->setRange(16, 1024 * 1024);
+    hashLifeMemoryLimitSpinBox->setValue(int(engine.hashLifeMemoryLimit() / (1024 * 1024)));
+    connect(hashLifeMemoryLimitSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            [this](int value) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setHashLifeMemoryLimit(size_t(value) * 1024 * 1024);
+    });
+
+    // switching backend copies the cells across, see `LifeEngine::setBackend()`
+    // HashLife and the unbounded universe are exclusive, and wrapping edges only apply to the board
+    connect(ui->actionUseHashLife, &QAction::toggled, this, [this]() {
+        actionPause();
+        updateEngineBackend();
+        showWholeBoard();
+    });
+    connect(ui->actionUnboundedUniverse, &QAction::toggled, this, [this](bool checked) {
+        actionPause();
+        if (checked)
+            ui->actionUseHashLife->setChecked(false);
+        updateEngineBackend();
+        ui->actionUseHashLife->setEnabled(!checked);
+        ui->actionWrapEdges->setEnabled(!checked);
+        graphicsScene->setSceneRect(boardSceneRect());
+        updateSceneRect();
+        showWholeBoard();
+    });
+
+    // create the "Rule" submenu's exclusively-checkable named rules, above the design-time "Custom Rule..." menu item
+    QActionGroup *groupRule = new QActionGroup(ui->menuRule);
+    for (const LifeRule::NamedRule &namedRule : LifeRule::namedRules())
+    {
+        QAction *action = new QAction(QString("%1 (%2)").arg(namedRule.name, namedRule.rule), groupRule);
+        action->setCheckable(true);
+        action->setData(namedRule.rule);
+        action->setChecked(namedRule.rule == engine.rule().toString());
+        ui->menuRule->insertAction(ui->actionCustomRule, action);
+    }
+    ui->menuRule->insertSeparator(ui->actionCustomRule);
+    groupRule->addAction(ui->actionCustomRule);
+    groupRule->setExclusive(true);
+    connect(groupRule, &QActionGroup::triggered, this, [this](QAction *action) {
+        LifeRule rule;
+        if (action == ui->actionCustomRule)
+            actionCustomRule();
+        else if (LifeRule::parse(action->data().toString(), rule))
+            setRule(rule);
+    });
+
     this->titlePrefix = this->windowTitle();
-    this->generationNumber = 0;
 
     this->isRunning = this->screenBoardNeedsRefresh = false;
+
+    // keep the engine's wrapping edges in step with the "Wrap Around Edges" menu item
+    engine.setEdgesWrap(ui->actionWrapEdges->isChecked());
+    connect(ui->actionWrapEdges, &QAction::toggled, this, [this](bool checked) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setEdgesWrap(checked);
+    });
+
+    // keep the engine's active regions in step with the "Active Regions Only" menu item
+    engine.setActiveRegionsOnly(ui->actionTrackActiveRegions->isChecked());
+    connect(ui->actionTrackActiveRegions, &QAction::toggled, this, [this](bool checked) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setActiveRegionsOnly(checked);
+    });
+    // keep the engine's temporal blocking in step with the "Temporal Blocking" menu item
+    // (it only applies to batches of generations run without display, and not while the counters' ages are tracked)
+    engine.setTemporalBlockGenerations(ui->actionTemporalBlocking->isChecked() ? LifeEngine::defaultTemporalBlockGenerations : 1);
+    connect(ui->actionTemporalBlocking, &QAction::toggled, this, [this](bool checked) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setTemporalBlockGenerations(checked ? LifeEngine::defaultTemporalBlockGenerations : 1);
+    });
+    // only track the counters' ages (which is extra work each generation) while showing colours
+    engine.setTrackAges(showColours());
+    connect(ui->actionShowColours, &QAction::toggled, this, [this](bool checked) {
+        {
+            QMutexLocker locker(&simulation.engineMutex());
+            engine.setTrackAges(checked);
+        }
+        showWholeBoard();
+    });
+    // only track which tiles change each generation (to show just those) while displaying as we run
+    engine.setTrackChangedTiles(runDisplay());
+    connect(ui->actionDisplay, &QAction::toggled, this, [this](bool checked) {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setTrackChangedTiles(checked);
+    });
     ui->actionRun->setVisible(true);
     ui->actionPause->setVisible(false);
 
     // set the run generations timer to once per 0.5 second
     this->timer.setInterval(500);
     connect(&timer, &QTimer::timeout, this, &MainWindow::timerTimeout);
+    // set the frame timer to the simulation thread's snapshot rate
+    this->frameTimer.setInterval(LifeSimulation::defaultFrameIntervalMsecs);
+    connect(&frameTimer, &QTimer::timeout, this, &MainWindow::frameTimerTimeout);
+    // switching between running in the simulation thread and in the GUI thread pauses
+    connect(ui->actionRunInSimulationThread, &QAction::toggled, this, &MainWindow::actionPause);
     // connect slider value changed to change generation speed
     speedSlider->setValue(speedSlider->maximum() - timer.interval());
     connect(speedSlider, &QSlider::valueChanged, this, &MainWindow::speedSliderChange);
@@ -81,11 +209,17 @@ MainWindow::MainWindow(QWidget *parent)
     // connect menu actions
     connect(ui->actionNew, &QAction::triggered, this, &MainWindow::newBoard);
     connect(ui->actionRandomize, &QAction::triggered, this, &MainWindow::actionRandomize);
+    connect(ui->actionOpenPattern, &QAction::triggered, this, &MainWindow::actionOpenPattern);
+    connect(ui->actionSavePattern, &QAction::triggered, this, &MainWindow::actionSavePattern);
+    connect(ui->actionSaveCheckpoint, &QAction::triggered, this, &MainWindow::actionSaveCheckpoint);
+    connect(ui->actionRestoreCheckpoint, &QAction::triggered, this, &MainWindow::actionRestoreCheckpoint);
+    connect(ui->actionRecordHistory, &QAction::triggered, this, &MainWindow::actionRecordHistory);
     connect(ui->actionRun, &QAction::triggered, this, &MainWindow::actionRun);
     connect(ui->actionPause, &QAction::triggered, this, &MainWindow::actionPause);
     connect(ui->actionStep, &QAction::triggered, this, &MainWindow::actionStep);
     connect(ui->actionExit, &QAction::triggered, this, &MainWindow::actionExit);
     connect(ui->actionFastest, &QAction::triggered, this, &MainWindow::actionFastest);
+    connect(ui->actionBenchmarkPartitioning, &QAction::triggered, this, &MainWindow::actionBenchmarkPartitioning);
 
     // create graphics scene & view
     this->graphicsScene = new LifeGraphicsScene(this);
@@ -98,10 +232,17 @@ MainWindow::MainWindow(QWidget *parent)
     // connect context menu click to create context menu
     connect(graphicsScene, &LifeGraphicsScene::contextMenuClicked, this, &MainWindow::sceneContextMenuClick);
 
+    // create the (initially hidden) performance metrics dock, shown & hidden from the end of the "Run Settings" submenu
+    this->metricsDock = new LifeMetricsDock(engine, simulation.engineMutex(), this);
+    addDockWidget(Qt::RightDockWidgetArea, metricsDock);
+    metricsDock->hide();
+    // (the engine gathers each generation's statistics as it generates it only while the dock is shown, or it is to pause when stabilised)
+    connect(metricsDock, &QDockWidget::visibilityChanged, this, &MainWindow::updateEngineTrackStatistics);
+    connect(ui->actionPauseWhenStabilised, &QAction::toggled, this, &MainWindow::updateEngineTrackStatistics);
+    ui->menuRunSettings->addSeparator();
+    ui->menuRunSettings->addAction(metricsDock->toggleViewAction());
+
     // create an empty board
-#if BOARD_C_ARRAYS
-    board0 = board1 = nullptr;
-#endif
     newBoard();
 
     //VERYTEMPORARY
@@ -114,34 +255,11 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     delete ui;
-
-#if BOARD_C_ARRAYS
-    if (board0 != nullptr)
-    {
-        for (int i = 0; i < BOARD_COUNT(board0); i++)
-            if (board0[i] != nullptr)
-                delete[] board0[i];
-        delete[] board0;
-    }
-    board0 = nullptr;
-    if (board1 != nullptr)
-    {
-        for (int i = 0; i < BOARD_COUNT(board1); i++)
-            if (board1[i] != nullptr)
-                delete[] board1[i];
-        delete[] board1;
-    }
-    board1 = nullptr;
-#endif
 }
 
 bool MainWindow::showColours() const
 {
-#if COUNTER_COLOURS
     return ui->actionShowColours->isChecked();
-#else
-    return false;
-#endif
 }
 
 bool MainWindow::useThreads() const
@@ -159,6 +277,111 @@ bool MainWindow::useQtConcurrent() const
     return ui->actionUseQtConcurrent->isChecked();
 }
 
+bool MainWindow::useWorkerPool() const
+{
+    return ui->actionUseWorkerPool->isChecked();
+}
+
+bool MainWindow::useNumaWorkerPool() const
+{
+    return ui->actionUseNumaWorkerPool->isChecked();
+}
+
+bool MainWindow::useHashLife() const
+{
+    return ui->actionUseHashLife->isChecked();
+}
+
+bool MainWindow::useUnboundedUniverse() const
+{
+    return ui->actionUnboundedUniverse->isChecked();
+}
+
+bool MainWindow::useSimulationThread() const
+{
+    return ui->actionRunInSimulationThread->isChecked();
+}
+
+const LifeSnapshot *MainWindow::runningSnapshot() const
+{
+    // return the latest snapshot acquired from the simulation thread, if running in it
+    return simulation.isRunning() ? &simulation.snapshot() : nullptr;
+}
+
+LifeEngine::PartitionMode MainWindow::partitionMode() const
+{
+    if (ui->actionPartitionBanded->isChecked())
+        return LifeEngine::PartitionBanded;
+    if (ui->actionPartitionTiled->isChecked())
+        return LifeEngine::PartitionTiled;
+    return LifeEngine::PartitionInterleaved;
+}
+
+void MainWindow::setPartitionMode(LifeEngine::PartitionMode mode)
+{
+    switch (mode)
+    {
+    case LifeEngine::PartitionInterleaved: ui->actionPartitionInterleaved->setChecked(true); break;
+    case LifeEngine::PartitionBanded: ui->actionPartitionBanded->setChecked(true); break;
+    case LifeEngine::PartitionTiled: ui->actionPartitionTiled->setChecked(true); break;
+    }
+    QMutexLocker locker(&simulation.engineMutex());
+    engine.setPartitionMode(mode);
+}
+
+void MainWindow::updateEngineThreadMode()
+{
+    // set the engine's thread mode from the "Use Threads" & "Thread Settings" menu items
+    QMutexLocker locker(&simulation.engineMutex());
+    engine.setThreadMode(!useThreads() ? LifeEngine::ThreadsNone
+                         : useQtConcurrent() ? LifeEngine::ThreadsQtConcurrent
+                         : useWorkerPool() ? LifeEngine::ThreadsWorkerPool
+                         : useNumaWorkerPool() ? LifeEngine::ThreadsNumaWorkerPool
+                         : LifeEngine::ThreadsQThreads);
+}
+
+void MainWindow::updateEngineBackend()
+{
+    // set the engine's backend from the "Use HashLife" & "Unbounded Universe" menu items
+    engine.setBackend(useUnboundedUniverse() ? LifeEngine::BackendUnbounded
+                      : useHashLife() ? LifeEngine::BackendHashLife
+                      : LifeEngine::BackendBoard);
+}
+
+void MainWindow::updateEngineTrackStatistics()
+{
+    // set whether the engine gathers each generation's statistics as it generates it (see `LifeEngine::generationStatistics()`):
+    // for the metrics dock, and to detect when the board has stabilised
+    QMutexLocker locker(&simulation.engineMutex());
+    engine.setTrackStatistics(metricsDock->toggleViewAction()->isChecked() || ui->actionPauseWhenStabilised->isChecked());
+}
+
+bool MainWindow::boardStabilised()
+{
+    // return whether the board has been detected to have stabilised (into still lifes & oscillators), when set to pause when it has
+    if (!ui->actionPauseWhenStabilised->isChecked())
+        return false;
+    QMutexLocker locker(&simulation.engineMutex());
+    qint64 stabilisedGeneration;
+    int period;
+    return engine.stabilisation(stabilisedGeneration, period);
+}
+
+void MainWindow::setRule(const LifeRule &rule)
+{
+    // set the engine's rule, and check its menu item in the "Rule" submenu ("Custom Rule..." if it is not a named rule)
+    {
+        QMutexLocker locker(&simulation.engineMutex());
+        engine.setRule(rule);
+    }
+    QAction *ruleAction = ui->actionCustomRule;
+    for (QAction *action : ui->menuRule->actions())
+        if (action != ui->actionCustomRule && !action->isSeparator() && action->data().toString() == rule.toString())
+            ruleAction = action;
+    ruleAction->setChecked(true);
+    showTitle();
+}
+
 bool MainWindow::runDisplay() const
 {
     return ui->actionDisplay->isChecked();
@@ -167,27 +390,27 @@ bool MainWindow::runDisplay() const
 QPoint MainWindow::scenePosToBoardPos(const QPointF &scenePos) const
 {
     // convert a scene position to a board position
-    return QPoint((scenePos.x() / LifeGraphicsScene::cellSize) + (boardSize / 2), (scenePos.y() / LifeGraphicsScene::cellSize) + (boardSize / 2));
+    // (rounding down, as positions left of/above the board are valid in the unbounded backends)
+    int boardSize = engine.boardSize();
+    return QPoint(qFloor(scenePos.x() / LifeGraphicsScene::cellSize) + (boardSize / 2), qFloor(scenePos.y() / LifeGraphicsScene::cellSize) + (boardSize / 2));
 }
 
 QPointF MainWindow::boardPosToScenePos(const QPoint &boardPos) const
 {
     // convert a board position to a scene position
+    int boardSize = engine.boardSize();
     return QPointF((boardPos.x() - (boardSize / 2)) * LifeGraphicsScene::cellSize, (boardPos.y() - (boardSize / 2)) * LifeGraphicsScene::cellSize);
 }
 
 bool MainWindow::boardPosIsValid(const QPoint &boardPos) const
 {
     // return whether a board position is within the bounds of the board
-    Board &board(*curBoard);
-    return (boardPos.y() >= 0 && boardPos.y() < BOARD_COUNT(board)
-            && boardPos.x() >= 0 && boardPos.x() < BOARDROW_COUNT(BOARDROW_AT(board, boardPos.y())));
+    return engine.positionIsValid(boardPos.y(), boardPos.x());
 }
 
 Qt::GlobalColor MainWindow::colourForCounter(const Cell &cell) const
 {
     // return the colour to use for a counter in a cell
-#if COUNTER_COLOURS
     if (showColours())
     {
         if (cell.age < 1)
@@ -199,12 +422,25 @@ Qt::GlobalColor MainWindow::colourForCounter(const Cell &cell) const
         else if (cell.age < 8)
             return Qt::red;
     }
-#else
-    Q_UNUSED(cell);
-#endif
     return Qt::black;
 }
 
+QVector<QRgb> MainWindow::rasterColourTable() const
+{
+    // return the colour table for the images rendered by `LifeEngine::rasterize()`
+    // pixel value 0 is an empty cell (transparent), and 1 + age is an occupied cell of that age
+    QVector<QRgb> colourTable(256);
+    colourTable[0] = qRgba(0, 0, 0, 0);
+    for (int value = 1; value < colourTable.count(); value++)
+    {
+        Cell cell;
+        cell.occupied = true;
+        cell.age = quint8(value - 1);
+        colourTable[value] = QColor(colourForCounter(cell)).rgb();
+    }
+    return colourTable;
+}
+
 void MainWindow::showCounterForBoardPos(const QPoint &boardPos)
 {
     // show the counter (if any) at a board position
@@ -215,178 +451,140 @@ void MainWindow::showCounterForBoardPos(const QPoint &boardPos)
     graphicsScene->invalidate(sceneRect);
 }
 
-int MainWindow::countNeighbours(int y, int x) const
+void MainWindow::showWholeBoard()
 {
-    // return how many neighbours a cell has
-    const Board &board(*curBoard);
-    int neighbours = 0;
-    if (--y >= 0)
-    {
-        if (x > 0 && BOARDCELL_AT(board, y, x - 1).occupied)
-            neighbours++;
-        if (BOARDCELL_AT(board, y, x).occupied)
-            neighbours++;
-        if (x < BOARDROW_COUNT(BOARDROW_AT(board, y)) - 1 && BOARDCELL_AT(board, y, x + 1).occupied)
-            neighbours++;
-    }
-    y++;
-    if (x > 0 && BOARDCELL_AT(board, y, x - 1).occupied)
-        neighbours++;
-    if (x < BOARDROW_COUNT(BOARDROW_AT(board, y)) - 1 && BOARDCELL_AT(board, y, x + 1).occupied)
-        neighbours++;
-    if (++y <= BOARD_COUNT(board) - 1)
+    // update to show the new board's counters
+    // (which includes any changes not yet shown, so forget those)
+    if (!simulation.isRunning())
     {
-        if (x > 0 && BOARDCELL_AT(board, y, x - 1).occupied)
-            neighbours++;
-        if (BOARDCELL_AT(board, y, x).occupied)
-            neighbours++;
-        if (x < BOARDROW_COUNT(BOARDROW_AT(board, y)) - 1 && BOARDCELL_AT(board, y, x + 1).occupied)
-            neighbours++;
+        QVector<QRect> regions;
+        engine.takeChangedRegions(regions);
     }
-    return neighbours;
+    graphicsScene->invalidate();
+    screenBoardNeedsRefresh = false;
 }
 
-void MainWindow::stepPass1(bool multiThread /*= false*/, int startRow /*= 0*/, int incRow /*=1*/)
+void MainWindow::showChangedRegions()
 {
-    // populate `nextBoard` from `curBoard` by generating a step
-
-    /* RULES:
-     * 1. Survival:
-     *      counter with 2/3 neighbours => survives
-     * 2. Death:
-     *      counter with 4+ neighbours => dies (overcrowding)
-     *      counter with 0/1 neighbours => dies (isolation)
-     * 3. Birth:
-     *      no counter with 3 neighbours => birth
-     */
-
-//    static bool _debug = true;
-
-//    QElapsedTimer et;
-//    et.start();
-
-    const Board &board(*curBoard);
-    Board &newBoard(*nextBoard);
-    int yStart = 0;
-    int yStep = 1;
-    if (multiThread)
+    // update to show only those regions of the board which have changed since last shown
+    // (or the whole board if that is not known, or when showing colours, as unchanged counters still age)
+    QVector<QRect> regions;
+    if (!engine.takeChangedRegions(regions) || showColours())
+    {
+        showWholeBoard();
+        return;
+    }
+    for (const QRect &region : regions)
     {
-        Q_ASSERT(incRow > 0);
-        Q_ASSERT(startRow >= 0 && startRow < incRow);
-        yStart = startRow;
-        yStep = incRow;
+        QRectF sceneRect(boardPosToScenePos(region.topLeft()),
+                         QSizeF(region.width() * LifeGraphicsScene::cellSize, region.height() * LifeGraphicsScene::cellSize));
+        graphicsScene->invalidate(sceneRect, QGraphicsScene::ForegroundLayer);
     }
-    for (int y = yStart; y < BOARD_COUNT(board); y += yStep)
-        for (int x = 0; x < BOARDROW_COUNT(BOARDROW_AT(board, y)); x++)
-        {
-            int neighbours = countNeighbours(y, x);
-            const Cell &cell(BOARDCELL_AT(board, y, x));
-            Cell &newCell(BOARDCELL_SQUARE(newBoard, y, x));
-            if (cell.occupied)
-            {
-                newCell.occupied = (neighbours == 2 || neighbours == 3);
-#if COUNTER_COLOURS
-                newCell.age = newCell.occupied ? cell.age + 1 : 0;
-#endif
-            }
-            else
-            {
-                newCell.occupied = (neighbours == 3);
-#if COUNTER_COLOURS
-                newCell.age = 0;
-#endif
-            }
-        }
-//    if (_debug)
-//    {
-//        QString cpuInfo;
-//#ifdef Q_OS_LINUX
-////        int cpu = sched_getcpu();
-////        cpuInfo = QString("(CPU #%1)").arg(cpu);
-//#endif
-//        qDebug() << "stepPass1()" << ((et.nsecsElapsed() + 500) / 1000) << cpuInfo;
-//    }
-}
-
-void MainWindow::showWholeBoard()
-{
-    // update to show the new board's counters
-    graphicsScene->invalidate();
     screenBoardNeedsRefresh = false;
 }
 
 void MainWindow::showTitle()
 {
-    setWindowTitle(QString("%1 [%2]").arg(titlePrefix).arg(generationNumber));
+    // (while running in the simulation thread, the engine is moving on, so show the generation being displayed)
+    // (the rule is shown when it is not Conway's Life)
+    qint64 generation = simulation.isRunning() ? simulation.snapshot().generation : engine.generationNumber();
+    QString rule = engine.rule().isConway() ? QString() : QString(" (%1)").arg(engine.rule().toString());
+    setWindowTitle(QString("%1%2 [%3]").arg(titlePrefix).arg(rule).arg(generation));
 }
 
-void MainWindow::stepPass2()
+void MainWindow::showGeneration()
 {
-    // swap `curBoard` and `nextBoard`
-    if (this->curBoard == &this->board0)
-    {
-        this->curBoard = &this->board1;
-        this->nextBoard = &this->board0;
-    }
-    else
-    {
-        this->curBoard = &this->board0;
-        this->nextBoard = &this->board1;
-    }
-    this->generationNumber++;
+    // show the newly generated board
     // whole board will need refreshing next time it is shown
     screenBoardNeedsRefresh = true;
+    updateSceneRect();
     // if not displaying as we run then stop here
     if (isRunning && !runDisplay())
     {
         // only reshow title every 500ms or 10 generations
-        if (timer.interval() >= 500 || generationNumber % 10 == 0)
+        if (timer.interval() >= 500 || engine.generationNumber() % 10 == 0)
             showTitle();
         return;
     }
-    // update to show the new board's counters
-    showWholeBoard();
+    // update to show the new board's changed counters
+    showChangedRegions();
     showTitle();
 }
 
-void MainWindow::createOrClearBoard(Board &board)
+void MainWindow::updateSimulationRegion()
 {
-    // create a new board
-    Cell cell;
-#if BOARD_C_ARRAYS
-    if (board == nullptr)
-    {
-        board = new BoardRow[boardSize];
-        for (int i = 0; i < BOARD_COUNT(board); i++)
-            board[i] = new Cell[boardSize];
-    }
-    for (int i = 0; i < BOARD_COUNT(board); i++)
-        for (int j = 0; j < BOARDROW_COUNT(board[i]); j++)
-            board[i][j] = cell;
-#else
-    board.resize(boardSize);
-    for (int i = 0; i < BOARD_COUNT(board); i++)
+    // tell the simulation thread which region of the board is in view, and at what level of detail, for its snapshots
+    QRectF visibleRect(graphicsView->mapToScene(graphicsView->viewport()->rect()).boundingRect());
+    QPoint boardTopLeft(scenePosToBoardPos(visibleRect.topLeft()));
+    QPoint boardBottomRight(scenePosToBoardPos(visibleRect.bottomRight()));
+    int cellsPerPixel = LifeGraphicsScene::cellsPerPixelForScale(LifeGraphicsScene::cellSize * graphicsView->transform().m11());
+    // align to whole pixels, as `LifeGraphicsScene::drawForeground()` does
+    int top = boardTopLeft.y() - (((boardTopLeft.y() % cellsPerPixel) + cellsPerPixel) % cellsPerPixel);
+    int left = boardTopLeft.x() - (((boardTopLeft.x() % cellsPerPixel) + cellsPerPixel) % cellsPerPixel);
+    simulation.setRegion(top, left, boardBottomRight.y() - top + 1, boardBottomRight.x() - left + 1, cellsPerPixel);
+}
+
+QRectF MainWindow::boardSceneRect() const
+{
+    // return the scene rectangle covering the board, centred at (0, 0)
+    int size = engine.boardSize() * LifeGraphicsScene::cellSize;
+    return QRectF(-size / 2, -size / 2, size, size);
+}
+
+void MainWindow::updateSceneRect()
+{
+    // grow the scene rectangle to cover wherever the cells of the unbounded universe have spread to, plus a margin
+    // it is never shrunk (other than by a new board), so that the view does not jump about as cells die away
+    qint64 top, left, bottom, right;
+    if (const LifeSnapshot *snapshot = runningSnapshot())
     {
-        board[i].resize(boardSize);
-        board[i].fill(cell);
+        if (!snapshot->hasBounds)
+            return;
+        top = snapshot->boundsTop;
+        left = snapshot->boundsLeft;
+        bottom = snapshot->boundsBottom;
+        right = snapshot->boundsRight;
     }
-#endif
+    else if (!engine.boundingRect(top, left, bottom, right))
+        return;
+    // keep within the board positions whose scene positions `boardPosToScenePos()` can calculate (in `int`s)
+    constexpr qint64 limit = std::numeric_limits<int>::max() / LifeGraphicsScene::cellSize / 2;
+    constexpr int margin = SparseUniverse::chunkSize;
+    QPointF topLeft(boardPosToScenePos(QPoint(int(qBound(-limit, left - margin, limit)), int(qBound(-limit, top - margin, limit)))));
+    QPointF bottomRight(boardPosToScenePos(QPoint(int(qBound(-limit, right + margin, limit)), int(qBound(-limit, bottom + margin, limit)))));
+    QRectF rect(graphicsScene->sceneRect().united(QRectF(topLeft, bottomRight)));
+    if (rect != graphicsScene->sceneRect())
+        graphicsScene->setSceneRect(rect);
+}
+
+QSpinBox *MainWindow::replaceMenuActionBySpinBox(QMenu *menu, QAction *&action, const QString &label)
+{
+    // replace a design-time menu action
+    // by a widget with a layout holding the label and a spinbox, and return the spinbox
+    QSpinBox *spinBox = new QSpinBox(menu);
+    QWidget *w = new QWidget(this);
+    QHBoxLayout *hl = new QHBoxLayout;
+    hl->setContentsMargins(24, 0, 0, 0);
+    hl->addWidget(new QLabel(label), 0, Qt::AlignLeft);
+    hl->addWidget(spinBox, 0, Qt::AlignRight);
+    w->setLayout(hl);
+    QWidgetAction *widgetAction = new QWidgetAction(this);
+    widgetAction->setDefaultWidget(w);
+    menu->insertAction(action, widgetAction);
+    menu->removeAction(action);
+    action = widgetAction;
+    return spinBox;
 }
 
 /*slot*/ void MainWindow::newBoard()
 {
     actionPause();
-    // create or clear board0 & board1
-    createOrClearBoard(board0);
-    createOrClearBoard(board1);
-    this->curBoard = &this->board0;
-    this->nextBoard = &this->board1;
+    // create or clear the board
+    engine.newBoard();
 
-    int size = boardSize * LifeGraphicsScene::cellSize;
-    // make scene rectangle of size `size` centred at (0, 0)
-    graphicsScene->setSceneRect(-size / 2, -size / 2, size, size);
+    // make scene rectangle cover the board
+    graphicsScene->setSceneRect(boardSceneRect());
 
-    this->generationNumber = 0;
     showWholeBoard();
     showTitle();
 }
@@ -402,21 +600,122 @@ void MainWindow::createOrClearBoard(Board &board)
 {
     newBoard();
     // randomly fill board with counters
-    Board &board(*curBoard);
-    for (int y = 0; y < BOARD_COUNT(board); y++)
-        for (int x = 0; x < BOARDROW_COUNT(BOARDROW_AT(board, y)); x++)
+    engine.randomize(QRandomGenerator::global()->generate64());
+    showWholeBoard();
+}
+
+/*slot*/ void MainWindow::actionOpenPattern()
+{
+    // replace the board by a pattern file, centred on the board, switching to the file's rule if it has one
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Pattern", QString(), LifePatternFile::fileDialogFilter());
+    if (fileName.isEmpty())
+        return;
+    actionPause();
+    LifePatternFile::Info info;
+    QString errorMessage;
+    bool ok;
+    {
+        QMutexLocker locker(&simulation.engineMutex());
+        ok = LifePatternFile::load(fileName, engine, info, errorMessage);
+    }
+    if (!ok)
+        QMessageBox::warning(this, "Open Pattern", errorMessage);
+    else if (info.hasRule)
+        setRule(info.rule);
+    showWholeBoard();
+    showTitle();
+}
+
+/*slot*/ void MainWindow::actionSavePattern()
+{
+    // save the board to a pattern file, in the format for the file name's suffix
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Pattern", QString(), LifePatternFile::fileDialogFilter());
+    if (fileName.isEmpty())
+        return;
+    actionPause();
+    QString errorMessage;
+    bool ok;
+    {
+        QMutexLocker locker(&simulation.engineMutex());
+        ok = LifePatternFile::save(fileName, engine, errorMessage);
+    }
+    if (!ok)
+        QMessageBox::warning(this, "Save Pattern", errorMessage);
+}
+
+/*slot*/ void MainWindow::actionSaveCheckpoint()
+{
+    // save a checkpoint of the simulation, without pausing it: the board is captured between generations,
+    // and the file is written (compressed) in the background
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Checkpoint", QString(), "Checkpoints (*.lifeckpt)");
+    if (fileName.isEmpty())
+        return;
+    LifeCheckpoint checkpoint;
+    {
+        QMutexLocker locker(&simulation.engineMutex());
+        checkpoint = LifeCheckpoint::capture(engine, engine.randomSeed());
+    }
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher]() {
+        if (!watcher->result().isEmpty())
+            QMessageBox::warning(this, "Save Checkpoint", watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(LifeCheckpoint::writeAsync(checkpoint, fileName, true));
+}
+
+/*slot*/ void MainWindow::actionRestoreCheckpoint()
+{
+    // replace the simulation by a checkpoint, including its board size, generation, rule and edges
+    QString fileName = QFileDialog::getOpenFileName(this, "Restore Checkpoint", QString(), "Checkpoints (*.lifeckpt)");
+    if (fileName.isEmpty())
+        return;
+    actionPause();
+    quint64 seed;
+    QString errorMessage;
+    bool ok;
+    {
+        QMutexLocker locker(&simulation.engineMutex());
+        ok = LifeCheckpoint::restore(fileName, engine, seed, errorMessage);
+    }
+    if (!ok)
+    {
+        QMessageBox::warning(this, "Restore Checkpoint", errorMessage);
+        return;
+    }
+    setRule(engine.rule());
+    ui->actionWrapEdges->setChecked(engine.edgesWrap());
+    graphicsScene->setSceneRect(boardSceneRect());
+    showWholeBoard();
+    showTitle();
+}
+
+/*slot*/ void MainWindow::actionRecordHistory(bool checked)
+{
+    // start (asking for the file) or stop recording every generation to a history log
+    QString errorMessage;
+    bool ok = true;
+    if (checked)
+    {
+        QString fileName = QFileDialog::getSaveFileName(this, "Record History", QString(), "History Logs (*.lifehist)");
+        if (fileName.isEmpty())
         {
-            Cell &cell(BOARDCELL_SQUARE(board, y, x));
-            quint32 rand = QRandomGenerator::global()->generate();
-            if (rand & 1)
-            {
-                cell.occupied = true;
-#if COUNTER_COLOURS
-                cell.age = 0;
-#endif
-            }
+            ui->actionRecordHistory->setChecked(false);
+            return;
         }
-    showWholeBoard();
+        QMutexLocker locker(&simulation.engineMutex());
+        ok = engine.startRecordingHistory(fileName, LifeHistoryRecorder::defaultKeyframeInterval, errorMessage);
+    }
+    else
+    {
+        QMutexLocker locker(&simulation.engineMutex());
+        ok = engine.stopRecordingHistory(errorMessage);
+    }
+    if (!ok)
+    {
+        QMessageBox::warning(this, "Record History", errorMessage);
+        ui->actionRecordHistory->setChecked(engine.historyRecording());
+    }
 }
 
 /*slot*/ void MainWindow::actionRun()
@@ -426,11 +725,21 @@ void MainWindow::createOrClearBoard(Board &board)
     ui->actionPause->setVisible(true);
     ui->actionStep->setEnabled(false);
 
-    runStatistics.startGeneration = generationNumber;
+    runStatistics.startGeneration = engine.generationNumber();
     runStatistics.elapsedTimer.start();
+    engine.resetStatistics();
 
-    timer.start();
     this->isRunning = true;
+    if (useSimulationThread())
+    {
+        // run in the simulation thread, and show its snapshots on the frame timer
+        updateSimulationRegion();
+        simulation.setStepDelay(timer.interval());
+        simulation.start();
+        frameTimer.start();
+    }
+    else
+        timer.start();
 }
 
 /*slot*/ void MainWindow::actionPause()
@@ -440,20 +749,87 @@ void MainWindow::createOrClearBoard(Board &board)
     ui->actionPause->setVisible(false);
     ui->actionStep->setEnabled(true);
 
+    if (simulation.isRunning())
+    {
+        // stop the simulation thread, after which the engine is shown directly again
+        simulation.stop();
+        frameTimer.stop();
+        screenBoardNeedsRefresh = true;
+        updateSceneRect();
+    }
+
     if (isRunning)
     {
         Q_ASSERT(runStatistics.elapsedTimer.isValid());
         qint64 elapsedTime = runStatistics.elapsedTimer.elapsed();
         if (elapsedTime == 0)
             elapsedTime = 1;
-        QString threadUsage = !useThreads() ? "No threads" : useQtConcurrent() ? "QtConcurrent" : "QThreads";
+        QString threadUsage = LifeEngine::threadModeName(engine.threadMode());
         int threadCount = useThreads() ? useThreadCount() : 1;
-        int elapsedGenerations = generationNumber - runStatistics.startGeneration;
-        int generationsPerSecond = elapsedGenerations * 1000 / elapsedTime;
+        qint64 elapsedGenerations = engine.generationNumber() - runStatistics.startGeneration;
+        // (calculated in `double`, as HashLife's generation counts can overflow `qint64` when multiplied up)
+        qint64 generationsPerSecond = qint64(double(elapsedGenerations) * 1000 / elapsedTime);
         QString message(QString("elapsedTimer: [Use threads: %1, Thread count: %2] %3 generations in %4 milliseconds (%5/sec)")
                         .arg(threadUsage).arg(threadCount)
                         .arg(elapsedGenerations).arg(elapsedTime).arg(generationsPerSecond));
+        message += QString(" [Board: %1]").arg(LifeEngine::boardLayoutName());
+#if BOARD_BIT_PACKED
+        message += QString(" [Kernel: %1]").arg(BitBoard::kernelName(BitBoard::kernel()));
+#endif
+        switch (engine.backend())
+        {
+        case LifeEngine::BackendUnbounded: {
+            const SparseUniverse &universe(engine.unboundedUniverse());
+            message += QString(" [Unbounded universe: population %1, %2 chunks, %3 KB]")
+                    .arg(universe.population()).arg(universe.chunkCount()).arg(universe.memoryUsage() / 1024);
+            break;
+        }
+        case LifeEngine::BackendHashLife: {
+            const HashLife &hashLife(engine.hashLifeUniverse());
+            message += QString(" [HashLife: step 2^%1, population %2, %3 nodes, %4 MB, %5 garbage collections]")
+                    .arg(engine.hashLifeLog2Step()).arg(hashLife.population()).arg(hashLife.nodeCount())
+                    .arg(hashLife.memoryUsage() / (1024 * 1024)).arg(hashLife.garbageCollections());
+            break;
+        }
+        case LifeEngine::BackendBoard: {
+            if (useThreads() && engine.threadMode() == LifeEngine::ThreadsNumaWorkerPool)
+            {
+                // (the percentage of the boards' memory on a different node from the worker generating it)
+                double remotePages = engine.remotePageFraction(threadCount);
+                message += QString(" [Partition: %1, NUMA-local: %2]").arg(LifeEngine::partitionModeName(LifeEngine::PartitionBanded))
+                        .arg(remotePages >= 0 ? QString("%1% remote pages").arg(remotePages * 100, 0, 'f', 1) : QString("placement unknown"));
+            }
+            else if (useThreads())
+                message += QString(" [Partition: %1]").arg(LifeEngine::partitionModeName(engine.partitionMode()));
+            if (engine.temporalBlockGenerations() > 1)
+                message += QString(" [Temporal blocking: %1]").arg(engine.temporalBlockingApplies()
+                        ? QString("%1 generations per tile").arg(engine.temporalBlockGenerations())
+                        : QString("not applied, as each generation is tracked"));
+            if (engine.activeRegionsOnly() && elapsedGenerations > 0)
+                message += QString(" [Active tiles: %1 average, %2 last, of %3]")
+                        .arg(engine.activeTileTotal() / elapsedGenerations).arg(engine.lastActiveTileCount())
+                        .arg(engine.tileCount());
+            qint64 stabilisedGeneration;
+            int period;
+            if (engine.stabilisation(stabilisedGeneration, period))
+                message += QString(" [Stabilised at generation %1 with period %2]").arg(stabilisedGeneration).arg(period);
+            break;
+        }
+        }
         qDebug().noquote() << message;
+        if (engine.backend() == LifeEngine::BackendBoard && engine.threadMode() != LifeEngine::ThreadsNone)
+        {
+            // report how busy each worker was, vs idle waiting at the barrier (or for the others to finish)
+            const QVector<LifeMetrics::ThreadSample> threads(engine.metrics().sample().threads);
+            for (int i = 0; i < threads.count(); i++)
+            {
+                qint64 totalNsecs = qMax(threads[i].busyNsecs + threads[i].waitNsecs, qint64(1));
+                qDebug().noquote() << QString("  Worker #%1 (CPU #%2): busy %3 ms, idle %4 ms (%5% busy)")
+                                      .arg(i).arg(threads[i].cpu)
+                                      .arg(threads[i].busyNsecs / 1000000).arg(threads[i].waitNsecs / 1000000)
+                                      .arg(threads[i].busyNsecs * 100 / totalNsecs);
+            }
+        }
     }
 
     timer.stop();
@@ -466,87 +842,9 @@ void MainWindow::createOrClearBoard(Board &board)
 
 /*slot*/ void MainWindow::actionStep()
 {
-    // progress through a single generation
-
-    static bool _debug = false;
-    QElapsedTimer et;
-    et.start();
-
-    if (useThreads())
-    {
-        // do rows in sub-threads
-        static bool _debug2 = false;
-        QElapsedTimer et2;
-        et2.start();
-
-        int threadCount = useThreadCount();
-        int incRow = threadCount;
-        Q_ASSERT(incRow > 0);
-        QList<QFuture<void>> futures;
-        QList<QThread *> threads;
-
-        // do every `incRow` numbered rows starting from 1/2/3... in sub-threads
-        for (int startRow = 1; startRow < incRow; startRow++)
-            if (useQtConcurrent())
-            {
-                futures.append(QtConcurrent::run([=]()->void { this->stepPass1(true, startRow, incRow); }));
-            }
-            else
-            {
-                QThread *thread = QThread::create([=]()->void { this->stepPass1(true, startRow, incRow); });
-                connect(thread, &QThread::finished, thread, &QObject::deleteLater);
-                thread->start();
-                threads.append(thread);
-            }
-        if (_debug2)
-        {
-            qDebug() << "----------";
-            qDebug() << "All threads started" << ((et2.nsecsElapsed() + 500) / 1000);
-        }
-
-        // do every `incRow` numbered rows starting from 0 in main thread
-        et2.start();
-        this->stepPass1(true, 0, incRow);
-        if (_debug2)
-            qDebug() << "Main thread" << ((et2.nsecsElapsed() + 500) / 1000);
-//        if (true)
-//        {
-//            QString cpuInfo;
-//#ifdef Q_OS_LINUX
-//            int cpu = sched_getcpu();
-//            cpu_set_t set;
-//            sched_getaffinity(0, sizeof(set), &set);
-//            QString affinities;
-//            for (int i = 0; i < CPU_COUNT(&set); i++)
-//                if (CPU_ISSET(i, &set))
-//                    affinities += QString("%1/").arg(i);
-//            cpuInfo = QString("(CPU #%1, affinity %2)").arg(cpu).arg(affinities);
-//#endif
-//            qDebug() << "Main thread CPU " << cpuInfo;
-//        }
-        // wait for all sub-threads to complete their rows
-        et2.start();
-        if (useQtConcurrent())
-        {
-            for (QFuture<void> &future : futures)
-                future.waitForFinished();
-        }
-        else
-        {
-            for (QThread *thread : threads)
-                thread->wait();
-        }
-        if (_debug2)
-            qDebug() << "All threads wait" << ((et2.nsecsElapsed() + 500) / 1000);
-    }
-    else
-    {
-        stepPass1();
-    }
-    if (_debug)
-        qDebug() << "Main thread end stepPass1()" << ((et.nsecsElapsed() + 500) / 1000);
-
-    stepPass2();
+    // progress through a single generation (or 2^k generations in HashLife)
+    engine.step();
+    showGeneration();
 }
 
 /*slot*/ void MainWindow::actionExit()
@@ -562,12 +860,9 @@ void MainWindow::createOrClearBoard(Board &board)
     QPoint boardPos(scenePosToBoardPos(scenePos));
     if (!boardPosIsValid(boardPos))
         return;
-    Board &board(*curBoard);
-    Cell &cell(BOARDCELL_SQUARE(board, boardPos.y(), boardPos.x()));
-    cell.occupied = !cell.occupied;
-#if COUNTER_COLOURS
-    cell.age = 0;
-#endif
+    QMutexLocker locker(&simulation.engineMutex());
+    bool occupied = engine.cellAt(boardPos.y(), boardPos.x()).occupied;
+    engine.setCellAt(boardPos.y(), boardPos.x(), !occupied);
     showCounterForBoardPos(boardPos);
 }
 
@@ -578,57 +873,12 @@ void MainWindow::createOrClearBoard(Board &board)
     if (!boardPosIsValid(boardPos))
         return;
 
-    struct Formation {
-        QString name;
-        QList<QPoint> deltas;
-    };
-    struct CategoryFormations {
-        QString title;
-        QVector<Formation> formations;
-    };
-    static const QVector<CategoryFormations> categories = {
-        { "Still Lifes",
-          {
-              { "Block", { {0,0}, {1,0}, {0,1}, {1,1} } },
-              { "Beehive", { {1,0}, {2,0}, {0,1}, {3,1}, {1,2}, {2,2} } },
-          }
-        },
-        { "Oscillators",
-          {
-              { "Blinker", { {0,0}, {1,0}, {2,0} } },
-              { "Beacon", { {0,0}, {0,1}, {1,0}, {3,2}, {2,3}, {3,3} } },
-              { "Toad", { {1,0}, {2,0}, {0,1}, {3,2}, {1,3}, {2,3} } },
-              { "Clock", { {2,0}, {0,1}, {2,1}, {1,2}, {3,2}, {1,3} } },
-          }
-        },
-        { "Spaceships",
-          {
-              { "Glider", { {3,1}, {1,1}, {3,2}, {2,3}, {3,3} } },
-          }
-        },
-        { "Glider Guns",
-          {
-              { "Gosper Glider Gun", {
-                    {23,1},
-                    {22,2}, {24,2},
-                    {12,3}, {13,3}, {21,3}, {23,3}, {24,3}, {35,3}, {36,3},
-                    {11,4}, {13,4}, {20,4}, {21,4}, {23,4}, {24,4}, {35,4}, {36,4},
-                    {1,5}, {2,5}, {10,5}, {17,5}, {18,5}, {19,5}, {21,5}, {23,5}, {24,5},
-                    {1,6}, {2,6}, {10,6}, {13,6}, {16,6}, {19,6}, {22,6}, {24,6},
-                    {10,7}, {17,7}, {18,7}, {23,7},
-                    {11,8}, {13,8},
-                    {12,9}, {13,9},
-                }
-              },
-          }
-        },
-    };
-
+    const QVector<LifeEngine::CategoryFormations> &categories(LifeEngine::formationCategories());
     QMenu menu;
     for (int i = 0; i < categories.length(); i++)
     {
         QMenu *subMenu = menu.addMenu(categories[i].title);
-        const QVector<Formation> &formations(categories[i].formations);
+        const QVector<LifeEngine::Formation> &formations(categories[i].formations);
         for (int j = 0; j < formations.length(); j++)
         {
             QAction *action = subMenu->addAction(formations[j].name);
@@ -640,27 +890,19 @@ void MainWindow::createOrClearBoard(Board &board)
         return;
     QPoint point = selectedAction->data().toPoint();
     int i(point.x()), j(point.y());
-    const Formation &formation(categories[i].formations[j]);
+    const LifeEngine::Formation &formation(categories[i].formations[j]);
 
-    Board &board(*curBoard);
+    QMutexLocker locker(&simulation.engineMutex());
+    engine.placeFormation(formation, boardPos.y(), boardPos.x());
     for (const QPoint &delta : formation.deltas)
-    {
-        QPoint boardPos2(boardPos.x() + delta.x(), boardPos.y() + delta.y());
-        if (!boardPosIsValid(boardPos2))
-            continue;
-        Cell &cell(BOARDCELL_SQUARE(board, boardPos2.y(), boardPos2.x()));
-        cell.occupied = true;
-#if COUNTER_COLOURS
-        cell.age = 0;
-#endif
-        showCounterForBoardPos(boardPos2);
-    }
+        showCounterForBoardPos(boardPos + delta);
 }
 
 /*slot*/ void MainWindow::speedSliderChange(int value)
 {
     // alter the timer timeout to correspond to the slider position
     timer.setInterval(speedSlider->maximum() - value);
+    simulation.setStepDelay(timer.interval());
 }
 
 /*slot*/ void MainWindow::actionFastest()
@@ -669,11 +911,112 @@ void MainWindow::createOrClearBoard(Board &board)
     ui->actionDisplay->setChecked(false);
 }
 
+/*slot*/ void MainWindow::actionCustomRule()
+{
+    // ask for a rule in B/S notation
+    bool ok;
+    QString text = QInputDialog::getText(this, "Custom Rule", "Rule (B/S notation, e.g. B36/S23):", QLineEdit::Normal,
+                                         engine.rule().toString(), &ok);
+    LifeRule rule(engine.rule());
+    if (ok && !LifeRule::parse(text, rule))
+        QMessageBox::warning(this, "Custom Rule", QString("\"%1\" is not a valid rule (or gives birth at 0 neighbours)").arg(text));
+    // (re-setting an unchanged rule puts the check mark back on its menu item)
+    setRule(rule);
+}
+
+/*slot*/ void MainWindow::actionBenchmarkPartitioning()
+{
+    // time each way of partitioning the board between threads, for each thread count from 1 up to the "Thread Count" setting
+    // each run uses the worker pool (so there is no thread creation overhead), on a freshly randomized board
+    // whatever the settings, the whole board is generated with nothing tracked, so that only the partition mode differs between runs
+    // (active regions & tracking changed tiles generate tile by tile, and the NUMA-local pool in bands, whatever the partition mode,
+    // and tracking statistics narrows each generation to the live cells' bounds)
+    static constexpr int warmupGenerations = 10;
+    static constexpr int benchmarkGenerations = 100;
+    static const QVector<LifeEngine::PartitionMode> modes = { LifeEngine::PartitionInterleaved, LifeEngine::PartitionBanded, LifeEngine::PartitionTiled };
+
+    actionPause();
+    if (engine.backend() != LifeEngine::BackendBoard)
+    {
+        qDebug().noquote() << "Partitioning benchmark: only applies to the board (not HashLife or the unbounded universe)";
+        return;
+    }
+    LifeEngine::PartitionMode savedMode = partitionMode();
+    engine.setThreadMode(LifeEngine::ThreadsWorkerPool);
+    engine.setActiveRegionsOnly(false);
+    engine.setTrackChangedTiles(false);
+    engine.setTrackStatistics(false);
+    qDebug().noquote() << QString("Partitioning benchmark: %1 generations per run (generations/sec)").arg(benchmarkGenerations);
+    QString header("Threads");
+    for (LifeEngine::PartitionMode mode : modes)
+        header += QString("%1").arg(LifeEngine::partitionModeName(mode), 13);
+    qDebug().noquote() << header;
+    for (int threadCount = 1; threadCount <= useThreadCount(); threadCount++)
+    {
+        QString line(QString("%1").arg(threadCount, 7));
+        for (LifeEngine::PartitionMode mode : modes)
+        {
+            setPartitionMode(mode);
+            actionRandomize();
+            engine.runGenerationsInWorkerPool(threadCount, warmupGenerations);
+            QElapsedTimer et;
+            et.start();
+            engine.runGenerationsInWorkerPool(threadCount, benchmarkGenerations);
+            qint64 elapsedNsecs = qMax(et.nsecsElapsed(), qint64(1));
+            line += QString("%1").arg(benchmarkGenerations * 1000000000LL / elapsedNsecs, 13);
+        }
+        qDebug().noquote() << line;
+    }
+    setPartitionMode(savedMode);
+    updateEngineThreadMode();
+    engine.setActiveRegionsOnly(ui->actionTrackActiveRegions->isChecked());
+    engine.setTrackChangedTiles(runDisplay());
+    updateEngineTrackStatistics();
+    showWholeBoard();
+    showTitle();
+}
+
 /*slot*/ void MainWindow::timerTimeout()
 {
     // produce the next generation on `this->timer` timeout
+    // when running the board without display in the worker pool (or temporally blocked),
+    // produce a batch of generations without returning to the event loop
+    // then pause if the board has stabilised, when set to
+    if (isRunning && !runDisplay() && engine.backend() == LifeEngine::BackendBoard
+            && (engine.threadMode() == LifeEngine::ThreadsWorkerPool || engine.threadMode() == LifeEngine::ThreadsNumaWorkerPool
+                || engine.temporalBlockingApplies()))
+    {
+        engine.runSteps(workerPoolBatchGenerations);
+        showGeneration();
+    }
+    else
+    {
 //    for (int i = 0; i < 10; i++)
         actionStep();
+    }
+    if (boardStabilised())
+        actionPause();
+}
+
+/*slot*/ void MainWindow::frameTimerTimeout()
+{
+    // show the latest snapshot from the simulation thread (if there is a new one) on `this->frameTimer` timeout
+    // and let the simulation thread know what is now in view, for its next snapshot
+    // (and pause if the board has stabilised, when set to)
+    if (boardStabilised())
+    {
+        actionPause();
+        return;
+    }
+    updateSimulationRegion();
+    if (!simulation.acquireSnapshot())
+        return;
+    updateSceneRect();
+    showTitle();
+    if (runDisplay())
+        showWholeBoard();
+    else
+        screenBoardNeedsRefresh = true;
 }
 
 
@@ -719,6 +1062,18 @@ LifeGraphicsScene::LifeGraphicsScene(MainWindow *mainWindow, QWidget *parent /*=
 {
     Q_ASSERT(mainWindow);
     this->mainWindow = mainWindow;
+    this->metrics = &mainWindow->lifeMetrics();
+}
+
+/*static*/ int LifeGraphicsScene::cellsPerPixelForScale(qreal pixelsPerCell)
+{
+    // return how many cells across each pixel of a rendered image should cover, when a cell is `pixelsPerCell` screen pixels across
+    // (level of detail: when there is less than a screen pixel per cell, each image pixel covers a (power of 2) square of cells,
+    // so that the image is never larger than the screen area it covers)
+    int cellsPerPixel = 1;
+    while (cellsPerPixel * pixelsPerCell < 1 && cellsPerPixel < (1 << 20))
+        cellsPerPixel *= 2;
+    return cellsPerPixel;
 }
 
 /*virtual*/ void LifeGraphicsScene::contextMenuEvent(QGraphicsSceneContextMenuEvent *contextMenuEvent) /*override*/
@@ -741,31 +1096,90 @@ LifeGraphicsScene::LifeGraphicsScene(MainWindow *mainWindow, QWidget *parent /*=
     // call the base method
     QGraphicsScene::drawForeground(painter, rect);
 
+    // draw the cells, timing it for the metrics
+    QElapsedTimer et;
+    et.start();
+    drawCells(painter, rect);
+    metrics->recordTiming(LifeMetrics::TimingRender, et.nsecsElapsed());
+}
+
+void LifeGraphicsScene::drawCells(QPainter *painter, const QRectF &rect)
+{
     // draw that part of the scene which lies in `rect`
-    const MainWindow::Board &board(*mainWindow->curBoard);
-    int yStart = 0, yEnd = BOARD_COUNT(board) - 1;
-    int xStart = 0, xEnd = BOARDROW_COUNT(BOARDROW_AT(board, 0)) - 1;
-    if (!rect.isEmpty())
+    QRectF drawRect(rect.isEmpty() ? sceneRect() : rect);
+    QPoint boardTopLeft(mainWindow->scenePosToBoardPos(drawRect.topLeft()));
+    QPoint boardBottomRight(mainWindow->scenePosToBoardPos(drawRect.bottomRight()));
+    painter->setClipRect(drawRect);
+    qreal pixelsPerCell = cellSize * painter->worldTransform().m11();
+
+    // while running in the simulation thread, draw its latest snapshot
+    if (const LifeSnapshot *snapshot = mainWindow->runningSnapshot())
     {
-        Q_ASSERT(rect.width() >= 0 && rect.height() >= 0);
-        QPoint boardTopLeft(mainWindow->scenePosToBoardPos(rect.topLeft()));
-        QPoint boardBottomRight(mainWindow->scenePosToBoardPos(rect.bottomRight()));
-        yStart = qMax(yStart, boardTopLeft.y());
-        yEnd = qMin(yEnd, boardBottomRight.y());
-        xStart = qMax(xStart, boardTopLeft.x());
-        xEnd = qMin(xEnd, boardBottomRight.x());
+        drawSnapshot(painter, *snapshot, pixelsPerCell);
+        return;
     }
-    painter->setClipRect(rect);
-    for (int y = yStart; y <= yEnd; y++)
-        for (int x = xStart; x <= xEnd; x++)
-        {
-            const MainWindow::Cell &cell(BOARDCELL_AT(board, y, x));
-            if (!cell.occupied)
-                continue;
+    const LifeEngine &engine(mainWindow->lifeEngine());
+
+    // when zoomed in far enough, draw each counter as an ellipse
+    if (pixelsPerCell >= ellipseMinPixelsPerCell)
+    {
+        engine.forEachLiveCell(boardTopLeft.y(), boardTopLeft.x(),
+                               boardBottomRight.y() - boardTopLeft.y() + 1, boardBottomRight.x() - boardTopLeft.x() + 1,
+                               [&](int y, int x, const MainWindow::Cell &cell)->void {
             QPoint boardPos(x, y);
             QPointF scenePos(mainWindow->boardPosToScenePos(boardPos));
             QRectF rectCounter(scenePos, QSize(counterSize, counterSize));
             painter->setBrush(mainWindow->colourForCounter(cell));
             painter->drawEllipse(rectCounter);
+        });
+        return;
+    }
+
+    // otherwise render the cells into an image, one pixel per cell (or fewer, see `cellsPerPixelForScale()`), and draw that scaled up
+    int cellsPerPixel = cellsPerPixelForScale(pixelsPerCell);
+    // align to whole image pixels, so that each pixel covers the same cells wherever the view is scrolled to
+    int top = boardTopLeft.y() - (((boardTopLeft.y() % cellsPerPixel) + cellsPerPixel) % cellsPerPixel);
+    int left = boardTopLeft.x() - (((boardTopLeft.x() % cellsPerPixel) + cellsPerPixel) % cellsPerPixel);
+    int rows = boardBottomRight.y() - top + 1, columns = boardBottomRight.x() - left + 1;
+    QSize imageSize((columns + cellsPerPixel - 1) / cellsPerPixel, (rows + cellsPerPixel - 1) / cellsPerPixel);
+    if (rasterImage.size() != imageSize)
+        rasterImage = QImage(imageSize, QImage::Format_Indexed8);
+    rasterImage.setColorTable(mainWindow->rasterColourTable());
+    engine.rasterize(top, left, rows, columns, cellsPerPixel, rasterImage.bits(), rasterImage.bytesPerLine());
+    drawRaster(painter, rasterImage, top, left, cellsPerPixel);
+}
+
+void LifeGraphicsScene::drawRaster(QPainter *painter, const QImage &image, int top, int left, int cellsPerPixel)
+{
+    // draw an image rendered by `LifeEngine::rasterize()` over the cells it covers, with (top, left) its top-left board position
+    QRectF targetRect(mainWindow->boardPosToScenePos(QPoint(left, top)),
+                      QSizeF(image.width() * cellsPerPixel * cellSize, image.height() * cellsPerPixel * cellSize));
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter->drawImage(targetRect, image);
+}
+
+void LifeGraphicsScene::drawSnapshot(QPainter *painter, const LifeSnapshot &snapshot, qreal pixelsPerCell)
+{
+    // draw a snapshot from the simulation thread, as ellipses if it is one pixel per cell and zoomed in far enough, else as an image
+    if (snapshot.pixels.isEmpty())
+        return;
+    const QVector<QRgb> colourTable(mainWindow->rasterColourTable());
+    if (pixelsPerCell >= ellipseMinPixelsPerCell && snapshot.cellsPerPixel == 1)
+    {
+        for (int y = 0; y < snapshot.pixelRows; y++)
+        {
+            const quint8 *line = snapshot.pixels.constData() + y * snapshot.bytesPerLine;
+            for (int x = 0; x < snapshot.pixelColumns; x++)
+                if (line[x] != 0)
+                {
+                    QPointF scenePos(mainWindow->boardPosToScenePos(QPoint(snapshot.left + x, snapshot.top + y)));
+                    painter->setBrush(QColor(colourTable[line[x]]));
+                    painter->drawEllipse(QRectF(scenePos, QSize(counterSize, counterSize)));
+                }
         }
+        return;
+    }
+    QImage image(snapshot.pixels.constData(), snapshot.pixelColumns, snapshot.pixelRows, snapshot.bytesPerLine, QImage::Format_Indexed8);
+    image.setColorTable(colourTable);
+    drawRaster(painter, image, snapshot.top, snapshot.left, snapshot.cellsPerPixel);
 }
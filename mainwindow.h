@@ -4,11 +4,16 @@
 #include <QElapsedTimer>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QImage>
 #include <QMainWindow>
+#include <QMenu>
 #include <QSlider>
 #include <QSpinBox>
 #include <QTimer>
-#include <QVector>
+
+#include "lifeengine.h"
+#include "lifemetricsdock.h"
+#include "lifesimulation.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -19,88 +24,84 @@ class LifeGraphicsView;
 class LifeCounter;
 
 
-// compile-time support for using C-style arrays for the board, rather than Qt `QVector`s
-#define BOARD_C_ARRAYS 1
-
-// compile-time support for counter colours, or not
-#define COUNTER_COLOURS 0
-
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    struct Cell {
-        bool occupied = false;
-#if COUNTER_COLOURS
-        int age = 0;
-#endif
-    };
-
-#if BOARD_C_ARRAYS
-    typedef Cell *BoardRow;
-    typedef BoardRow *Board;
-    #define BOARD_COUNT(board) (board ? MainWindow::boardSize : 0)
-    #define BOARDROW_COUNT(boardrow) (boardrow ? MainWindow::boardSize : 0)
-    #define BOARDCELL_AT(board, y, x) board[y][x]
-    #define BOARDCELL_SQUARE(board, y, x) board[y][x]
-    #define BOARDROW_AT(board, y) board[y]
-#else
-    typedef QVector<Cell> BoardRow;
-    typedef QVector<BoardRow> Board;
-    #define BOARD_COUNT(board) board.count()
-    #define BOARDROW_COUNT(boardrow) boardrow.count()
-    #define BOARDCELL_AT(board, y, x) board.at(y).at(x)
-    #define BOARDCELL_SQUARE(board, y, x) board[y][x]
-    #define BOARDROW_AT(board, y) board.at(y)
-#endif
-
-    static constexpr int boardSize = 1000;
-
-    Board *curBoard;
+    typedef LifeEngine::Cell Cell;
+    // number of steps run per timer timeout when running without display in the worker pool (or temporally blocked)
+    static constexpr int workerPoolBatchGenerations = 100;
 
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    const LifeEngine &lifeEngine() const { return engine; }
+    LifeMetrics &lifeMetrics() { return engine.metrics(); }
+    const LifeSnapshot *runningSnapshot() const;
+
     QPoint scenePosToBoardPos(const QPointF &scenePos) const;
     QPointF boardPosToScenePos(const QPoint &boardPos) const;
     Qt::GlobalColor colourForCounter(const Cell &cell) const;
+    QVector<QRgb> rasterColourTable() const;
 
 private:
     Ui::MainWindow *ui;
     QSlider *speedSlider;
     QSpinBox *threadCountSpinBox;
+    QSpinBox *hashLifeStepSpinBox, *hashLifeMemoryLimitSpinBox;
     LifeGraphicsScene *graphicsScene;
     LifeGraphicsView *graphicsView;
+    LifeMetricsDock *metricsDock;
     QTimer timer;
-    Board board0, board1;
-    Board *nextBoard;
+    LifeEngine engine;
+    LifeSimulation simulation;
+    // while running in the simulation thread, shows its latest snapshot at display refresh rate
+    QTimer frameTimer;
     QString titlePrefix;
-    int generationNumber;
     bool isRunning, screenBoardNeedsRefresh;
     struct {
         QElapsedTimer elapsedTimer;
-        int startGeneration;
+        qint64 startGeneration;
     } runStatistics;
 
     bool showColours() const;
     bool useThreads() const;
     int useThreadCount() const;
     bool useQtConcurrent() const;
+    bool useWorkerPool() const;
+    bool useNumaWorkerPool() const;
+    bool useHashLife() const;
+    bool useUnboundedUniverse() const;
+    bool useSimulationThread() const;
+    LifeEngine::PartitionMode partitionMode() const;
+    void setPartitionMode(LifeEngine::PartitionMode mode);
+    void updateEngineThreadMode();
+    void updateEngineBackend();
+    void updateEngineTrackStatistics();
+    bool boardStabilised();
+    void setRule(const LifeRule &rule);
     bool runDisplay() const;
     bool boardPosIsValid(const QPoint &boardPos) const;
     void showCounterForBoardPos(const QPoint &boardPos);
-    int countNeighbours(int y, int x) const;
-    void stepPass1(bool multiThread = false, int startRow = 0, int incRow =1);
     void showWholeBoard();
+    void showChangedRegions();
     void showTitle();
-    void stepPass2();
-    void createOrClearBoard(Board &board);
+    void showGeneration();
+    void updateSimulationRegion();
+    QRectF boardSceneRect() const;
+    void updateSceneRect();
+    QSpinBox *replaceMenuActionBySpinBox(QMenu *menu, QAction *&action, const QString &label);
 
 private slots:
     void newBoard();
     void menuSpeedAboutToBeShown();
     void actionRandomize();
+    void actionOpenPattern();
+    void actionSavePattern();
+    void actionSaveCheckpoint();
+    void actionRestoreCheckpoint();
+    void actionRecordHistory(bool checked);
     void actionRun();
     void actionPause();
     void actionStep();
@@ -109,7 +110,10 @@ private slots:
     void sceneContextMenuClick(const QPointF scenePos, const QPoint screenPos);
     void speedSliderChange(int value);
     void actionFastest();
+    void actionCustomRule();
+    void actionBenchmarkPartitioning();
     void timerTimeout();
+    void frameTimerTimeout();
 };
 
 
@@ -131,10 +135,21 @@ class LifeGraphicsScene : public QGraphicsScene
 public:
     static constexpr int counterSize = 20;
     static constexpr int cellSize = 25;
+    // counters are drawn as ellipses when a cell is at least this many screen pixels across, else as an image
+    static constexpr qreal ellipseMinPixelsPerCell = 6;
     LifeGraphicsScene(MainWindow *mainWindow, QWidget *parent = nullptr);
 
+    static int cellsPerPixelForScale(qreal pixelsPerCell);
+
 private:
     const MainWindow *mainWindow;
+    // where the time taken to draw is counted
+    LifeMetrics *metrics;
+    QImage rasterImage;
+
+    void drawCells(QPainter *painter, const QRectF &rect);
+    void drawRaster(QPainter *painter, const QImage &image, int top, int left, int cellsPerPixel);
+    void drawSnapshot(QPainter *painter, const LifeSnapshot &snapshot, qreal pixelsPerCell);
 
 protected:
     virtual void contextMenuEvent(QGraphicsSceneContextMenuEvent *contextMenuEvent) override;
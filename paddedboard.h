@@ -0,0 +1,108 @@
+#ifndef PADDEDBOARD_H
+#define PADDEDBOARD_H
+
+#include <new>
+#include <type_traits>
+
+#include <QtGlobal>
+
+// a board of cells held in a single, cache-line aligned, contiguous allocation
+// the board is surrounded by a one-cell "ghost" border, so that `board[y][x]` may be read at
+// y = -1 and y = rowCount(), and x = -1 and x = columnCount(), without any bounds checks
+// the first cell of every row starts a cache line (the ghost cell before it ends the line before)
+// `fillBorder()` fills the ghost border, either with empty cells (dead edges) or with copies of the opposite edges (wrap around)
+template <typename T>
+class PaddedBoard
+{
+    static_assert(std::is_trivially_destructible<T>::value, "PaddedBoard cells must be trivially destructible");
+
+public:
+    PaddedBoard()
+    {
+        this->cells = nullptr;
+        this->rows = this->columns = this->stride = 0;
+    }
+    ~PaddedBoard()
+    {
+        if (cells != nullptr)
+            qFreeAligned(cells);
+        cells = nullptr;
+    }
+    PaddedBoard(const PaddedBoard &) = delete;
+    PaddedBoard &operator=(const PaddedBoard &) = delete;
+
+    void resize(int rows, int columns, bool constructCells = true)
+    {
+        // (re-)allocate the board for `rows` x `columns` cells, plus the ghost border
+        // if not `constructCells`, a new allocation is left untouched (so its memory is not yet placed), for `fillRows()` to fill
+        Q_ASSERT(rows >= 0 && columns >= 0);
+        if (cells != nullptr && rows == this->rows && columns == this->columns)
+            return;
+        if (cells != nullptr)
+            qFreeAligned(cells);
+        this->rows = rows;
+        this->columns = columns;
+        // a ghost cell at either end of each row, the one before it at the end of a whole cache line of its own,
+        // so that each row starts a cache line, with each row a whole number of cache lines
+        this->stride = ((cellsPerCacheLine + columns + 1 + cellsPerCacheLine - 1) / cellsPerCacheLine) * cellsPerCacheLine;
+        cells = static_cast<T *>(qMallocAligned(size_t(rows + 2) * stride * sizeof(T), cacheLineSize));
+        if (constructCells)
+            for (size_t i = 0; i < size_t(rows + 2) * stride; i++)
+                new (&cells[i]) T();
+    }
+
+    void fill(const T &value)
+    {
+        // set every cell, including the ghost border, to `value`
+        for (size_t i = 0; i < size_t(rows + 2) * stride; i++)
+            cells[i] = value;
+    }
+
+    void fillRows(int yStart, int yEnd, const T &value)
+    {
+        // set every cell of rows `yStart` to `yEnd - 1` to `value`, including their ghost cells,
+        // and the ghost row above or below the board if the rows start or end it
+        // (the cells are constructed afresh, so this may fill a new allocation left unconstructed by `resize()`)
+        Q_ASSERT(yStart >= 0 && yStart <= yEnd && yEnd <= rows);
+        if (cells == nullptr || yStart == yEnd)
+            return;
+        int first = yStart == 0 ? -1 : yStart, last = yEnd == rows ? rows : yEnd - 1;
+        for (size_t i = size_t(first + 1) * stride; i < size_t(last + 2) * stride; i++)
+            new (&cells[i]) T(value);
+    }
+
+    void fillBorder(bool wrap)
+    {
+        // fill the ghost border: empty cells for dead edges, or copies of the opposite edges to wrap around
+        if (rows == 0 || columns == 0)
+            return;
+        for (int y = 0; y < rows; y++)
+        {
+            T *row = (*this)[y];
+            row[-1] = wrap ? row[columns - 1] : T();
+            row[columns] = wrap ? row[0] : T();
+        }
+        // the ghost rows include the corners, which the above has already filled at either end of the edge rows
+        T *above = (*this)[-1], *below = (*this)[rows];
+        const T *first = (*this)[0], *last = (*this)[rows - 1];
+        for (int x = -1; x <= columns; x++)
+        {
+            above[x] = wrap ? last[x] : T();
+            below[x] = wrap ? first[x] : T();
+        }
+    }
+
+    int rowCount() const { return rows; }
+    int columnCount() const { return columns; }
+
+    T *operator[](int y) { return cells + ((y + 1) * stride) + cellsPerCacheLine; }
+    const T *operator[](int y) const { return cells + ((y + 1) * stride) + cellsPerCacheLine; }
+
+private:
+    static constexpr int cacheLineSize = 64;
+    static constexpr int cellsPerCacheLine = sizeof(T) >= cacheLineSize ? 1 : cacheLineSize / sizeof(T);
+    T *cells;
+    int rows, columns, stride;
+};
+
+#endif // PADDEDBOARD_H
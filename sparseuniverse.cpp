@@ -0,0 +1,201 @@
+#include <limits>
+
+#include <QSet>
+#include <QtAlgorithms>
+
+#include "sparseuniverse.h"
+
+
+////////// SparseUniverse Class //////////
+
+SparseUniverse::SparseUniverse()
+{
+}
+
+void SparseUniverse::clear()
+{
+    // clear all cells, reclaiming all chunks
+    chunks.clear();
+}
+
+/*static*/ bool SparseUniverse::chunkIsEmpty(const Chunk &chunk)
+{
+    // return whether a chunk has no occupied cells
+    Word any = 0;
+    for (int y = 0; y < chunkSize; y++)
+        any |= chunk.rows[y];
+    return any == 0;
+}
+
+const SparseUniverse::Chunk *SparseUniverse::chunkAt(qint64 chunkY, qint64 chunkX) const
+{
+    // return the chunk at chunk coordinates (chunkY, chunkX), or `nullptr` if it is not allocated (empty)
+    auto it = chunks.constFind(chunkKey(chunkY, chunkX));
+    return it != chunks.constEnd() ? &it.value() : nullptr;
+}
+
+bool SparseUniverse::cellAt(qint64 y, qint64 x) const
+{
+    // return whether a cell is occupied
+    const Chunk *chunk = chunkAt(chunkOf(y), chunkOf(x));
+    if (chunk == nullptr)
+        return false;
+    return (chunk->rows[offsetInChunk(y)] >> offsetInChunk(x)) & 1;
+}
+
+void SparseUniverse::setCellAt(qint64 y, qint64 x, bool occupied)
+{
+    // set whether a cell is occupied, allocating its chunk if need be, and reclaiming it if it becomes empty
+    quint64 key = chunkKey(chunkOf(y), chunkOf(x));
+    auto it = chunks.find(key);
+    if (it == chunks.end())
+    {
+        if (!occupied)
+            return;
+        it = chunks.insert(key, Chunk{});
+    }
+    Word &word(it.value().rows[offsetInChunk(y)]);
+    Word bit = Word(1) << offsetInChunk(x);
+    word = occupied ? (word | bit) : (word & ~bit);
+    if (!occupied && chunkIsEmpty(it.value()))
+        chunks.erase(it);
+}
+
+void SparseUniverse::forEachLiveCell(qint64 top, qint64 left, qint64 rows, qint64 columns,
+                                     const std::function<void(qint64 y, qint64 x)> &callback) const
+{
+    // call `callback(y, x)` for each occupied cell within the `rows` x `columns` cells whose top-left cell is at (top, left)
+    if (rows <= 0 || columns <= 0)
+        return;
+    qint64 bottom = top + rows, right = left + columns;
+    // visit whichever is fewer: the chunks overlapping the area, or all the chunks
+    qint64 areaChunks = (chunkOf(bottom - 1) - chunkOf(top) + 1) * (chunkOf(right - 1) - chunkOf(left) + 1);
+    auto visitChunk = [&](qint64 chunkY, qint64 chunkX, const Chunk &chunk)->void {
+        for (int y = 0; y < chunkSize; y++)
+        {
+            qint64 cellY = (chunkY << chunkSizeLog2) + y;
+            if (cellY < top || cellY >= bottom)
+                continue;
+            for (Word word = chunk.rows[y]; word != 0; word &= word - 1)
+            {
+                qint64 cellX = (chunkX << chunkSizeLog2) + qCountTrailingZeroBits(word);
+                if (cellX >= left && cellX < right)
+                    callback(cellY, cellX);
+            }
+        }
+    };
+    if (areaChunks < chunks.count())
+    {
+        for (qint64 chunkY = chunkOf(top); chunkY <= chunkOf(bottom - 1); chunkY++)
+            for (qint64 chunkX = chunkOf(left); chunkX <= chunkOf(right - 1); chunkX++)
+                if (const Chunk *chunk = chunkAt(chunkY, chunkX))
+                    visitChunk(chunkY, chunkX, *chunk);
+    }
+    else
+    {
+        for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it)
+            visitChunk(chunkYOfKey(it.key()), chunkXOfKey(it.key()), it.value());
+    }
+}
+
+void SparseUniverse::step()
+{
+    // generate the next generation
+    // only allocated chunks, and those neighbours which an allocated chunk's edge cells could spill into, are generated,
+    // and any chunk which comes out empty is not kept
+    QSet<quint64> candidates;
+    candidates.reserve(chunks.count() * 2);
+    for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it)
+    {
+        const Chunk &chunk(it.value());
+        qint64 chunkY = chunkYOfKey(it.key()), chunkX = chunkXOfKey(it.key());
+        Word any = 0;
+        for (int y = 0; y < chunkSize; y++)
+            any |= chunk.rows[y];
+        const Word first = chunk.rows[0], last = chunk.rows[chunkSize - 1];
+        const Word westBit = 1, eastBit = Word(1) << (chunkSize - 1);
+        candidates.insert(it.key());
+        if (first != 0)
+            candidates.insert(chunkKey(chunkY - 1, chunkX));
+        if (last != 0)
+            candidates.insert(chunkKey(chunkY + 1, chunkX));
+        if (any & westBit)
+            candidates.insert(chunkKey(chunkY, chunkX - 1));
+        if (any & eastBit)
+            candidates.insert(chunkKey(chunkY, chunkX + 1));
+        if (first & westBit)
+            candidates.insert(chunkKey(chunkY - 1, chunkX - 1));
+        if (first & eastBit)
+            candidates.insert(chunkKey(chunkY - 1, chunkX + 1));
+        if (last & westBit)
+            candidates.insert(chunkKey(chunkY + 1, chunkX - 1));
+        if (last & eastBit)
+            candidates.insert(chunkKey(chunkY + 1, chunkX + 1));
+    }
+
+    QHash<quint64, Chunk> newChunks;
+    newChunks.reserve(candidates.count());
+    // each chunk is generated from a grid of its rows plus one row above & below, each with its west & east neighbouring words
+    constexpr int gridStride = 3;
+    Word grid[(chunkSize + 2) * gridStride];
+    for (quint64 key : candidates)
+    {
+        qint64 chunkY = chunkYOfKey(key), chunkX = chunkXOfKey(key);
+        const Chunk *neighbours[3][3];
+        for (int dy = 0; dy < 3; dy++)
+            for (int dx = 0; dx < 3; dx++)
+                neighbours[dy][dx] = chunkAt(chunkY + dy - 1, chunkX + dx - 1);
+        for (int gridY = 0; gridY < chunkSize + 2; gridY++)
+        {
+            // grid row 0 is the last row of the chunks above, and the last grid row is the first row of the chunks below
+            int dy = gridY == 0 ? 0 : gridY == chunkSize + 1 ? 2 : 1;
+            int y = gridY == 0 ? chunkSize - 1 : gridY == chunkSize + 1 ? 0 : gridY - 1;
+            for (int dx = 0; dx < 3; dx++)
+                grid[(gridY * gridStride) + dx] = neighbours[dy][dx] != nullptr ? neighbours[dy][dx]->rows[y] : 0;
+        }
+        Chunk newChunk;
+        BitBoard::stepColumn(grid, gridStride, chunkSize, newChunk.rows, currentRule);
+        if (!chunkIsEmpty(newChunk))
+            newChunks.insert(key, newChunk);
+    }
+    chunks.swap(newChunks);
+}
+
+quint64 SparseUniverse::population() const
+{
+    // return the number of occupied cells
+    quint64 population = 0;
+    for (const Chunk &chunk : chunks)
+        for (int y = 0; y < chunkSize; y++)
+            population += qPopulationCount(chunk.rows[y]);
+    return population;
+}
+
+size_t SparseUniverse::memoryUsage() const
+{
+    // return (roughly) the memory used by the chunks
+    return size_t(chunks.capacity()) * sizeof(void *) + size_t(chunks.count()) * (sizeof(Chunk) + sizeof(quint64) + 2 * sizeof(void *));
+}
+
+bool SparseUniverse::boundingRect(qint64 &top, qint64 &left, qint64 &bottom, qint64 &right) const
+{
+    // set `top`, `left` and (exclusive) `bottom`, `right` to the bounds of the allocated chunks, in cells
+    // return false if there are no occupied cells
+    if (chunks.isEmpty())
+        return false;
+    qint64 minChunkY = std::numeric_limits<qint64>::max(), minChunkX = minChunkY;
+    qint64 maxChunkY = std::numeric_limits<qint64>::min(), maxChunkX = maxChunkY;
+    for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it)
+    {
+        qint64 chunkY = chunkYOfKey(it.key()), chunkX = chunkXOfKey(it.key());
+        minChunkY = qMin(minChunkY, chunkY);
+        maxChunkY = qMax(maxChunkY, chunkY);
+        minChunkX = qMin(minChunkX, chunkX);
+        maxChunkX = qMax(maxChunkX, chunkX);
+    }
+    top = minChunkY << chunkSizeLog2;
+    left = minChunkX << chunkSizeLog2;
+    bottom = (maxChunkY + 1) << chunkSizeLog2;
+    right = (maxChunkX + 1) << chunkSizeLog2;
+    return true;
+}
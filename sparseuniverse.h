@@ -0,0 +1,60 @@
+#ifndef SPARSEUNIVERSE_H
+#define SPARSEUNIVERSE_H
+
+#include <functional>
+
+#include <QHash>
+
+#include "bitboard.h"
+
+// an unbounded universe, held as 64 x 64 cell chunks which are only allocated where there are occupied cells
+// chunks are keyed by their chunk coordinates (cell coordinates divided by 64, rounded down), and are bit-packed one word per row,
+// bit `i` of a chunk row holding the cell at column `(chunkX * 64) + i`
+// a chunk which becomes empty is reclaimed, so memory grows with the population and not with the area
+// cell coordinates may be anywhere within +/-2^37 (chunk coordinates are 32-bit)
+class SparseUniverse
+{
+public:
+    typedef BitBoard::Word Word;
+    static constexpr int chunkSizeLog2 = 6;
+    static constexpr int chunkSize = 1 << chunkSizeLog2;
+    static_assert(chunkSize == BitBoard::bitsPerWord, "a chunk row must be one word");
+
+    SparseUniverse();
+
+    void clear();
+    const LifeRule &rule() const { return currentRule; }
+    void setRule(const LifeRule &rule) { currentRule = rule; }
+    bool cellAt(qint64 y, qint64 x) const;
+    void setCellAt(qint64 y, qint64 x, bool occupied);
+    void forEachLiveCell(qint64 top, qint64 left, qint64 rows, qint64 columns, const std::function<void(qint64 y, qint64 x)> &callback) const;
+
+    void step();
+    quint64 population() const;
+    int chunkCount() const { return chunks.count(); }
+    size_t memoryUsage() const;
+    bool boundingRect(qint64 &top, qint64 &left, qint64 &bottom, qint64 &right) const;
+
+private:
+    struct Chunk {
+        Word rows[chunkSize];
+    };
+
+    QHash<quint64, Chunk> chunks;
+    LifeRule currentRule;
+
+    static quint64 chunkKey(qint64 chunkY, qint64 chunkX)
+    {
+        return (quint64(quint32(qint32(chunkY))) << 32) | quint32(qint32(chunkX));
+    }
+    static qint64 chunkYOfKey(quint64 key) { return qint32(quint32(key >> 32)); }
+    static qint64 chunkXOfKey(quint64 key) { return qint32(quint32(key)); }
+    // cell coordinate -> chunk coordinate, rounding down for negative coordinates too
+    static qint64 chunkOf(qint64 cell) { return cell >> chunkSizeLog2; }
+    static int offsetInChunk(qint64 cell) { return int(cell & (chunkSize - 1)); }
+
+    static bool chunkIsEmpty(const Chunk &chunk);
+    const Chunk *chunkAt(qint64 chunkY, qint64 chunkX) const;
+};
+
+#endif // SPARSEUNIVERSE_H